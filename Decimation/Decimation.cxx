@@ -1,140 +1,746 @@
 #include "DecimationCLP.h"
 
 // VTK Includes
+#include "vtkAlgorithm.h"
+#include "vtkCallbackCommand.h"
+#include "vtkCommand.h"
 #include "vtkDecimatePro.h"
 #include "vtkNew.h"
 #include "vtkOBJReader.h"
 #include "vtkOBJWriter.h"
+#include "vtkPLYReader.h"
+#include "vtkPLYWriter.h"
 #include "vtkPolyData.h"
 #include "vtkQuadricDecimation.h"
 #include "vtkSmartPointer.h"
+#include "vtkSTLReader.h"
+#include "vtkSTLWriter.h"
 #include "vtkTriangleFilter.h"
 #include "vtkXMLPolyDataWriter.h"
 #include "vtkXMLPolyDataReader.h"
+#include <vtksys/Directory.hxx>
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string.h>
+#include <thread>
+
 #include "Simplify.h" // FastQuadric method
+#include "SimplifyDeviation.h"
+#include "SimplifyStreaming.h"
+#include "vtkFastQuadricDecimation.h"
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Batch mode is used if the input model is a directory or a text file
+bool IsModelList(const std::string& path)
+{
+  return vtksys::SystemTools::FileIsDirectory(path)
+    || vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(path)) == ".txt";
+}
+
+//----------------------------------------------------------------------------
+// Get the model files in a directory, or listed in a text file (one per line,
+// empty lines and lines starting with # are ignored, relative paths are
+// relative to the list file)
+bool ReadModelList(const std::string& path, std::vector<std::string>& models)
+{
+  if (vtksys::SystemTools::FileIsDirectory(path))
+    {
+    vtksys::Directory directory;
+    if (!directory.Load(path))
+      {
+      return false;
+      }
+    const std::set<std::string> extensions = { ".obj", ".vtp", ".stl", ".ply" };
+    for (unsigned long i = 0; i < directory.GetNumberOfFiles(); ++i)
+      {
+      std::string file = path + "/" + directory.GetFile(i);
+      std::string ext = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(file));
+      if (extensions.count(ext) && !vtksys::SystemTools::FileIsDirectory(file))
+        {
+        models.push_back(file);
+        }
+      }
+    std::sort(models.begin(), models.end());
+    return true;
+    }
+  std::ifstream list(path.c_str());
+  if (!list)
+    {
+    return false;
+    }
+  std::string listDirectory = vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(path));
+  std::string line;
+  while (std::getline(list, line))
+    {
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#')
+      {
+      continue;
+      }
+    size_t end = line.find_last_not_of(" \t\r");
+    models.push_back(vtksys::SystemTools::CollapseFullPath(line.substr(begin, end - begin + 1), listDirectory));
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Reports progress to the application: through the process information if
+// the module runs in the application process, otherwise as progress tags on
+// the standard output (as vtkPluginFilterWatcher does). Update() can be
+// called from any thread and returns false once the user aborted.
+class ProgressReporter
+{
+public:
+  ProgressReporter(ModuleProcessInformation* processInformation, const std::string& comment)
+    : ProcessInformation(processInformation)
+    , Comment(comment)
+    , StartTime(std::chrono::steady_clock::now())
+    {
+    if (!this->ProcessInformation)
+      {
+      std::cout << "<filter-start>" << std::endl
+        << "<filter-name>Decimation</filter-name>" << std::endl
+        << "<filter-comment> \"" << this->Comment << "\" </filter-comment>" << std::endl
+        << "</filter-start>" << std::endl;
+      }
+    }
+
+  // Only checks for abort and reports nothing, used for the models of
+  // batch mode, whose progress is the fraction of models done
+  explicit ProgressReporter(ModuleProcessInformation* processInformation)
+    : ProcessInformation(processInformation)
+    , Report(false)
+    , StartTime(std::chrono::steady_clock::now())
+    {
+    }
+
+  ~ProgressReporter()
+    {
+    if (this->Report && !this->ProcessInformation)
+      {
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->StartTime).count();
+      std::cout << "<filter-end>" << std::endl
+        << "<filter-name>Decimation</filter-name>" << std::endl
+        << "<filter-time>" << seconds << "</filter-time>" << std::endl
+        << "</filter-end>" << std::endl;
+      }
+    }
+
+  bool Update(double progress)
+    {
+    if (!this->Report)
+      {
+      return !this->IsAborted();
+      }
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    // report in steps of 1%
+    if (progress >= this->LastProgress + 0.01 || (progress >= 1.0 && this->LastProgress < 1.0))
+      {
+      this->LastProgress = progress;
+      if (this->ProcessInformation)
+        {
+        this->ProcessInformation->Progress = progress;
+        strncpy(this->ProcessInformation->ProgressMessage, this->Comment.c_str(), sizeof(this->ProcessInformation->ProgressMessage) - 1);
+        if (this->ProcessInformation->ProgressCallbackFunction && this->ProcessInformation->ProgressCallbackClientData)
+          {
+          (*(this->ProcessInformation->ProgressCallbackFunction))(this->ProcessInformation->ProgressCallbackClientData);
+          }
+        }
+      else
+        {
+        std::cout << "<filter-progress>" << progress << "</filter-progress>" << std::endl;
+        }
+      }
+    return !this->IsAborted();
+    }
+
+  bool IsAborted() const
+    {
+    return this->ProcessInformation && this->ProcessInformation->Abort;
+    }
+
+private:
+  ModuleProcessInformation* ProcessInformation;
+  std::string Comment;
+  bool Report{ true };
+  std::chrono::steady_clock::time_point StartTime;
+  double LastProgress{ 0.0 };
+  std::mutex Mutex;
+};
+
+//----------------------------------------------------------------------------
+// Forward the progress of a VTK filter (mapped to 0.1-0.9) and abort the
+// filter if requested
+void ObserveProgress(vtkAlgorithm* filter, ProgressReporter* reporter)
+{
+  if (!reporter)
+    {
+    return;
+    }
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetClientData(reporter);
+  callback->SetCallback([](vtkObject* caller, unsigned long, void* clientData, void* callData)
+    {
+    double progress = *static_cast<double*>(callData);
+    if (!static_cast<ProgressReporter*>(clientData)->Update(0.1 + 0.8 * progress))
+      {
+      static_cast<vtkAlgorithm*>(caller)->AbortExecuteOn();
+      }
+    });
+  filter->AddObserver(vtkCommand::ProgressEvent, callback);
+}
+}
 
 int main(int argc, char* argv[])
 {
   PARSE_ARGS;
 
-  std::string inputModelExt = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(inputModel));
-  std::string outputModelExt = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(outputModel));
-
-  if (method == "FastQuadric")
+  // Decimate one model, messages are written to out and err. progress is
+  // optional.
+  auto decimateModel = [&](const std::string& inputModel, const std::string& outputModel,
+    std::ostream& out, std::ostream& err, ProgressReporter* progress) -> int
     {
-    if (inputModelExt != ".obj" || outputModelExt != ".obj")
+    // Verbose output of the simplifier, which can come from several threads
+    std::mutex logMutex;
+    auto log = [&out, &logMutex](const char* text)
       {
-      std::cerr << "FastQuadric method only supports input/output mesh files in OBJ format." << std::endl;
+      std::lock_guard<std::mutex> lock(logMutex);
+      out << text;
+      };
+
+    std::string inputModelExt = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(inputModel));
+    std::string outputModelExt = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(outputModel));
+
+    if (maxDeviation > 0 && method != "FastQuadric")
+      {
+      err << "Maximum deviation is only supported by FastQuadric method." << std::endl;
       return EXIT_FAILURE;
       }
-    Simplify::load_obj(inputModel.c_str());
-    if ((Simplify::triangles.size() < 3) || (Simplify::vertices.size() < 3))
+
+    if (!lodReductionFactors.empty()
+      && (method != "FastQuadric" || memoryBudget > 0 || inputModelExt != ".obj" || outputModelExt != ".obj"))
       {
-      std::cerr << "Minimum 3 triangles are needed." << std::endl;
+      err << "Levels of detail are only supported by FastQuadric method with input/output mesh files in OBJ format, without memory budget." << std::endl;
       return EXIT_FAILURE;
       }
-    int target_count = round((float)Simplify::triangles.size() * (1.0-reductionFactor));
-    if (target_count < 4)
+
+    if (memoryBudget > 0)
+      {
+      if (method != "FastQuadric" || inputModelExt != ".obj" || outputModelExt != ".obj")
+        {
+        err << "Memory budget is only supported by FastQuadric method with input/output mesh files in OBJ format." << std::endl;
+        return EXIT_FAILURE;
+        }
+      if (maxDeviation > 0)
+        {
+        err << "Maximum deviation cannot be used with memory budget." << std::endl;
+        return EXIT_FAILURE;
+        }
+      Simplify::StreamingSimplifier simplifier;
+      simplifier.memory_budget = size_t(memoryBudget) << 20;
+      simplifier.threads = threads;
+      simplifier.agressiveness = aggressiveness;
+      simplifier.lossless = lossless;
+      simplifier.priority_queue = priorityQueue;
+      simplifier.preserve_border = !boundaryDeletion;
+      simplifier.verbose = verbose;
+      simplifier.log = log;
+      if (!simplifier.simplify_obj(inputModel.c_str(), outputModel.c_str(), reductionFactor))
+        {
+        err << "Failed to decimate " << inputModel << " to " << outputModel << std::endl;
+        return EXIT_FAILURE;
+        }
+      double achievedReduction = 1.0 - (double)simplifier.output_triangles / (double)simplifier.input_triangles;
+      out << "Input: " << simplifier.input_vertices << " vertices," << simplifier.input_triangles << " triangles" << std::endl;
+      out << "Output: " << simplifier.output_vertices << " vertices,"
+        << simplifier.output_triangles << " triangles (" << achievedReduction << " reduction, "
+        << simplifier.block_count << " blocks)" << std::endl;
+      if (!simplifier.target_reached)
+        {
+        err << "Reduction target was not reached, block seams could not be simplified within the memory budget." << std::endl;
+        return EXIT_FAILURE;
+        }
+      return EXIT_SUCCESS;
+      }
+
+    bool clustering = method == "Clustering";
+    if ((method == "FastQuadric" || clustering) && inputModelExt == ".obj" && outputModelExt == ".obj")
+      {
+      // OBJ files are read and written directly, which keeps texture coordinates and materials
+      auto decimate = [&](auto& simplifier) -> int
+        {
+        simplifier.threads = threads; // used by the initial edge error pass
+        simplifier.preserve_border = !boundaryDeletion;
+        simplifier.log = log;
+        if (!simplifier.load_obj(inputModel.c_str()))
+          {
+          err << "Failed to read input model: " << inputModel << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (progress)
+          {
+          progress->Update(0.1);
+          simplifier.progress = [progress](double fraction) { return progress->Update(0.1 + 0.8 * fraction); };
+          }
+        if ((simplifier.triangles.size() < 3) || (simplifier.vertices.size() < 3))
+          {
+          err << "Minimum 3 triangles are needed." << std::endl;
+          return EXIT_FAILURE;
+          }
+        bool errorBounded = maxDeviation > 0 && !lossless;
+        int target_count = round((float)simplifier.triangles.size() * (1.0-reductionFactor));
+        if (target_count < 4 && !errorBounded)
+          {
+          err << "Object will not survive such extreme decimation." << std::endl;
+          return EXIT_FAILURE;
+          }
+        out << "Input: " << simplifier.vertices.size() << " vertices,"
+          << simplifier.triangles.size() << " triangles";
+        if (errorBounded)
+          {
+          out << " (maximum deviation " << maxDeviation << ")" << std::endl;
+          }
+        else
+          {
+          out << " (target " << target_count << ")" << std::endl;
+          }
+        size_t startSize = simplifier.triangles.size();
+        auto simplify = [&](auto& mesh, int targetCount)
+          {
+          if (priorityQueue)
+            {
+            mesh.simplify_mesh_heap(targetCount, verbose);
+            }
+          else if (threads != 1)
+            {
+            mesh.simplify_mesh_parallel(targetCount, threads, aggressiveness, verbose);
+            }
+          else
+            {
+            mesh.simplify_mesh(targetCount, aggressiveness, verbose);
+            }
+          };
+        if (!lodReductionFactors.empty())
+          {
+          // Write additional levels of detail from the same run, next to the output model
+          if (lossless || errorBounded || clustering)
+            {
+            err << "Levels of detail cannot be generated in lossless, maximum deviation, or clustering mode." << std::endl;
+            return EXIT_FAILURE;
+            }
+          std::vector<std::pair<int, std::string> > levels;
+          levels.push_back(std::make_pair(target_count, outputModel));
+          std::string outputBase = outputModel.substr(0, outputModel.size() - outputModelExt.size());
+          for (double factor : lodReductionFactors)
+            {
+            if (factor < 0.0 || factor >= 1.0)
+              {
+              err << "Invalid level of detail reduction factor: " << factor << std::endl;
+              return EXIT_FAILURE;
+              }
+            int levelCount = round(startSize * (1.0 - factor));
+            if (levelCount < 4)
+              {
+              err << "Object will not survive such extreme decimation (level of detail reduction factor " << factor << ")." << std::endl;
+              return EXIT_FAILURE;
+              }
+            std::ostringstream name;
+            name << outputBase << "_reduction" << factor * 100 << outputModelExt;
+            levels.push_back(std::make_pair(levelCount, name.str()));
+            }
+          // from the least to the most reduced
+          std::stable_sort(levels.begin(), levels.end(),
+            [](const std::pair<int, std::string>& a, const std::pair<int, std::string>& b) { return a.first > b.first; });
+          bool written = true;
+          auto writeLevel = [&](size_t level)
+            {
+            if (!simplifier.write_obj(levels[level].second.c_str()))
+              {
+              err << "Failed to write output model: " << levels[level].second << std::endl;
+              written = false;
+              }
+            out << "Output " << levels[level].second << ": " << simplifier.vertices.size() << " vertices,"
+              << simplifier.triangles.size() << " triangles" << std::endl;
+            };
+          if (priorityQueue || threads != 1)
+            {
+            // One run per level, each continues from the previous level
+            // with its quadrics
+            for (size_t level = 0; level < levels.size() && !simplifier.aborted; ++level)
+              {
+              simplifier.reuse_quadrics = level > 0;
+              simplify(simplifier, levels[level].first);
+              if (!simplifier.aborted)
+                {
+                writeLevel(level);
+                }
+              }
+            }
+          else
+            {
+            std::vector<int> targets;
+            for (const std::pair<int, std::string>& level : levels)
+              {
+              targets.push_back(level.first);
+              }
+            simplifier.simplify_mesh_lods(targets, writeLevel, aggressiveness, verbose);
+            }
+          if (simplifier.aborted)
+            {
+            err << "Decimation was aborted." << std::endl;
+            return EXIT_FAILURE;
+            }
+          return written ? EXIT_SUCCESS : EXIT_FAILURE;
+          }
+        Simplify::ToleranceResult toleranceResult;
+        if (clustering)
+          {
+          simplifier.simplify_mesh_clustering(target_count, clusterCellSize, verbose);
+          }
+        else if (lossless)
+          {
+          simplifier.simplify_mesh_lossless(verbose);
+          }
+        else if (errorBounded)
+          {
+          toleranceResult = Simplify::simplify_to_tolerance(simplifier, maxDeviation,
+            [&](auto& mesh) { simplify(mesh, 0); }, verbose);
+          }
+        else
+          {
+          simplify(simplifier, target_count);
+          }
+        if (verbose)
+          {
+          simplifier.print_statistics();
+          }
+        if (simplifier.aborted)
+          {
+          err << "Decimation was aborted." << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (errorBounded && !toleranceResult.reduced)
+          {
+          err << "Unable to reduce mesh within maximum deviation " << maxDeviation << "." << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (simplifier.triangles.size() >= startSize)
+          {
+          err << "Unable to reduce mesh." << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (!simplifier.write_obj(outputModel.c_str()))
+          {
+          err << "Failed to write output model: " << outputModel << std::endl;
+          return EXIT_FAILURE;
+          }
+        double achievedReduction = 1.0 - (double)simplifier.triangles.size() / (double)startSize;
+        out << "Output: " << simplifier.vertices.size() << " vertices,"
+          << simplifier.triangles.size() << " triangles (" << achievedReduction << " reduction)" << std::endl;
+        if (errorBounded)
+          {
+          out << "Sampled deviation: " << toleranceResult.deviation.sampled_max << " maximum, "
+            << toleranceResult.deviation.sampled_mean << " mean" << std::endl;
+          }
+        return EXIT_SUCCESS;
+        };
+      if (singlePrecision)
+        {
+        Simplify::BasicSimplifier<float> simplifier;
+        return decimate(simplifier);
+        }
+      Simplify::Simplifier simplifier;
+      return decimate(simplifier);
+      }
+
+    // VTK decimation filters, FastQuadric and Clustering for other than OBJ files
+
+    // Read the input model
+    vtkSmartPointer<vtkPolyData> inputPolyData;
+    if (inputModelExt == ".obj")
+      {
+      vtkNew<vtkOBJReader> reader;
+      reader->SetFileName(inputModel.c_str());
+      reader->Update();
+      inputPolyData = reader->GetOutput();
+      }
+    else if (inputModelExt == ".vtp")
       {
-      std::cerr << "Object will not survive such extreme decimation." << std::endl;
+      vtkNew<vtkXMLPolyDataReader> reader;
+      reader->SetFileName(inputModel.c_str());
+      reader->Update();
+      inputPolyData = reader->GetOutput();
+      }
+    else if (inputModelExt == ".stl")
+      {
+      vtkNew<vtkSTLReader> reader;
+      reader->SetFileName(inputModel.c_str());
+      reader->Update();
+      inputPolyData = reader->GetOutput();
+      }
+    else if (inputModelExt == ".ply")
+      {
+      vtkNew<vtkPLYReader> reader;
+      reader->SetFileName(inputModel.c_str());
+      reader->Update();
+      inputPolyData = reader->GetOutput();
+      }
+    else
+      {
+      err << "Input mesh is expected in OBJ, VTP, STL, or PLY file format." << std::endl;
       return EXIT_FAILURE;
       }
-    std::cout << "Input: " << Simplify::vertices.size() << " vertices,"
-      << Simplify::triangles.size() << " triangles (target " << target_count << ")" << std::endl;
-    size_t startSize = Simplify::triangles.size();
-    if (lossless)
+
+    // Triangulate input mesh (not needed if it only contains triangles)
+    if (inputPolyData->GetNumberOfVerts() > 0 || inputPolyData->GetNumberOfLines() > 0
+      || inputPolyData->GetNumberOfStrips() > 0 || inputPolyData->GetPolys()->IsHomogeneous() != 3)
+      {
+      vtkNew<vtkTriangleFilter> triangles;
+      triangles->SetInputData(inputPolyData);
+      triangles->Update();
+      inputPolyData = triangles->GetOutput();
+      }
+
+    vtkSmartPointer<vtkPolyData> outputPolyData;
+    if (method == "FastQuadric" || clustering)
       {
-      Simplify::simplify_mesh_lossless(verbose);
+      vtkIdType startSize = inputPolyData->GetNumberOfPolys();
+      if (startSize < 3 || inputPolyData->GetNumberOfPoints() < 3)
+        {
+        err << "Minimum 3 triangles are needed." << std::endl;
+        return EXIT_FAILURE;
+        }
+      bool errorBounded = maxDeviation > 0 && !lossless;
+      int target_count = round((float)startSize * (1.0-reductionFactor));
+      if (target_count < 4 && !errorBounded)
+        {
+        err << "Object will not survive such extreme decimation." << std::endl;
+        return EXIT_FAILURE;
+        }
+      out << "Input: " << inputPolyData->GetNumberOfPoints() << " vertices,"
+        << startSize << " triangles";
+      if (errorBounded)
+        {
+        out << " (maximum deviation " << maxDeviation << ")" << std::endl;
+        }
+      else
+        {
+        out << " (target " << target_count << ")" << std::endl;
+        }
+      vtkNew<vtkFastQuadricDecimation> decimate;
+      decimate->SetInputData(inputPolyData);
+      decimate->SetTargetReduction(reductionFactor);
+      decimate->SetAggressiveness(aggressiveness);
+      decimate->SetLossless(lossless);
+      decimate->SetPriorityQueue(priorityQueue);
+      decimate->SetPreserveBoundary(!boundaryDeletion);
+      decimate->SetMaximumDeviation(maxDeviation);
+      decimate->SetSinglePrecision(singlePrecision);
+      decimate->SetVertexClustering(clustering);
+      decimate->SetClusterCellSize(clusterCellSize);
+      decimate->SetMapPointData(true);
+      decimate->SetNumberOfThreads(threads);
+      decimate->SetVerbose(verbose);
+      vtkNew<vtkCallbackCommand> messageCallback;
+      messageCallback->SetClientData(&out);
+      messageCallback->SetCallback([](vtkObject*, unsigned long, void* clientData, void* callData)
+        {
+        *static_cast<std::ostream*>(clientData) << static_cast<const char*>(callData);
+        });
+      decimate->AddObserver(vtkCommand::MessageEvent, messageCallback);
+      ObserveProgress(decimate, progress);
+      decimate->Update();
+      if (progress && progress->IsAborted())
+        {
+        err << "Decimation was aborted." << std::endl;
+        return EXIT_FAILURE;
+        }
+      outputPolyData = decimate->GetOutput();
+      if (errorBounded && !decimate->GetOutputReduced())
+        {
+        err << "Unable to reduce mesh within maximum deviation " << maxDeviation << "." << std::endl;
+        return EXIT_FAILURE;
+        }
+      if (outputPolyData->GetNumberOfPolys() >= startSize)
+        {
+        err << "Unable to reduce mesh." << std::endl;
+        return EXIT_FAILURE;
+        }
+      double achievedReduction = 1.0 - (double)outputPolyData->GetNumberOfPolys() / (double)startSize;
+      out << "Output: " << outputPolyData->GetNumberOfPoints() << " vertices,"
+        << outputPolyData->GetNumberOfPolys() << " triangles (" << achievedReduction << " reduction)" << std::endl;
+      if (errorBounded)
+        {
+        out << "Sampled deviation: " << decimate->GetOutputSampledMaximumDeviation() << " maximum, "
+          << decimate->GetOutputSampledMeanDeviation() << " mean" << std::endl;
+        }
+      }
+    else if (method == "Quadric")
+      {
+      vtkNew<vtkQuadricDecimation> decimate;
+      decimate->SetInputData(inputPolyData);
+      decimate->SetTargetReduction(reductionFactor);
+      //decimate->SetVolumePreservation(true);
+      ObserveProgress(decimate, progress);
+      decimate->Update();
+      outputPolyData = decimate->GetOutput();
       }
     else
       {
-      Simplify::simplify_mesh(target_count, aggressiveness, verbose);
+      vtkNew<vtkDecimatePro> decimate;
+      decimate->SetInputData(inputPolyData);
+      decimate->SetTargetReduction(reductionFactor);
+      decimate->SetBoundaryVertexDeletion(boundaryDeletion);
+      decimate->PreserveTopologyOn();
+      ObserveProgress(decimate, progress);
+      decimate->Update();
+      outputPolyData = decimate->GetOutput();
       }
-    if (Simplify::triangles.size() >= startSize)
+    if (progress && progress->IsAborted())
       {
-      std::cerr << "Unable to reduce mesh." << std::endl;
+      err << "Decimation was aborted." << std::endl;
       return EXIT_FAILURE;
       }
-    Simplify::write_obj(outputModel.c_str());
-    double achievedReduction = 1.0 - (double)Simplify::triangles.size() / (double)startSize;
-    std::cout << "Output: " << Simplify::vertices.size() << " vertices,"
-      << Simplify::triangles.size() << " triangles (" << achievedReduction << " reduction)" << std::endl;
-    return EXIT_SUCCESS;
-    }
 
-  // VTK decimation filters
+    //Write to file
+    if (outputModelExt == ".obj")
+      {
+      vtkNew<vtkOBJWriter> writer;
+      writer->SetFileName(outputModel.c_str());
+      writer->SetInputData(outputPolyData);
+      writer->Update();
+      }
+    else if (outputModelExt == ".vtp")
+      {
+      vtkNew<vtkXMLPolyDataWriter> writer;
+      writer->SetFileName(outputModel.c_str());
+      writer->SetInputData(outputPolyData);
+      writer->Update();
+      }
+    else if (outputModelExt == ".stl")
+      {
+      vtkNew<vtkSTLWriter> writer;
+      writer->SetFileName(outputModel.c_str());
+      writer->SetInputData(outputPolyData);
+      writer->SetFileTypeToBinary();
+      writer->Update();
+      }
+    else if (outputModelExt == ".ply")
+      {
+      vtkNew<vtkPLYWriter> writer;
+      writer->SetFileName(outputModel.c_str());
+      writer->SetInputData(outputPolyData);
+      writer->SetFileTypeToBinary();
+      writer->Update();
+      }
+    else
+      {
+      err << "Output mesh can be written in OBJ, VTP, STL, or PLY file format." << std::endl;
+      return EXIT_FAILURE;
+      }
 
-  // Read the input model
-  vtkSmartPointer<vtkPolyData> inputPolyData;
-  if (inputModelExt == ".obj")
+    return EXIT_SUCCESS;
+    };
+
+  if (!IsModelList(inputModel))
     {
-    vtkNew<vtkOBJReader> reader;
-    reader->SetFileName(inputModel.c_str());
-    reader->Update();
-    inputPolyData = reader->GetOutput();
+    ProgressReporter progress(CLPProcessInformation, "Decimating model");
+    int result = decimateModel(inputModel, outputModel, std::cout, std::cerr, &progress);
+    progress.Update(1.0);
+    return result;
     }
-  else if (inputModelExt == ".vtp")
+
+  // Batch mode: decimate all listed models into the output directory, concurrently
+  std::vector<std::string> inputModels;
+  if (!ReadModelList(inputModel, inputModels))
     {
-    vtkNew<vtkXMLPolyDataReader> reader;
-    reader->SetFileName(inputModel.c_str());
-    reader->Update();
-    inputPolyData = reader->GetOutput();
+    std::cerr << "Failed to read input model list: " << inputModel << std::endl;
+    return EXIT_FAILURE;
     }
-  else
+  if (inputModels.empty())
     {
-    std::cerr << "Input mesh is expected in OBJ or VTP file format." << std::endl;
+    std::cerr << "No input models found in " << inputModel << std::endl;
     return EXIT_FAILURE;
     }
-
-  // Triangulate input mesh
-  vtkNew<vtkTriangleFilter> triangles;
-  triangles->SetInputData(inputPolyData);
-  triangles->Update();
-  inputPolyData = triangles->GetOutput();
-
-  vtkSmartPointer<vtkPolyData> outputPolyData;
-  if (method == "Quadric")
+  if (!vtksys::SystemTools::MakeDirectory(outputModel))
     {
-    vtkNew<vtkQuadricDecimation> decimate;
-    decimate->SetInputData(inputPolyData);
-    decimate->SetTargetReduction(reductionFactor);
-    //decimate->SetVolumePreservation(true);
-    decimate->Update();
-    outputPolyData = decimate->GetOutput();
+    std::cerr << "Failed to create output directory: " << outputModel << std::endl;
+    return EXIT_FAILURE;
     }
-  else
+  std::vector<std::string> outputModels;
+  std::set<std::string> outputNames;
+  for (const std::string& model : inputModels)
     {
-    vtkNew<vtkDecimatePro> decimate;
-    decimate->SetInputData(inputPolyData);
-    decimate->SetTargetReduction(reductionFactor);
-    decimate->SetBoundaryVertexDeletion(boundaryDeletion);
-    decimate->PreserveTopologyOn();
-    decimate->Update();
-    outputPolyData = decimate->GetOutput();
+    std::string name = vtksys::SystemTools::GetFilenameName(model);
+    if (!outputNames.insert(name).second)
+      {
+      std::cerr << "Multiple input models are named " << name << std::endl;
+      return EXIT_FAILURE;
+      }
+    outputModels.push_back(outputModel + "/" + name);
     }
 
-  //Write to file
-  if (outputModelExt == ".obj")
+  size_t workerCount = workers > 0 ? workers : std::max(1u, std::thread::hardware_concurrency());
+  workerCount = std::min(workerCount, inputModels.size());
+  std::cout << "Decimating " << inputModels.size() << " models using " << workerCount << " workers" << std::endl;
+  std::atomic<size_t> nextModel(0);
+  std::mutex outputMutex;
+  size_t failedCount = 0;
+  size_t doneCount = 0;
+  // progress is the fraction of models done, abort stops the models that
+  // are being decimated and skips the remaining ones
+  ProgressReporter progress(CLPProcessInformation, "Decimating models");
+  auto runWorker = [&]()
+    {
+    for (size_t i = nextModel++; i < inputModels.size() && !progress.IsAborted(); i = nextModel++)
+      {
+      // messages of a model are printed together when it is done
+      std::ostringstream out, err;
+      auto startTime = std::chrono::steady_clock::now();
+      ProgressReporter modelProgress(CLPProcessInformation);
+      int result = decimateModel(inputModels[i], outputModels[i], out, err, &modelProgress);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::cout << "[" << i + 1 << "/" << inputModels.size() << "] " << inputModels[i]
+        << " -> " << outputModels[i] << " (" << seconds << " s)" << std::endl << out.str();
+      std::cerr << err.str();
+      if (result != EXIT_SUCCESS)
+        {
+        std::cerr << "Failed to decimate " << inputModels[i] << std::endl;
+        failedCount++;
+        }
+      doneCount++;
+      progress.Update(double(doneCount) / inputModels.size());
+      }
+    };
+  auto startTime = std::chrono::steady_clock::now();
+  std::vector<std::thread> workerThreads;
+  for (size_t i = 1; i < workerCount; ++i)
     {
-    vtkNew<vtkOBJWriter> writer;
-    writer->SetFileName(outputModel.c_str());
-    writer->SetInputData(outputPolyData);
-    writer->Update();
+    workerThreads.push_back(std::thread(runWorker));
     }
-  else if (outputModelExt == ".vtp")
+  runWorker();
+  for (std::thread& workerThread : workerThreads)
     {
-    vtkNew<vtkXMLPolyDataWriter> writer;
-    writer->SetFileName(outputModel.c_str());
-    writer->SetInputData(outputPolyData);
-    writer->Update();
+    workerThread.join();
     }
-  else
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  std::cout << "Decimated " << doneCount - failedCount << " of " << inputModels.size()
+    << " models in " << seconds << " s" << std::endl;
+  if (progress.IsAborted())
     {
-    std::cerr << "Output mesh can be written in OBJ or VTP file format." << std::endl;
+    std::cerr << "Decimation was aborted." << std::endl;
     return EXIT_FAILURE;
     }
-
-  return EXIT_SUCCESS;
+  return failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
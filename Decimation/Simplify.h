@@ -11,6 +11,9 @@
 //
 // 5/2016: Chris Rorden created minimal version for OSX/Linux/Windows compile
 
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
 //#include <iostream>
 //#include <stddef.h>
 //#include <functional>
@@ -19,13 +22,45 @@
 #include <string.h>
 //#include <ctype.h>
 //#include <float.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <map>
 #include <vector>
 #include <string>
 #include <math.h>
 #include <float.h> //FLT_EPSILON, DBL_EPSILON
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+// Memory mapped input files for load_obj and the streaming vertex file
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// SIMD instruction set used by the batched quadric error kernels
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMPLIFY_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMPLIFY_SIMD_SSE2
+#endif
 
 
 struct vector3
@@ -206,7 +241,7 @@ struct vec3f
 
 };
 
-vec3f barycentric(const vec3f &p, const vec3f &a, const vec3f &b, const vec3f &c){
+inline vec3f barycentric(const vec3f &p, const vec3f &a, const vec3f &b, const vec3f &c){
     vec3f v0 = b-a;
     vec3f v1 = c-a;
     vec3f v2 = p-a;
@@ -222,7 +257,7 @@ vec3f barycentric(const vec3f &p, const vec3f &a, const vec3f &b, const vec3f &c
     return vec3f(u,v,w);
 }
 
-vec3f interpolate(const vec3f &p, const vec3f &a, const vec3f &b, const vec3f &c, const vec3f attrs[3])
+inline vec3f interpolate(const vec3f &p, const vec3f &a, const vec3f &b, const vec3f &c, const vec3f attrs[3])
 {
     vec3f bary = barycentric(p,a,b,c);
     vec3f out = vec3f(0,0,0);
@@ -232,7 +267,7 @@ vec3f interpolate(const vec3f &p, const vec3f &a, const vec3f &b, const vec3f &c
     return out;
 }
 
-double min(double v1, double v2) {
+inline double min(double v1, double v2) {
     return fmin(v1,v2);
 }
 
@@ -298,765 +333,2674 @@ class SymetricMatrix {
 };
 ///////////////////////////////////////////
 
+//
+// Minimal wrapper over SIMD double vectors (AVX: 4 lanes, SSE2: 2 lanes,
+// otherwise scalar), used for evaluating quadric errors of several edges
+// at once. Operations are applied in the same order as in the scalar code,
+// so results are identical to SymetricMatrix::det and vertex_error.
+//
+namespace simd
+{
+#if defined(SIMPLIFY_SIMD_AVX)
+    const int width = 4;
+    typedef __m256d vdouble;
+    // lane i = p[i][c]
+    inline vdouble gather(const double *const *p, int c) { return _mm256_set_pd(p[3][c], p[2][c], p[1][c], p[0][c]); }
+    inline void store(double *p, vdouble a) { _mm256_storeu_pd(p, a); }
+    inline vdouble set1(double a) { return _mm256_set1_pd(a); }
+    inline vdouble add(vdouble a, vdouble b) { return _mm256_add_pd(a, b); }
+    inline vdouble sub(vdouble a, vdouble b) { return _mm256_sub_pd(a, b); }
+    inline vdouble mul(vdouble a, vdouble b) { return _mm256_mul_pd(a, b); }
+    inline vdouble div(vdouble a, vdouble b) { return _mm256_div_pd(a, b); }
+    // bit i is set if lane i is zero
+    inline int zero_mask(vdouble a) { return _mm256_movemask_pd(_mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_EQ_OQ)); }
+#elif defined(SIMPLIFY_SIMD_SSE2)
+    const int width = 2;
+    typedef __m128d vdouble;
+    // lane i = p[i][c]
+    inline vdouble gather(const double *const *p, int c) { return _mm_set_pd(p[1][c], p[0][c]); }
+    inline void store(double *p, vdouble a) { _mm_storeu_pd(p, a); }
+    inline vdouble set1(double a) { return _mm_set1_pd(a); }
+    inline vdouble add(vdouble a, vdouble b) { return _mm_add_pd(a, b); }
+    inline vdouble sub(vdouble a, vdouble b) { return _mm_sub_pd(a, b); }
+    inline vdouble mul(vdouble a, vdouble b) { return _mm_mul_pd(a, b); }
+    inline vdouble div(vdouble a, vdouble b) { return _mm_div_pd(a, b); }
+    // bit i is set if lane i is zero
+    inline int zero_mask(vdouble a) { return _mm_movemask_pd(_mm_cmpeq_pd(a, _mm_setzero_pd())); }
+#else
+    const int width = 1;
+    typedef double vdouble;
+    inline vdouble gather(const double *const *p, int c) { return p[0][c]; }
+    inline void store(double *p, vdouble a) { *p = a; }
+    inline vdouble set1(double a) { return a; }
+    inline vdouble add(vdouble a, vdouble b) { return a + b; }
+    inline vdouble sub(vdouble a, vdouble b) { return a - b; }
+    inline vdouble mul(vdouble a, vdouble b) { return a * b; }
+    inline vdouble div(vdouble a, vdouble b) { return a / b; }
+    inline int zero_mask(vdouble a) { return a == 0 ? 1 : 0; }
+#endif
+
+    // Same as SymetricMatrix::det, for a quadric stored in m[10]
+    inline vdouble det(const vdouble *m,
+                int a11, int a12, int a13,
+                int a21, int a22, int a23,
+                int a31, int a32, int a33)
+    {
+        vdouble det = add(add(mul(mul(m[a11],m[a22]),m[a33]), mul(mul(m[a13],m[a21]),m[a32])), mul(mul(m[a12],m[a23]),m[a31]));
+        det = sub(det, mul(mul(m[a13],m[a22]),m[a31]));
+        det = sub(det, mul(mul(m[a11],m[a23]),m[a32]));
+        det = sub(det, mul(mul(m[a12],m[a21]),m[a33]));
+        return det;
+    }
+
+    // Same as Simplify::Simplifier::vertex_error
+    inline vdouble vertex_error(const vdouble *q, vdouble x, vdouble y, vdouble z)
+    {
+        const vdouble two = set1(2);
+        vdouble e = mul(mul(q[0],x),x);
+        e = add(e, mul(mul(mul(two,q[1]),x),y));
+        e = add(e, mul(mul(mul(two,q[2]),x),z));
+        e = add(e, mul(mul(two,q[3]),x));
+        e = add(e, mul(mul(q[4],y),y));
+        e = add(e, mul(mul(mul(two,q[5]),y),z));
+        e = add(e, mul(mul(two,q[6]),y));
+        e = add(e, mul(mul(q[7],z),z));
+        e = add(e, mul(mul(two,q[8]),z));
+        e = add(e, q[9]);
+        return e;
+    }
+} // namespace simd
+///////////////////////////////////////////
+
 namespace Simplify
 {
-    // Global Variables & Strctures
+    // Structures
     enum Attributes {
         NONE,
         NORMAL = 2,
         TEXCOORD = 4,
         COLOR = 8
     };
-    struct Triangle { int v[3];double err[4];int deleted,dirty,attr;vec3f n;vec3f uvs[3];int material; };
-    struct Vertex { vec3f p;int tstart; size_t tcount;SymetricMatrix q;int border;};
+    // Triangle and Vertex only contain the fields that are accessed by the
+    // collapse loops, to keep them small and densely packed. Other per-element
+    // data is stored in separate arrays in Simplifier (normals, attributes,
+    // quadrics), indexed the same way as triangles/vertices.
+    // The flags and errors stay in Triangle: the collapse reads the vertices,
+    // errors and flags of each triangle around a vertex together, one record
+    // instead of three arrays. Only the sweeps over all triangles (clearing
+    // dirty, testing err[3]) read them alone, a small part of the time.
+    struct Triangle { int v[3];int deleted,dirty,attr;double err[4]; };
+    struct TriangleAttributes { vec3f uvs[3];int material=-1; };
     struct Ref { int tid,tvertex; };
-    std::vector<Triangle> triangles;
-    std::vector<Vertex> vertices;
-    std::vector<Ref> refs;
-    std::string mtllib;
-    std::vector<std::string> materials;
-
-    // Helper functions
-
-    double vertex_error(SymetricMatrix q, double x, double y, double z);
-    double calculate_error(int id_v1, int id_v2, vec3f &p_result);
-    bool flipped(vec3f p,int i0,int i1,Vertex &v0,Vertex &v1,std::vector<int> &deleted);
-    void update_uvs(int i0,const Vertex &v,const vec3f &p,std::vector<int> &deleted);
-    void update_triangles(int i0,Vertex &v,std::vector<int> &deleted,int &deleted_triangles);
-    void update_mesh(int iteration);
-    void compact_mesh();
-    //
-    // Main simplification function
-    //
-    // target_count  : target nr. of triangles
-    // agressiveness : sharpness to increase the threshold.
-    //                 5..8 are good numbers
-    //                 more iterations yield higher quality
-    //
 
-    void simplify_mesh(int target_count, double agressiveness=7, bool verbose=false)
+    // Vertex position stored with Real precision. Positions are converted
+    // to vec3f (double) wherever they are used in computations.
+    template<class Real>
+    struct Position
     {
-        // init
-        for(Triangle& t: triangles) { t.deleted=0; }
-
-        // main iteration loop
-        int deleted_triangles=0;
-        std::vector<int> deleted0,deleted1;
-        int triangle_count=triangles.size();
-        //int iteration = 0;
-        //loop(iteration,0,100)
-        for (int iteration = 0; iteration < 100; iteration ++)
-        {
-            if(triangle_count-deleted_triangles<=target_count)break;
-
-            // update mesh once in a while
-            if(iteration%5==0)
-            {
-                update_mesh(iteration);
-            }
+        Real x, y, z;
+        Position() {}
+        Position(const vec3f& p) : x(Real(p.x)), y(Real(p.y)), z(Real(p.z)) {}
+        operator vec3f() const { return vec3f(x, y, z); }
+    };
+    template<class Real> struct PositionType { typedef Position<Real> type; };
+    template<> struct PositionType<double> { typedef vec3f type; };
 
-            // clear dirty flag
-            for(Triangle& triangle: triangles) { triangle.dirty=0; }
+    template<class Real>
+    struct BasicVertex { typename PositionType<Real>::type p;int tstart,border;unsigned tcount; };
+    typedef BasicVertex<double> Vertex;
 
-            //
-            // All triangles with edges below the threshold will be removed
-            //
-            // The following numbers works well for most models.
-            // If it does not, try to adjust the 3 parameters
-            //
-            double threshold = 0.000000001*pow(double(iteration+3),agressiveness);
+    //
+    // Indexed 4-ary min-heap of edge errors. Items are identified by an
+    // integer id (triangle index) and the position of each id in the heap is
+    // stored, so that its key can be changed in place or removed without
+    // searching. Decreasing a key sifts the item up immediately; increasing a
+    // key only records the new value and the item is sifted down lazily when
+    // it reaches the top, since most edges with increased error are removed
+    // by a neighboring collapse before that happens.
+    //
+    class EdgeHeap
+    {
+    public:
+        void reset(size_t id_count)
+        {
+            heap.clear();
+            heap.reserve(id_count);
+            pos.assign(id_count, -1);
+            value.resize(id_count);
+        }
 
-            // target number of triangles reached ? Then break
-            if ((verbose) && (iteration%5==0)) {
-                printf("iteration %d - triangles %d threshold %g\n",iteration,triangle_count-deleted_triangles, threshold);
-            }
+        bool empty() const { return heap.empty(); }
+        size_t size() const { return heap.size(); }
+        bool contains(int id) const { return pos[id] >= 0; }
 
-            // remove vertices & mark deleted triangles
-            for(Triangle& t: triangles)
+        // Id with the smallest key
+        int top()
+        {
+            // entries with outdated (too small) keys are moved to their place
+            while(heap[0].key != value[heap[0].id])
             {
-                if(t.err[3]>threshold) continue;
-                if(t.deleted) continue;
-                if(t.dirty) continue;
-
-                for(size_t j: {0, 1, 2})
-                {
-                    if(t.err[j] >= threshold)
-                    {
-                        continue;
-                    }
-
-                    int i0=t.v[ j     ]; Vertex &v0 = vertices[i0];
-                    int i1=t.v[(j+1)%3]; Vertex &v1 = vertices[i1];
-                    // Border check
-                    if(v0.border != v1.border)  continue;
-
-                    // Compute vertex to collapse to
-                    vec3f p;
-                    calculate_error(i0,i1,p);
-                    deleted0.resize(v0.tcount); // normals temporarily
-                    deleted1.resize(v1.tcount); // normals temporarily
-                    // don't remove if flipped
-                    if( flipped(p,i0,i1,v0,v1,deleted0) ) continue;
-
-                    if( flipped(p,i1,i0,v1,v0,deleted1) ) continue;
-
-                    if ( (t.attr & TEXCOORD) == TEXCOORD  )
-                    {
-                        update_uvs(i0,v0,p,deleted0);
-                        update_uvs(i0,v1,p,deleted1);
-                    }
-
-                    // not flipped, so remove edge
-                    v0.p=p;
-                    v0.q=v1.q+v0.q;
-                    int tstart=refs.size();
-
-                    update_triangles(i0,v0,deleted0,deleted_triangles);
-                    update_triangles(i0,v1,deleted1,deleted_triangles);
-
-                    size_t tcount = refs.size() - tstart;
-
-                    if(tcount<=v0.tcount)
-                    {
-                        // save ram
-                        if(tcount)memcpy(&refs[v0.tstart],&refs[tstart],tcount*sizeof(Ref));
-                    }
-                    else
-                        // append
-                        v0.tstart=tstart;
-
-                    v0.tcount=tcount;
-                    break;
-                }
-                // done?
-                if(triangle_count-deleted_triangles<=target_count)break;
+                heap[0].key = value[heap[0].id];
+                sift_down(0);
             }
+            return heap[0].id;
         }
-        // clean up mesh
-        compact_mesh();
-    } //simplify_mesh()
+        double top_key() { return value[top()]; }
 
-    void simplify_mesh_lossless(bool verbose=false)
-    {
-        // init
-        for(Triangle& t: triangles) { t.deleted=0; }
-
-        // main iteration loop
-        int deleted_triangles=0;
-        std::vector<int> deleted0,deleted1;
-        //int iteration = 0;
-        //loop(iteration,0,100)
-        for (int iteration = 0; iteration < 9999; iteration ++)
+        // Insert id or update its key if it is already in the heap
+        void update(int id, double k)
         {
-            // update mesh constantly
-            update_mesh(iteration);
-            // clear dirty flag
-            for(Triangle& t: triangles) { t.dirty=0; }
-            //
-            // All triangles with edges below the threshold will be removed
-            //
-            // The following numbers works well for most models.
-            // If it does not, try to adjust the 3 parameters
-            //
-            double threshold = DBL_EPSILON; //1.0E-3 EPS;
-            if (verbose) {
-                printf("lossless iteration %d\n", iteration);
+            value[id] = k;
+            if(pos[id] < 0)
+            {
+                pos[id] = heap.size();
+                heap.push_back(Entry{k, id});
+                sift_up(pos[id]);
             }
-
-            // remove vertices & mark deleted triangles
-            for(Triangle& t: triangles)
+            else if(k < heap[pos[id]].key)
             {
-                if(t.err[3]>threshold) continue;
-                if(t.deleted) continue;
-                if(t.dirty) continue;
-
-                for(size_t j: {0, 1, 2})
-                {
-                    if(t.err[j] >= threshold)
-                    {
-                        continue;
-                    }
-                    int i0=t.v[ j     ]; Vertex &v0 = vertices[i0];
-                    int i1=t.v[(j+1)%3]; Vertex &v1 = vertices[i1];
-
-                    // Border check
-                    if(v0.border != v1.border)  continue;
-
-                    // Compute vertex to collapse to
-                    vec3f p;
-                    calculate_error(i0,i1,p);
-
-                    deleted0.resize(v0.tcount); // normals temporarily
-                    deleted1.resize(v1.tcount); // normals temporarily
-
-                    // don't remove if flipped
-                    if( flipped(p,i0,i1,v0,v1,deleted0) ) continue;
-                    if( flipped(p,i1,i0,v1,v0,deleted1) ) continue;
-
-                    if ( (t.attr & TEXCOORD) == TEXCOORD )
-                    {
-                        update_uvs(i0,v0,p,deleted0);
-                        update_uvs(i0,v1,p,deleted1);
-                    }
-
-                    // not flipped, so remove edge
-                    v0.p=p;
-                    v0.q=v1.q+v0.q;
-                    size_t tstart = refs.size();
-
-                    update_triangles(i0,v0,deleted0,deleted_triangles);
-                    update_triangles(i0,v1,deleted1,deleted_triangles);
-
-                    size_t tcount = refs.size() - tstart;
-
-                    if(tcount <= v0.tcount)
-                    {
-                        // save ram
-                        if(tcount)memcpy(&refs[v0.tstart],&refs[tstart],tcount*sizeof(Ref));
-                    }
-                    else
-                        // append
-                        v0.tstart=tstart;
-
-                    v0.tcount=tcount;
-                    break;
-                }
+                heap[pos[id]].key = k;
+                sift_up(pos[id]);
             }
-            if(deleted_triangles<=0)break;
-            deleted_triangles=0;
-        } //for each iteration
-        // clean up mesh
-        compact_mesh();
-    } //simplify_mesh_lossless()
+        }
 
+        void remove(int id)
+        {
+            int i = pos[id];
+            if(i < 0) return;
+            Entry last = heap.back();
+            heap.pop_back();
+            pos[id] = -1;
+            if(last.id == id) return;
+            heap[i] = last;
+            pos[last.id] = i;
+            sift_up(i);
+            sift_down(pos[last.id]);
+        }
 
-    // Check if a triangle flips when this edge is removed
+    private:
+        struct Entry { double key; int id; };
 
-    bool flipped(vec3f p,int i0,int i1,Vertex &v0,Vertex &v1,std::vector<int> &deleted)
-    {
-        (void)i0; // unused
-        (void)v1; // unused
+        void place(int i, const Entry &e) { heap[i] = e; pos[e.id] = i; }
 
-        for(size_t k = 0; k < v0.tcount; ++k)
+        void sift_up(int i)
         {
-            Triangle &t=triangles[refs[v0.tstart+k].tid];
-            if(t.deleted)continue;
-
-            int s=refs[v0.tstart+k].tvertex;
-            int id1=t.v[(s+1)%3];
-            int id2=t.v[(s+2)%3];
-
-            if(id1==i1 || id2==i1) // delete ?
+            Entry e = heap[i];
+            while(i > 0)
             {
-
-                deleted[k]=1;
-                continue;
+                int parent = (i-1)/4;
+                if(heap[parent].key <= e.key) break;
+                place(i, heap[parent]);
+                i = parent;
             }
-            vec3f d1 = vertices[id1].p-p; d1.normalize();
-            vec3f d2 = vertices[id2].p-p; d2.normalize();
-            if(fabs(d1.dot(d2))>0.999) return true;
-            vec3f n;
-            n.cross(d1,d2);
-            n.normalize();
-            deleted[k]=0;
-            if(n.dot(t.n)<0.2) return true;
+            place(i, e);
         }
-        return false;
-    }
 
-    // update_uvs
-
-    void update_uvs(int i0,const Vertex &v,const vec3f &p,std::vector<int> &deleted)
-    {
-        (void)i0; // unused
-        for(size_t k = 0; k < v.tcount; ++k)
+        void sift_down(int i)
         {
-            Ref &r=refs[v.tstart+k];
-            Triangle &t=triangles[r.tid];
-            if(t.deleted)continue;
-            if(deleted[k])continue;
-            vec3f p1=vertices[t.v[0]].p;
-            vec3f p2=vertices[t.v[1]].p;
-            vec3f p3=vertices[t.v[2]].p;
-            t.uvs[r.tvertex] = interpolate(p,p1,p2,p3,t.uvs);
+            Entry e = heap[i];
+            int n = heap.size();
+            for(;;)
+            {
+                int first = 4*i+1;
+                if(first >= n) break;
+                int last = first+4 < n ? first+4 : n;
+                int child = first;
+                for(int c = first+1; c < last; ++c)
+                {
+                    if(heap[c].key < heap[child].key) child = c;
+                }
+                if(e.key <= heap[child].key) break;
+                place(i, heap[child]);
+                i = child;
+            }
+            place(i, e);
         }
-    }
 
-    // Update triangle connections and edge error after a edge is collapsed
+        std::vector<Entry> heap;   // heap-ordered keys and ids
+        std::vector<int> pos;      // position of each id in heap, -1 if not present
+        std::vector<double> value; // current error of each id
+    };
 
-    void update_triangles(int i0,Vertex &v,std::vector<int> &deleted,int &deleted_triangles)
+    //
+    // View of a whole file, memory mapped so that only the pages that are
+    // accessed are read and they can be dropped again by the system under
+    // memory pressure. open() maps an existing file read-only, create()
+    // maps a new file of the given size for reading and writing, so that
+    // large working arrays can be paged out to disk.
+    //
+    class FileView
     {
-        vec3f p;
-        for(size_t k = 0; k < v.tcount; ++k)
-        {
-            Ref &r=refs[v.tstart+k];
-            Triangle &t=triangles[r.tid];
-            if(t.deleted)continue;
-            if(deleted[k])
-            {
-                t.deleted=1;
-                deleted_triangles++;
-                continue;
-            }
-            t.v[r.tvertex]=i0;
-            t.dirty=1;
-            t.err[0]=calculate_error(t.v[0],t.v[1],p);
-            t.err[1]=calculate_error(t.v[1],t.v[2],p);
-            t.err[2]=calculate_error(t.v[2],t.v[0],p);
-            t.err[3]=min(t.err[0],min(t.err[1],t.err[2]));
-            refs.push_back(r);
-        }
-    }
+    public:
+        const char* data = NULL;
+        size_t size = 0;
 
-    // compact triangles, compute edge error and build reference list
+        FileView() {}
+        ~FileView() { close(); }
 
-    void update_mesh(int iteration)
-    {
-        if(iteration>0) // compact triangles
+        bool open(const char* filename)
         {
-            int dst=0;
-            for (Triangle &t: triangles)
+            close();
+#if defined(_WIN32)
+            HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER length;
+            bool ok = GetFileSizeEx(file, &length) != 0 && uint64_t(length.QuadPart) <= uint64_t(SIZE_MAX);
+            if (ok && length.QuadPart > 0)
             {
-                if(t.deleted)
+                HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+                void* p = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+                if (mapping) CloseHandle(mapping); // the view stays valid
+                ok = p != NULL;
+                if (ok)
                 {
-                    continue;
+                    data = (const char*)p;
+                    size = size_t(length.QuadPart);
                 }
-                triangles[dst] = t;
-                dst++;
             }
-            triangles.resize(dst);
-        }
-        //
-        // Init Quadrics by Plane & Edge Errors
-        //
-        // required at the beginning ( iteration == 0 )
-        // recomputing during the simplification is not required,
-        // but mostly improves the result for closed meshes
-        //
-        if( iteration == 0 )
-        {
-            for(Vertex& v: vertices)
+            CloseHandle(file);
+            return ok;
+#else
+            int fd = ::open(filename, O_RDONLY);
+            if (fd < 0) return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0)
             {
-                v.q = SymetricMatrix(0.0);
+                ::close(fd);
+                return false;
             }
-
-            for(Triangle& t: triangles)
+            if (st.st_size > 0)
             {
-                vec3f n,p[3];
-                for(size_t j: {0, 1, 2})
-                {
-                    p[j] = vertices[t.v[j]].p;
-                }
-                n.cross(p[1]-p[0],p[2]-p[0]);
-                n.normalize();
-                t.n=n;
-                for(size_t j: {0, 1, 2})
+                void* p = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED)
                 {
-                    vertices[t.v[j]].q = vertices[t.v[j]].q+SymetricMatrix(n.x,n.y,n.z,-n.dot(p[0]));
+                    ::close(fd);
+                    return false;
                 }
+                data = (const char*)p;
+                size = size_t(st.st_size);
             }
-            for(Triangle& t: triangles)
+            ::close(fd); // the mapping stays valid
+            return true;
+#endif
+        }
+
+        bool create(const char* filename, size_t length)
+        {
+            close();
+            if (length == 0) return false;
+#if defined(_WIN32)
+            HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            uint64_t size64 = uint64_t(length);
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, DWORD(size64 >> 32), DWORD(size64 & 0xffffffff), NULL);
+            void* p = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0) : NULL;
+            if (mapping) CloseHandle(mapping); // the view stays valid
+            CloseHandle(file);
+            if (!p) return false;
+#else
+            int fd = ::open(filename, O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (fd < 0) return false;
+            void* p = ftruncate(fd, off_t(length)) == 0 ? mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+            ::close(fd); // the mapping stays valid
+            if (p == MAP_FAILED) return false;
+#endif
+            data = (const char*)p;
+            size = length;
+            return true;
+        }
+
+        // Writable data of a view made by create()
+        char* writable() const { return const_cast<char*>(data); }
+
+        void close()
+        {
+            if (data)
             {
-                // Calc Edge Error
-                vec3f p;
-                for(size_t j: {0, 1, 2})
-                {
-                    t.err[j] = calculate_error(t.v[j],t.v[(j+1)%3],p);
-                }
-                t.err[3]=min(t.err[0],min(t.err[1],t.err[2]));
+#if defined(_WIN32)
+                UnmapViewOfFile(data);
+#else
+                munmap((void*)data, size);
+#endif
             }
+            data = NULL;
+            size = 0;
         }
 
-        // Init Reference ID list
-        for(Vertex& v: vertices)
+    private:
+        FileView(const FileView&) = delete;
+        FileView& operator=(const FileView&) = delete;
+    };
+
+    //
+    // Simplifier owns all mesh buffers, so independent instances can be used
+    // concurrently (e.g. one per worker thread). The buffers keep their capacity
+    // between runs, so reusing an instance for many meshes avoids reallocation.
+    //
+    // Real is the precision of vertex positions. Quadrics and errors are
+    // always computed in double precision; BasicSimplifier<float> only
+    // rounds the vertex positions, which makes vertices 40% smaller.
+    //
+    template<class Real>
+    class BasicSimplifier
+    {
+    public:
+        typedef BasicVertex<Real> Vertex;
+
+        std::vector<Triangle> triangles;
+        std::vector<TriangleAttributes> attributes; // per triangle, empty if there are no UVs and materials
+        std::vector<vec3f> normals;                 // per triangle
+        std::vector<Vertex> vertices;
+        std::vector<SymetricMatrix> quadrics;       // per vertex
+        std::vector<Ref> refs;
+        std::string mtllib;
+        std::vector<std::string> materials;
+        EdgeHeap heap; // edge errors for simplify_mesh_heap
+        // Number of threads used for parallel passes (0 = number of CPU cores)
+        int threads = 1;
+        // Vertices on the border of open surfaces (edges with a single
+        // triangle) are never moved or removed. Otherwise only border edges
+        // can be collapsed to border vertices, which lets the boundary
+        // shrink or get simplified.
+        bool preserve_border = false;
+        // Optional per-vertex flag, vertices with nonzero flag are never
+        // moved or removed. Empty if no vertices are locked.
+        std::vector<char> locked;
+        // Index of each vertex in the mesh after the last compact_mesh(),
+        // -1 if the vertex was removed.
+        std::vector<int> vertex_remap;
+        // Optional per-vertex values (e.g. point data arrays), vertex_data_size
+        // values per vertex. They are interpolated along each collapsed edge,
+        // values with nonzero vertex_data_discrete flag (e.g. labels) are
+        // taken from the nearer vertex instead. Empty if there are no values.
+        std::vector<double> vertex_data;
+        int vertex_data_size = 0;
+        std::vector<char> vertex_data_discrete;
+        // Optional callback, called with the completed fraction (0..1) of
+        // the current simplify_mesh* run from the calling thread. If it
+        // returns false then the run stops early, leaving a valid but less
+        // reduced mesh, and aborted is set.
+        std::function<bool(double)> progress;
+        bool aborted = false;
+        // Optional callback that receives the messages of the simplifier
+        // (verbose output, statistics, file errors), otherwise they are
+        // printed to stdout. Simplifiers that run concurrently can collect
+        // their messages separately.
+        std::function<void(const char*)> log;
+        // Seconds spent in each phase (load, init, collapse, update,
+        // compact, write, ...) and number of edge collapses, accumulated
+        // until cleared by the caller
+        std::map<std::string,double> phase_seconds;
+        size_t collapse_count = 0;
+        // If set, the next update_mesh(0) keeps the current quadrics instead
+        // of computing them from the triangles. simplify_mesh_parallel sets
+        // it for the seam pass, so that the error accumulated by the blocks
+        // is not lost, and passes the quadrics on to the blocks if it is
+        // set by the caller.
+        bool reuse_quadrics = false;
+        // Collapses with larger quadric error are not done (0 = no limit).
+        // The quadric error of a vertex is the sum of its squared distances
+        // to the planes of the input triangles merged into it, so the
+        // distance to each of these planes is at most sqrt(max_error).
+        double max_error = 0;
+        // Optional last check of each collapse, called with the vertices of
+        // the edge and the position of the merged vertex i0 before the mesh
+        // is changed. The collapse is skipped if it returns false (see
+        // ToleranceGuard in SimplifyDeviation.h). simplify_mesh_parallel
+        // runs serially if it is set, blocks have their own vertex ids.
+        std::function<bool(int,int,const vec3f&)> accept_collapse;
+
+        // Remove all mesh data but keep allocated memory for the next run
+        void clear()
         {
-            v.tstart=0;
-            v.tcount=0;
+            triangles.clear();
+            attributes.clear();
+            normals.clear();
+            vertices.clear();
+            quadrics.clear();
+            reuse_quadrics=false;
+            refs.clear();
+            mtllib.clear();
+            materials.clear();
+            locked.clear();
+            vertex_remap.clear();
+            vertex_data.clear();
+            vertex_data_size=0;
+            vertex_data_discrete.clear();
         }
-        for(Triangle& t: triangles)
+
+        bool is_locked(int i) const { return !locked.empty() && locked[i]; }
+
+        // Adds the time from construction to destruction to a phase
+        struct PhaseTimer
         {
-            for(size_t j: {0, 1, 2}) { vertices[t.v[j]].tcount++; }
+            BasicSimplifier &simplifier;
+            const char *phase;
+            std::chrono::steady_clock::time_point start;
+            PhaseTimer(BasicSimplifier &s, const char *name) : simplifier(s), phase(name), start(std::chrono::steady_clock::now()) {}
+            ~PhaseTimer() { simplifier.phase_seconds[phase]+=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count(); }
+        };
+
+        // Write a message (printf format) to log or stdout
+        void message(const char *format, ...) const
+        {
+            char text[1024];
+            va_list args;
+            va_start(args, format);
+            vsnprintf(text, sizeof(text), format, args);
+            va_end(args);
+            if(log) log(text);
+            else fputs(text, stdout);
         }
-        int tstart=0;
-        for(Vertex& v: vertices)
+
+        // Report progress, returns false if the run has to stop
+        bool report_progress(double fraction)
         {
-            v.tstart=tstart;
-            tstart+=v.tcount;
-            v.tcount=0;
+            if(progress && !aborted && !progress(fmin(1.0,fmax(0.0,fraction)))) aborted=true;
+            return !aborted;
         }
 
-        // Write References
-        refs.resize(triangles.size()*3);
-        for (size_t i = 0; i < triangles.size(); ++i)
+        void print_statistics() const
         {
-            Triangle &t = triangles[i];
-            for(size_t j: {0, 1, 2})
-            {
-                Vertex &v=vertices[t.v[j]];
-                refs[v.tstart+v.tcount].tid=i;
-                refs[v.tstart+v.tcount].tvertex=j;
-                v.tcount++;
-            }
+            for(const auto &phase: phase_seconds) message("%s %.3f s\n",phase.first.c_str(),phase.second);
+            message("collapses %zu\n",collapse_count);
         }
 
-        // Identify boundary : vertices[].border=0,1
-        if( iteration == 0 )
+        //
+        // Main simplification function
+        //
+        // target_count  : target nr. of triangles
+        // agressiveness : sharpness to increase the threshold.
+        //                 5..8 are good numbers
+        //                 more iterations yield higher quality
+        //
+
+        void simplify_mesh(int target_count, double agressiveness=7, bool verbose=false)
         {
-            std::vector<int> vcount,vids;
+            simplify_mesh_lods(std::vector<int>(1,target_count),[](size_t){},agressiveness,verbose);
+        } //simplify_mesh()
 
-            for(Vertex& v: vertices)
-            {
-                v.border=0;
-            }
+        //
+        // Simplify to several levels of detail in one run
+        //
+        // target_counts : decreasing target nr. of triangles
+        // on_lod(k)     : called when target_counts[k] is reached, with the
+        //                 mesh compacted (as after simplify_mesh). It may read
+        //                 or copy the mesh, simplification then continues
+        //                 from this mesh with the accumulated quadrics.
+        //
 
-            for(Vertex& v: vertices)
+        template<class F>
+        void simplify_mesh_lods(const std::vector<int>& target_counts, F on_lod, double agressiveness=7, bool verbose=false)
+        {
+            if(target_counts.empty()) return;
+
+            // init
+            for(Triangle& t: triangles) { t.deleted=0; }
+            aborted=false;
+            int start_count=triangles.size();
+
+            // main iteration loop
+            int deleted_triangles=0;
+            std::vector<int> deleted0,deleted1;
+            int triangle_count=triangles.size();
+            size_t lod=0;
+            int target_count=target_counts[0];
+            bool compacted=false; // refs must be rebuilt
+            int lod_iteration=0;  // first iteration of the current level
+            //int iteration = 0;
+            //loop(iteration,0,100)
+            for (int iteration = 0; iteration-lod_iteration < 100; iteration ++)
             {
-                vcount.clear();
-                vids.clear();
-                for(size_t j = 0; j < v.tcount; ++j)
+                // intermediate level reached ?
+                while(triangle_count-deleted_triangles<=target_count && lod+1<target_counts.size())
+                {
+                    compact_mesh();
+                    on_lod(lod);
+                    target_count=target_counts[++lod];
+                    triangle_count=triangles.size();
+                    deleted_triangles=0;
+                    compacted=true;
+                    lod_iteration=iteration;
+                }
+                if(triangle_count-deleted_triangles<=target_count)break;
+
+                // update mesh once in a while
+                if(iteration%5==0 || compacted)
+                {
+                    update_mesh(iteration);
+                    compacted=false;
+                }
+
+                // clear dirty flag
+                for(Triangle& triangle: triangles) { triangle.dirty=0; }
+
+                //
+                // All triangles with edges below the threshold will be removed
+                //
+                // The following numbers works well for most models.
+                // If it does not, try to adjust the 3 parameters
+                //
+                double threshold = 0.000000001*pow(double(iteration-lod_iteration+3),agressiveness);
+                bool at_max_error = max_error>0 && threshold>=max_error;
+                if(at_max_error) threshold=max_error;
+                int deleted_before=deleted_triangles;
+
+                // target number of triangles reached ? Then break
+                if ((verbose) && (iteration%5==0)) {
+                    message("iteration %d - triangles %d threshold %g\n",iteration,triangle_count-deleted_triangles, threshold);
+                }
+                if(!report_progress(double(start_count-(triangle_count-deleted_triangles))/std::max(start_count-target_counts.back(),1))) break;
+
+                // remove vertices & mark deleted triangles
+                PhaseTimer sweep_timer(*this,"collapse");
+                for(Triangle& t: triangles)
                 {
-                    int k=refs[v.tstart+j].tid;
-                    Triangle &t=triangles[k];
-                    for(size_t k: {0, 1, 2})
+                    if(t.err[3]>threshold) continue;
+                    if(t.deleted) continue;
+                    if(t.dirty) continue;
+
+                    for(size_t j: {0, 1, 2})
                     {
-                        size_t ofs=0;
-                        int id=t.v[k];
-                        while(ofs<vcount.size())
+                        if(t.err[j] >= threshold)
                         {
-                            if(vids[ofs]==id)break;
-                            ofs++;
+                            continue;
                         }
-                        if(ofs==vcount.size())
+
+                        int i0=t.v[ j     ]; Vertex &v0 = vertices[i0];
+                        int i1=t.v[(j+1)%3]; Vertex &v1 = vertices[i1];
+                        // Border check
+                        if(v0.border != v1.border)  continue;
+                        if(preserve_border && v0.border) continue;
+                        if(is_locked(i0) || is_locked(i1)) continue;
+                        reserve_refs(v0.tcount+v1.tcount);
+
+                        // Compute vertex to collapse to
+                        vec3f p;
+                        calculate_error(i0,i1,p);
+                        deleted0.resize(v0.tcount); // normals temporarily
+                        deleted1.resize(v1.tcount); // normals temporarily
+                        // don't remove if flipped
+                        if( flipped(p,i0,i1,v0,v1,deleted0) ) continue;
+
+                        if( flipped(p,i1,i0,v1,v0,deleted1) ) continue;
+                        if( accept_collapse && !accept_collapse(i0,i1,p) ) continue;
+
+                        if ( (t.attr & TEXCOORD) == TEXCOORD  )
+                        {
+                            update_uvs(i0,v0,p,deleted0);
+                            update_uvs(i0,v1,p,deleted1);
+                        }
+
+                        // not flipped, so remove edge
+                        update_vertex_data(i0,i1,p);
+                        v0.p=p;
+                        quadrics[i0]+=quadrics[i1];
+                        int tstart=refs.size();
+
+                        update_triangles(i0,v0,deleted0,deleted_triangles);
+                        update_triangles(i0,v1,deleted1,deleted_triangles);
+
+                        size_t tcount = refs.size() - tstart;
+
+                        if(tcount<=v0.tcount)
                         {
-                            vcount.push_back(1);
-                            vids.push_back(id);
+                            // save ram
+                            if(tcount)memcpy(&refs[v0.tstart],&refs[tstart],tcount*sizeof(Ref));
                         }
                         else
-                            vcount[ofs]++;
+                            // append
+                            v0.tstart=tstart;
+
+                        v0.tcount=tcount;
+                        v1.tcount=0; // removed, its references can be reused
+                        collapse_count++;
+                        break;
                     }
+                    // done?
+                    if(triangle_count-deleted_triangles<=target_count)break;
                 }
-                for(size_t j = 0; j < vcount.size(); ++j)
-                {
-                    if(vcount[j] == 1)
-                    {
-                        vertices[vids[j]].border = 1;
-                    }
-               }
+                // no more edges below the error limit
+                if(at_max_error && deleted_triangles==deleted_before)break;
             }
-        }
-    }
+            if (verbose) {
+                message("adjacency peak %zu bytes\n",refs.capacity()*sizeof(Ref));
+            }
+            // clean up mesh
+            compact_mesh();
+            if(aborted) return;
+            for(; lod<target_counts.size(); lod++) on_lod(lod);
+        } //simplify_mesh_lods()
 
-    // Finally compact mesh before exiting
+        //
+        // Remove all edges that can be removed without changing the shape.
+        // A collapse only changes the triangles around the two vertices of
+        // the edge, so after the first pass only the triangles around
+        // vertices changed by the previous pass are tried again, and the
+        // reference list is updated in place instead of being rebuilt.
+        //
 
-    void compact_mesh()
-    {
-        int dst=0;
-        for(Vertex& v: vertices)
-        {
-            v.tcount = 0;
-        }
-        for(Triangle& t: triangles)
-        {
-            if(t.deleted)
-            {
-                continue;
-            }
-            triangles[dst++]=t;
-            for(size_t j: {0, 1, 2}) { vertices[t.v[j]].tcount=1; }
-        }
-        triangles.resize(dst);
-        dst=0;
-        for(Vertex& v: vertices)
+        void simplify_mesh_lossless(bool verbose=false)
         {
-            if(v.tcount == 0)
+            // init
+            for(Triangle& t: triangles) { t.deleted=0; t.dirty=0; }
+            aborted=false;
+            update_mesh(0);
+
+            // main iteration loop
+            int deleted_triangles=0;
+            std::vector<int> deleted0,deleted1;
+            std::vector<int> candidates(triangles.size()); // triangles to try, in mesh order
+            for (size_t i = 0; i < candidates.size(); ++i) candidates[i]=i;
+            std::vector<char> touched(vertices.size(),0);
+            std::vector<int> touched_vertices;
+            std::vector<char> queued(triangles.size(),0);
+            for (int iteration = 0; iteration < 9999 && !candidates.empty(); iteration ++)
             {
-                continue;
-            }
-            v.tstart=dst;
-            vertices[dst].p=v.p;
-            dst++;
-        }
-        for(Triangle& t: triangles)
-        {
-            for(size_t j: {0, 1, 2}) { t.v[j]=vertices[t.v[j]].tstart; }
-        }
-        vertices.resize(dst);
-    }
+                // clear dirty flag, triangles changed in the last pass are candidates
+                for(int tid: candidates) { triangles[tid].dirty=0; }
+                //
+                // All triangles with edges below the threshold will be removed
+                //
+                // The following numbers works well for most models.
+                // If it does not, try to adjust the 3 parameters
+                //
+                double threshold = DBL_EPSILON; //1.0E-3 EPS;
+                if (verbose) {
+                    message("lossless iteration %d - candidates %zu\n", iteration, candidates.size());
+                }
+                // the number of candidates decreases from pass to pass
+                if(!report_progress(1.0-double(candidates.size())/triangles.size())) break;
 
-    // Error between vertex and Quadric
+                // remove vertices & mark deleted triangles
+                PhaseTimer sweep_timer(*this,"collapse");
+                for(int tid: candidates)
+                {
+                    Triangle &t=triangles[tid];
+                    if(t.err[3]>threshold) continue;
+                    if(t.deleted) continue;
+                    if(t.dirty) continue;
 
-    double vertex_error(SymetricMatrix q, double x, double y, double z)
-    {
-         return   q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x + q[4]*y*y
-              + 2*q[5]*y*z + 2*q[6]*y + q[7]*z*z + 2*q[8]*z + q[9];
-    }
+                    for(size_t j: {0, 1, 2})
+                    {
+                        if(t.err[j] >= threshold)
+                        {
+                            continue;
+                        }
+                        int i0=t.v[ j     ]; Vertex &v0 = vertices[i0];
+                        int i1=t.v[(j+1)%3]; Vertex &v1 = vertices[i1];
 
-    // Error for one edge
+                        // Border check
+                        if(v0.border != v1.border)  continue;
+                        if(preserve_border && v0.border) continue;
+                        if(is_locked(i0) || is_locked(i1)) continue;
+                        reserve_refs(v0.tcount+v1.tcount);
 
-    double calculate_error(int id_v1, int id_v2, vec3f &p_result)
-    {
-        // compute interpolated vertex
+                        // Compute vertex to collapse to
+                        vec3f p;
+                        calculate_error(i0,i1,p);
 
-        SymetricMatrix q = vertices[id_v1].q + vertices[id_v2].q;
-        bool   border = vertices[id_v1].border & vertices[id_v2].border;
-        double error=0;
-        double det = q.det(0, 1, 2, 1, 4, 5, 2, 5, 7);
-        if ( det != 0 && !border )
-        {
+                        deleted0.resize(v0.tcount); // normals temporarily
+                        deleted1.resize(v1.tcount); // normals temporarily
 
-            // q_delta is invertible
-            p_result.x = -1/det*(q.det(1, 2, 3, 4, 5, 6, 5, 7 , 8));    // vx = A41/det(q_delta)
-            p_result.y =  1/det*(q.det(0, 2, 3, 1, 5, 6, 2, 7 , 8));    // vy = A42/det(q_delta)
-            p_result.z = -1/det*(q.det(0, 1, 3, 1, 4, 6, 2, 5,  8));    // vz = A43/det(q_delta)
+                        // don't remove if flipped
+                        if( flipped(p,i0,i1,v0,v1,deleted0) ) continue;
+                        if( flipped(p,i1,i0,v1,v0,deleted1) ) continue;
+                        if( accept_collapse && !accept_collapse(i0,i1,p) ) continue;
 
-            error = vertex_error(q, p_result.x, p_result.y, p_result.z);
-        }
-        else
-        {
-            // det = 0 -> try to find best result
-            vec3f p1=vertices[id_v1].p;
-            vec3f p2=vertices[id_v2].p;
-            vec3f p3=(p1+p2)/2;
-            double error1 = vertex_error(q, p1.x,p1.y,p1.z);
-            double error2 = vertex_error(q, p2.x,p2.y,p2.z);
-            double error3 = vertex_error(q, p3.x,p3.y,p3.z);
-            error = min(error1, min(error2, error3));
-            if (error1 == error) p_result=p1;
-            if (error2 == error) p_result=p2;
-            if (error3 == error) p_result=p3;
-        }
-        return error;
-    }
+                        // the triangles around these vertices may be collapsible now
+                        touch_neighbors(v0,touched,touched_vertices);
+                        touch_neighbors(v1,touched,touched_vertices);
 
-    char *trimwhitespace(char *str)
-    {
-        char *end;
+                        if ( (t.attr & TEXCOORD) == TEXCOORD )
+                        {
+                            update_uvs(i0,v0,p,deleted0);
+                            update_uvs(i0,v1,p,deleted1);
+                        }
+
+                        // not flipped, so remove edge
+                        update_vertex_data(i0,i1,p);
+                        v0.p=p;
+                        quadrics[i0]+=quadrics[i1];
+                        size_t tstart = refs.size();
 
-        // Trim leading space
-        while(isspace((unsigned char)*str)) str++;
+                        update_triangles(i0,v0,deleted0,deleted_triangles);
+                        update_triangles(i0,v1,deleted1,deleted_triangles);
 
-        if(*str == 0)  // All spaces?
-        return str;
+                        size_t tcount = refs.size() - tstart;
+
+                        if(tcount <= v0.tcount)
+                        {
+                            // save ram
+                            if(tcount)memcpy(&refs[v0.tstart],&refs[tstart],tcount*sizeof(Ref));
+                        }
+                        else
+                            // append
+                            v0.tstart=tstart;
 
-        // Trim trailing space
-        end = str + strlen(str) - 1;
-        while(end > str && isspace((unsigned char)*end)) end--;
+                        v0.tcount=tcount;
+                        v1.tcount=0; // removed, its references can be reused
+                        collapse_count++;
+                        break;
+                    }
+                }
+                if(deleted_triangles<=0)break;
+                deleted_triangles=0;
 
-        // Write new null terminator
-        *(end+1) = 0;
+                // next candidates: the triangles around changed vertices,
+                // in mesh order (a scan of all flags is faster for many)
+                candidates.clear();
+                for(int i: touched_vertices)
+                {
+                    const Vertex &v=vertices[i];
+                    for(size_t k = 0; k < v.tcount; ++k)
+                    {
+                        int tid=refs[v.tstart+k].tid;
+                        if(triangles[tid].deleted || queued[tid]) continue;
+                        queued[tid]=1;
+                        candidates.push_back(tid);
+                    }
+                    touched[i]=0;
+                }
+                touched_vertices.clear();
+                if(candidates.size()*16<triangles.size())
+                {
+                    std::sort(candidates.begin(),candidates.end());
+                }
+                else
+                {
+                    candidates.clear();
+                    for (size_t i = 0; i < triangles.size(); ++i)
+                    {
+                        if(queued[i]) candidates.push_back(i);
+                    }
+                }
+                for(int tid: candidates) { queued[tid]=0; }
+            } //for each iteration
+            if (verbose) {
+                message("adjacency peak %zu bytes\n",refs.capacity()*sizeof(Ref));
+            }
+            // clean up mesh
+            compact_mesh();
+        } //simplify_mesh_lossless()
 
-        return str;
-    }
+        //
+        // Alternative to simplify_mesh: edges are collapsed in strict order of
+        // increasing quadric error, using an indexed min-heap keyed by the
+        // smallest edge error of each triangle. After each collapse only the
+        // triangles around the surviving vertex are re-keyed, so the cost is
+        // proportional to the number of collapses instead of
+        // number of passes * number of triangles.
+        //
+        // target_count  : target nr. of triangles
+        //
 
-    //Option : Load OBJ
-    void load_obj(const char* filename, bool process_uv=false){
-        vertices.clear();
-        triangles.clear();
-        //printf ( "Loading Objects %s ... \n",filename);
-        FILE* fn;
-        if(filename==NULL)        return ;
-        if((char)filename[0]==0)    return ;
-        if ((fn = fopen(filename, "rb")) == NULL)
-        {
-            printf ( "File %s not found!\n" ,filename );
-            return;
-        }
-        char line[1000];
-        memset ( line,0,1000 );
-        int vertex_cnt = 0;
-        int material = -1;
-        std::map<std::string, int> material_map;
-        std::vector<vec3f> uvs;
-        std::vector<std::vector<int> > uvMap;
-
-        while(fgets( line, 1000, fn ) != NULL)
+        void simplify_mesh_heap(int target_count, bool verbose=false)
         {
-            Vertex v;
-            vec3f uv;
+            // init
+            for(Triangle& t: triangles) { t.deleted=0; t.dirty=0; }
+            aborted=false;
+            update_mesh(0);
 
-            if (strncmp(line, "mtllib", 6) == 0)
-            {
-                mtllib = trimwhitespace(&line[7]);
-            }
-            if (strncmp(line, "usemtl", 6) == 0)
             {
-                std::string usemtl = trimwhitespace(&line[7]);
-                if (material_map.find(usemtl) == material_map.end())
+                PhaseTimer timer(*this,"init");
+                heap.reset(triangles.size());
+                for (size_t i = 0; i < triangles.size(); ++i)
                 {
-                    material_map[usemtl] = materials.size();
-                    materials.push_back(usemtl);
+                    heap.update(i, triangles[i].err[3]);
                 }
-                material = material_map[usemtl];
             }
 
-            if ( line[0] == 'v' && line[1] == 't' )
+            int deleted_triangles=0;
+            int triangle_count=triangles.size();
+            std::vector<int> deleted0,deleted1;
+            size_t collapses=0;
             {
-                if ( line[2] == ' ' )
+                PhaseTimer timer(*this,"collapse");
+                while(triangle_count-deleted_triangles>target_count && !heap.empty())
                 {
-                    if(sscanf(line,"vt %lf %lf",
-                        &uv.x,&uv.y)==2)
-                    {
-                        uv.z = 0;
-                        uvs.push_back(uv);
-                    } else
-                    if(sscanf(line,"vt %lf %lf %lf",
-                        &uv.x,&uv.y,&uv.z)==3)
+                    if(max_error>0 && heap.top_key()>max_error) break;
+                    int tid=heap.top();
+                    Triangle &t=triangles[tid];
+
+                    // cheapest edge that has not been rejected yet;
+                    // t.dirty holds a bit mask of rejected edges in this mode
+                    int j=-1;
+                    for(int e: {0, 1, 2})
                     {
-                        uvs.push_back(uv);
+                        if(t.dirty & (1<<e)) continue;
+                        if(j<0 || t.err[e]<t.err[j]) j=e;
                     }
-                }
-            }
-            else if ( line[0] == 'v' )
-            {
-                if ( line[1] == ' ' )
-                {
-                    if(sscanf(line,"v %lf %lf %lf",
-                        &v.p.x,    &v.p.y,    &v.p.z)==3)
+                    if(!try_collapse_heap_edge(t,j,deleted0,deleted1,deleted_triangles))
                     {
-                        vertices.push_back(v);
+                        // the edge is retried when a collapse changes the
+                        // triangles around one of its vertices
+                        t.dirty |= 1<<j;
+                        heap_update_triangle(tid);
+                        continue;
+                    }
+                    collapses++;
+                    if (verbose && collapses%100000==0) {
+                        message("collapses %zu - triangles %d error %g\n",collapses,triangle_count-deleted_triangles,heap.empty()?0.0:heap.top_key());
                     }
+                    if(collapses%10000==0 && !report_progress(double(deleted_triangles)/std::max(triangle_count-target_count,1))) break;
                 }
             }
-            int integers[9];
-            if ( line[0] == 'f' )
+            if (verbose) {
+                message("collapses %zu - triangles %d\n",collapses,triangle_count-deleted_triangles);
+                message("adjacency peak %zu bytes\n",refs.capacity()*sizeof(Ref));
+            }
+            // clean up mesh
+            compact_mesh();
+        } //simplify_mesh_heap()
+
+        //
+        // Multi-threaded variant of simplify_mesh. Triangles are split into
+        // thread_count spatial blocks (recursive median split of triangle
+        // centers along the longest axis), each block is simplified
+        // concurrently while vertices shared with other blocks are locked,
+        // then a final simplify_mesh pass on the merged mesh removes the
+        // remaining triangles along the seams. The seam pass continues with
+        // the quadrics of the blocks (the quadric of a seam vertex is the sum
+        // of its quadrics in the blocks), so it has the same error
+        // information as simplify_mesh. locked and vertex_remap refer to the
+        // vertices of the input and output mesh as after simplify_mesh.
+        //
+        // target_count  : target nr. of triangles
+        // thread_count  : number of blocks/threads, 0 = number of CPU cores
+        //
+
+        void simplify_mesh_parallel(int target_count, int thread_count, double agressiveness=7, bool verbose=false)
+        {
+            if(thread_count<=0) thread_count=std::thread::hardware_concurrency();
+            // blocks must be large enough so that seams don't dominate
+            int max_blocks=triangles.size()/10000;
+            if(thread_count>max_blocks) thread_count=max_blocks;
+            if(thread_count<=1 || accept_collapse)
+            {
+                simplify_mesh(target_count,agressiveness,verbose);
+                return;
+            }
+
+            // Quadrics kept by the caller are copied into the blocks
+            bool inherit_quadrics=reuse_quadrics && quadrics.size()==vertices.size();
+            reuse_quadrics=false;
+
+            // Split triangles into blocks
+            std::vector<vec3f> centers(triangles.size());
+            std::vector<int> order(triangles.size());
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                const Triangle &t=triangles[i];
+                centers[i]=(vec3f(vertices[t.v[0]].p)+vertices[t.v[1]].p+vertices[t.v[2]].p)/3;
+                order[i]=i;
+            }
+            std::vector<size_t> block_start;
+            split_blocks(centers,order,0,order.size(),thread_count,block_start);
+            block_start.push_back(order.size());
+
+            // Vertices used by more than one block are locked
+            std::vector<int> vertex_block(vertices.size(),-1);
+            std::vector<char> seam(vertices.size(),0);
+            for (int b = 0; b < thread_count; ++b)
+            {
+                for (size_t i = block_start[b]; i < block_start[b+1]; ++i)
+                {
+                    for(int v: triangles[order[i]].v)
+                    {
+                        if(vertex_block[v]<0) vertex_block[v]=b;
+                        else if(vertex_block[v]!=b) seam[v]=1;
+                    }
+                }
+            }
+
+            // Copy blocks into separate simplifiers
+            // Seam triangles are left for the seam pass, so each block only
+            // reduces its interior triangles to the global reduction ratio
+            double ratio=double(target_count)/triangles.size();
+            std::vector<BasicSimplifier> parts(thread_count);
+            std::vector<int> part_targets(thread_count);
+            std::vector<std::vector<int> > part_vertex_ids(thread_count);
+            std::vector<int> local(vertices.size(),-1);
+            for (int b = 0; b < thread_count; ++b)
             {
-                Triangle t;
-                bool tri_ok = false;
-                bool has_uv = false;
+                BasicSimplifier &part=parts[b];
+                std::vector<int> &ids=part_vertex_ids[b];
+                part.max_error=max_error;
+                part.preserve_border=preserve_border;
+                part.vertex_data_size=vertex_data_size;
+                part.vertex_data_discrete=vertex_data_discrete;
+                int seam_triangles=0;
+                for (size_t i = block_start[b]; i < block_start[b+1]; ++i)
+                {
+                    Triangle t=triangles[order[i]];
+                    if(seam[t.v[0]] || seam[t.v[1]] || seam[t.v[2]]) seam_triangles++;
+                    for(size_t j: {0, 1, 2})
+                    {
+                        int &l=local[t.v[j]];
+                        if(l<0)
+                        {
+                            l=ids.size();
+                            ids.push_back(t.v[j]);
+                            part.vertices.push_back(vertices[t.v[j]]);
+                            part.locked.push_back(seam[t.v[j]] || is_locked(t.v[j]));
+                            if(inherit_quadrics) part.quadrics.push_back(quadrics[t.v[j]]);
+                            if(!vertex_data.empty())
+                            {
+                                const double *d=&vertex_data[size_t(t.v[j])*vertex_data_size];
+                                part.vertex_data.insert(part.vertex_data.end(),d,d+vertex_data_size);
+                            }
+                        }
+                        t.v[j]=l;
+                    }
+                    part.triangles.push_back(t);
+                    if(!attributes.empty()) part.attributes.push_back(attributes[order[i]]);
+                }
+                for(int id: ids) local[id]=-1;
+                part.reuse_quadrics=inherit_quadrics;
+                part_targets[b]=round((part.triangles.size()-seam_triangles)*ratio)+seam_triangles;
+            }
+
+            // Simplify blocks concurrently. Their progress is collected and
+            // reported from this thread, which also stops them on abort.
+            aborted=false;
+            std::vector<std::atomic<double> > part_progress(thread_count);
+            std::atomic<bool> stop_parts(false);
+            std::atomic<int> finished_parts(0);
+            std::vector<std::thread> threads;
+            {
+                PhaseTimer timer(*this,"blocks");
+                for (int b = 0; b < thread_count; ++b)
+                {
+                    part_progress[b]=0;
+                    if(progress)
+                    {
+                        parts[b].progress=[&part_progress,&stop_parts,b](double fraction)
+                        {
+                            part_progress[b]=fraction;
+                            return !stop_parts;
+                        };
+                    }
+                    threads.push_back(std::thread([&parts,&part_targets,&finished_parts,b,agressiveness]()
+                    {
+                        BasicSimplifier &part=parts[b];
+                        part.simplify_mesh(part_targets[b],agressiveness,false);
+                        // quadrics are not computed if there was nothing to do
+                        if(part.quadrics.size()!=part.vertices.size()) part.update_mesh(0);
+                        finished_parts++;
+                    }));
+                }
+                while(progress && finished_parts<thread_count)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    double fraction=0;
+                    for (int b = 0; b < thread_count; ++b) fraction+=part_progress[b];
+                    if(!report_progress(0.8*fraction/thread_count)) stop_parts=true;
+                }
+                for(std::thread &thread: threads) thread.join();
+            }
+
+            // Merge blocks, seam vertices are shared between them
+            triangles.clear();
+            attributes.clear();
+            std::vector<Vertex> merged;
+            std::vector<SymetricMatrix> merged_quadrics;
+            std::vector<char> merged_locked;
+            std::vector<double> merged_data;
+            std::vector<int> seam_id(vertices.size(),-1);
+            std::vector<int> input_remap(vertices.size(),-1); // merged vertex of each input vertex
+            for (int b = 0; b < thread_count; ++b)
+            {
+                BasicSimplifier &part=parts[b];
+                const std::vector<int> &ids=part_vertex_ids[b];
+                std::vector<int> merged_id(part.vertices.size());
+                for (size_t l = 0; l < ids.size(); ++l)
+                {
+                    int c=part.vertex_remap[l];
+                    if(c<0) continue;
+                    if(seam[ids[l]] && seam_id[ids[l]]>=0)
+                    {
+                        // seam vertices are locked, so the block only added
+                        // the planes of its own triangles (or kept the
+                        // inherited quadric, which is the same in all blocks)
+                        merged_id[c]=seam_id[ids[l]];
+                        if(!inherit_quadrics) merged_quadrics[merged_id[c]]+=part.quadrics[c];
+                        continue;
+                    }
+                    if(seam[ids[l]]) seam_id[ids[l]]=merged.size();
+                    merged_id[c]=merged.size();
+                    merged.push_back(part.vertices[c]);
+                    merged_quadrics.push_back(part.quadrics[c]);
+                    if(!locked.empty()) merged_locked.push_back(locked[ids[l]]);
+                    if(!vertex_data.empty())
+                    {
+                        const double *d=&part.vertex_data[size_t(c)*vertex_data_size];
+                        merged_data.insert(merged_data.end(),d,d+vertex_data_size);
+                    }
+                }
+                for (size_t l = 0; l < ids.size(); ++l)
+                {
+                    int c=part.vertex_remap[l];
+                    if(c>=0) input_remap[ids[l]]=merged_id[c];
+                }
+                for (size_t i = 0; i < part.triangles.size(); ++i)
+                {
+                    Triangle t=part.triangles[i];
+                    for(size_t j: {0, 1, 2}) { t.v[j]=merged_id[t.v[j]]; }
+                    triangles.push_back(t);
+                    if(!part.attributes.empty()) attributes.push_back(part.attributes[i]);
+                }
+                if (verbose) {
+                    message("block %d - triangles %zu -> %zu\n",b,block_start[b+1]-block_start[b],part.triangles.size());
+                }
+            }
+            vertices.swap(merged);
+            quadrics.swap(merged_quadrics);
+            if(!locked.empty()) locked.swap(merged_locked);
+            if(!vertex_data.empty()) vertex_data.swap(merged_data);
+            for(const BasicSimplifier &part: parts) collapse_count+=part.collapse_count;
+            if(aborted)
+            {
+                vertex_remap.swap(input_remap);
+                return;
+            }
+
+            // Seam pass, starting from the quadrics of the blocks
+            std::function<bool(double)> block_progress=progress;
+            if(block_progress) progress=[&block_progress](double fraction) { return block_progress(0.8+0.2*fraction); };
+            reuse_quadrics=true;
+            simplify_mesh(target_count,agressiveness,verbose);
+            progress=block_progress;
+
+            // Output vertex of each input vertex
+            for(int &id: input_remap)
+            {
+                if(id>=0) id=vertex_remap[id];
+            }
+            vertex_remap.swap(input_remap);
+        } //simplify_mesh_parallel()
+
+        //
+        // Vertex clustering (Lindstrom: Out-of-core simplification of large
+        // polygonal models, 2000)
+        //
+        // Much faster than the edge collapse methods but lower quality and
+        // topology is not preserved, mainly useful for previews. Vertices are
+        // merged in the cells of a uniform grid, each cell is represented by
+        // the point minimizing the sum of the area-weighted quadrics of the
+        // triangles touching it (the average position of its vertices if that
+        // is not well defined). Triangles that become degenerate or duplicate
+        // are removed.
+        //
+        // target_count : approximate target nr. of triangles, used to choose
+        //                the cell size from the surface area
+        // cell_size    : edge length of grid cells, overrides target_count
+        //
+        // Locked vertices are kept. vertex_remap is set to the cluster of
+        // each input vertex. vertex_data of a cluster is copied from its
+        // vertex nearest to the representative point.
+        //
+
+        void simplify_mesh_clustering(int target_count, double cell_size=0, bool verbose=false)
+        {
+            aborted=false;
+            if(triangles.empty()) return;
+            if(cell_size<=0 && size_t(target_count)>=triangles.size()) return;
+            PhaseTimer timer(*this,"clustering");
+
+            // Bounds and surface area, per chunk of triangles
+            int chunk_count=worker_count(triangles.size(),10000);
+            std::vector<vec3f> chunk_lo(chunk_count,vec3f(DBL_MAX,DBL_MAX,DBL_MAX));
+            std::vector<vec3f> chunk_hi(chunk_count,vec3f(-DBL_MAX,-DBL_MAX,-DBL_MAX));
+            std::vector<double> chunk_area(chunk_count,0);
+            parallel_for(chunk_count, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    vec3f &lo=chunk_lo[c], &hi=chunk_hi[c];
+                    for (size_t i = triangles.size()*c/chunk_count; i < triangles.size()*(c+1)/chunk_count; ++i)
+                    {
+                        const Triangle &t=triangles[i];
+                        vec3f p[3],n;
+                        for(size_t j: {0, 1, 2})
+                        {
+                            p[j]=vertices[t.v[j]].p;
+                            lo.x=fmin(lo.x,p[j].x); lo.y=fmin(lo.y,p[j].y); lo.z=fmin(lo.z,p[j].z);
+                            hi.x=fmax(hi.x,p[j].x); hi.y=fmax(hi.y,p[j].y); hi.z=fmax(hi.z,p[j].z);
+                        }
+                        n.cross(p[1]-p[0],p[2]-p[0]);
+                        chunk_area[c]+=n.length()/2;
+                    }
+                }
+            }, 1);
+            vec3f lo=chunk_lo[0], hi=chunk_hi[0];
+            double area=0;
+            for (int c = 0; c < chunk_count; ++c)
+            {
+                lo.x=fmin(lo.x,chunk_lo[c].x); lo.y=fmin(lo.y,chunk_lo[c].y); lo.z=fmin(lo.z,chunk_lo[c].z);
+                hi.x=fmax(hi.x,chunk_hi[c].x); hi.y=fmax(hi.y,chunk_hi[c].y); hi.z=fmax(hi.z,chunk_hi[c].z);
+                area+=chunk_area[c];
+            }
+
+            // A closed mesh has about twice as many triangles as vertices, and
+            // a surface of area A crosses about 1.5*A/h^2 cells of size h
+            // (average over all orientations)
+            bool fixed_size=cell_size>0;
+            if(!fixed_size) cell_size=sqrt(3*area/std::max(target_count,2));
+            vec3f extent=hi-lo;
+            // cell coordinates are packed into 21 bits each
+            cell_size=fmax(cell_size,fmax(extent.x,fmax(extent.y,extent.z))/((1<<21)-1));
+            if(cell_size<=0) cell_size=1;
+
+            std::vector<uint64_t> keys(vertices.size());
+            std::vector<int> cluster(vertices.size());
+            std::vector<uint64_t> table;
+            std::vector<int> table_id;
+            int cluster_count=0;
+            for (int attempt = 0; attempt < 2; ++attempt)
+            {
+                // Cell of each vertex, locked vertices get their own cluster
+                parallel_for(vertices.size(), [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        if(is_locked(i))
+                        {
+                            keys[i]=(uint64_t(1)<<63)|i;
+                            continue;
+                        }
+                        vec3f p=vertices[i].p;
+                        uint64_t x=uint64_t(std::min(fmax(p.x-lo.x,0.0)/cell_size,double((1<<21)-1)));
+                        uint64_t y=uint64_t(std::min(fmax(p.y-lo.y,0.0)/cell_size,double((1<<21)-1)));
+                        uint64_t z=uint64_t(std::min(fmax(p.z-lo.z,0.0)/cell_size,double((1<<21)-1)));
+                        keys[i]=x|(y<<21)|(z<<42);
+                    }
+                });
+
+                // Number the occupied cells (open addressing hash table)
+                size_t table_size=64;
+                while(table_size<2*vertices.size()) table_size*=2;
+                int shift=64;
+                for (size_t s = table_size; s > 1; s/=2) shift--;
+                table.assign(table_size,~uint64_t(0));
+                table_id.resize(table_size);
+                cluster_count=0;
+                for (size_t i = 0; i < vertices.size(); ++i)
+                {
+                    size_t h=size_t((keys[i]*0x9E3779B97F4A7C15ull)>>shift);
+                    while(table[h]!=keys[i] && table[h]!=~uint64_t(0)) h=(h+1)&(table_size-1);
+                    if(table[h]!=keys[i])
+                    {
+                        table[h]=keys[i];
+                        table_id[h]=cluster_count++;
+                    }
+                    cluster[i]=table_id[h];
+                }
+
+                // Correct the cell size once if the estimate is far off
+                double ratio=double(cluster_count)/std::max(target_count/2,1);
+                if(fixed_size || attempt>0 || (ratio>0.8 && ratio<1.25)) break;
+                cell_size*=sqrt(ratio);
+                if (verbose) {
+                    message("clustering - %d clusters, retry with cell size %g\n",cluster_count,cell_size);
+                }
+            }
+            table.clear(); table.shrink_to_fit();
+            table_id.clear(); table_id.shrink_to_fit();
+            // the mesh is not changed until the triangles are remapped
+            if(!report_progress(0.4)) return;
+
+            // Sum of quadrics, positions and vertex counts per cluster. Each
+            // chunk of triangles and vertices adds to its own copy, the number
+            // of copies is limited so that they are not larger than the mesh.
+            struct Cluster { SymetricMatrix q; vec3f p=vec3f(0,0,0); int count=0; };
+            int part_count=worker_count(triangles.size(),10000);
+            part_count=std::max(1,std::min(part_count,int(triangles.size()/std::max(cluster_count,1))));
+            std::vector<std::vector<Cluster> > parts(part_count);
+            parallel_for(part_count, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    std::vector<Cluster> &part=parts[c];
+                    part.resize(cluster_count);
+                    for (size_t i = triangles.size()*c/part_count; i < triangles.size()*(c+1)/part_count; ++i)
+                    {
+                        const Triangle &t=triangles[i];
+                        int c0=cluster[t.v[0]], c1=cluster[t.v[1]], c2=cluster[t.v[2]];
+                        if(c0==c1 && c1==c2) continue; // inside one cell, plane is represented by its neighbors
+                        vec3f p[3],n;
+                        for(size_t j: {0, 1, 2}) { p[j]=vertices[t.v[j]].p; }
+                        n.cross(p[1]-p[0],p[2]-p[0]);
+                        double length=n.length();
+                        if(length==0) continue;
+                        double weight=sqrt(length/2); // area weighted quadric
+                        n=n*(weight/length);
+                        SymetricMatrix q(n.x,n.y,n.z,-n.dot(p[0]));
+                        part[c0].q+=q;
+                        if(c1!=c0) part[c1].q+=q;
+                        if(c2!=c0 && c2!=c1) part[c2].q+=q;
+                    }
+                    for (size_t i = vertices.size()*c/part_count; i < vertices.size()*(c+1)/part_count; ++i)
+                    {
+                        Cluster &k=part[cluster[i]];
+                        k.p=k.p+vertices[i].p;
+                        k.count++;
+                    }
+                }
+            }, 1);
+
+            // Representative point of each cluster
+            std::vector<Vertex> clustered(cluster_count);
+            parallel_for(cluster_count, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    Cluster &k=parts[0][i];
+                    for (int c = 1; c < part_count; ++c)
+                    {
+                        k.q+=parts[c][i].q;
+                        k.p=k.p+parts[c][i].p;
+                        k.count+=parts[c][i].count;
+                    }
+                    vec3f mean=k.p/std::max(k.count,1);
+                    vec3f p=mean;
+                    // The quadric is singular for flat regions and nearly so
+                    // for thin features; the minimum is then used only if it
+                    // is within the neighborhood of the cell.
+                    double det=k.q.det(0, 1, 2, 1, 4, 5, 2, 5, 7);
+                    double trace=k.q[0]+k.q[4]+k.q[7];
+                    if(det>1e-3*trace*trace*trace/27)
+                    {
+                        vec3f m(-1/det*(k.q.det(1, 2, 3, 4, 5, 6, 5, 7 , 8)),
+                                 1/det*(k.q.det(0, 2, 3, 1, 5, 6, 2, 7 , 8)),
+                                -1/det*(k.q.det(0, 1, 3, 1, 4, 6, 2, 5,  8)));
+                        vec3f d=m-mean;
+                        if(fabs(d.x)<cell_size && fabs(d.y)<cell_size && fabs(d.z)<cell_size) p=m;
+                    }
+                    clustered[i].p=p;
+                    clustered[i].tstart=0;
+                    clustered[i].tcount=0;
+                    clustered[i].border=0;
+                }
+            }, 1000);
+            parts.clear();
+
+            // Values of each cluster are taken from its vertex nearest to the
+            // representative point
+            std::vector<int> data_source;
+            if(!vertex_data.empty())
+            {
+                std::vector<double> nearest(cluster_count,DBL_MAX);
+                data_source.resize(cluster_count);
+                for (size_t i = 0; i < vertices.size(); ++i)
+                {
+                    vec3f d=vec3f(vertices[i].p)-clustered[cluster[i]].p;
+                    if(d.dot(d)>=nearest[cluster[i]]) continue;
+                    nearest[cluster[i]]=d.dot(d);
+                    data_source[cluster[i]]=i;
+                }
+            }
+
+            if(!report_progress(0.8)) return;
+
+            // Triangles between three different clusters, without duplicates
+            size_t table_size=64;
+            while(table_size<2*std::min(triangles.size(),size_t(cluster_count)*8)) table_size*=2;
+            int shift=64;
+            for (size_t s = table_size; s > 1; s/=2) shift--;
+            struct Key { int v[3]; };
+            std::vector<Key> triangle_table(table_size,Key{{-1,-1,-1}});
+            std::vector<char> used(cluster_count,0);
+            int dst=0;
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                Triangle t=triangles[i];
+                for(size_t j: {0, 1, 2}) { t.v[j]=cluster[t.v[j]]; }
+                if(t.v[0]==t.v[1] || t.v[1]==t.v[2] || t.v[2]==t.v[0]) continue;
+                // the table is sized for the expected output, if it gets
+                // full (very irregular input) the rest is not deduplicated
+                if(size_t(dst)*2<table_size)
+                {
+                    Key key={{t.v[0],t.v[1],t.v[2]}};
+                    std::sort(key.v,key.v+3);
+                    uint64_t hash=(uint64_t(key.v[0])*73856093ull)^(uint64_t(key.v[1])*19349663ull)^(uint64_t(key.v[2])*83492791ull);
+                    size_t h=size_t((hash*0x9E3779B97F4A7C15ull)>>shift);
+                    bool duplicate=false;
+                    while(triangle_table[h].v[0]>=0)
+                    {
+                        const Key &k=triangle_table[h];
+                        if(k.v[0]==key.v[0] && k.v[1]==key.v[1] && k.v[2]==key.v[2]) { duplicate=true; break; }
+                        h=(h+1)&(table_size-1);
+                    }
+                    if(duplicate) continue;
+                    triangle_table[h]=key;
+                }
+                for(size_t j: {0, 1, 2}) { used[t.v[j]]=1; }
+                t.deleted=0;
+                triangles[dst]=t;
+                if(!attributes.empty()) attributes[dst]=attributes[i];
+                dst++;
+            }
+            triangles.resize(dst);
+            if(!attributes.empty()) attributes.resize(dst);
+            normals.clear();
+            quadrics.clear();
+            refs.clear();
+
+            // Remove clusters without triangles
+            std::vector<int> cluster_remap(cluster_count,-1);
+            std::vector<char> cluster_locked;
+            std::vector<double> cluster_data;
+            int vertex_count=0;
+            for (int i = 0; i < cluster_count; ++i)
+            {
+                if(!used[i]) continue;
+                cluster_remap[i]=vertex_count;
+                clustered[vertex_count++]=clustered[i];
+                if(!vertex_data.empty())
+                {
+                    const double *d=&vertex_data[size_t(data_source[i])*vertex_data_size];
+                    cluster_data.insert(cluster_data.end(),d,d+vertex_data_size);
+                }
+            }
+            clustered.resize(vertex_count);
+            for(Triangle &t: triangles)
+            {
+                for(size_t j: {0, 1, 2}) { t.v[j]=cluster_remap[t.v[j]]; }
+            }
+            vertex_remap.resize(vertices.size());
+            if(!locked.empty()) cluster_locked.assign(vertex_count,0);
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                vertex_remap[i]=cluster_remap[cluster[i]];
+                if(is_locked(i) && vertex_remap[i]>=0) cluster_locked[vertex_remap[i]]=1;
+            }
+            vertices.swap(clustered);
+            locked.swap(cluster_locked);
+            if(!vertex_data.empty()) vertex_data.swap(cluster_data);
+
+            if (verbose) {
+                message("clustering - cell size %g - %d clusters - %d vertices - %d triangles\n",cell_size,cluster_count,vertex_count,dst);
+            }
+        } //simplify_mesh_clustering()
+
+
+        // Check if a triangle flips when this edge is removed
+
+        bool flipped(vec3f p,int i0,int i1,Vertex &v0,Vertex &v1,std::vector<int> &deleted)
+        {
+            (void)i0; // unused
+            (void)v1; // unused
+
+            for(size_t k = 0; k < v0.tcount; ++k)
+            {
+                int tid=refs[v0.tstart+k].tid;
+                Triangle &t=triangles[tid];
+                if(t.deleted)continue;
+
+                int s=refs[v0.tstart+k].tvertex;
+                int id1=t.v[(s+1)%3];
+                int id2=t.v[(s+2)%3];
+
+                if(id1==i1 || id2==i1) // delete ?
+                {
+
+                    deleted[k]=1;
+                    continue;
+                }
+                vec3f d1 = vec3f(vertices[id1].p)-p; d1.normalize();
+                vec3f d2 = vec3f(vertices[id2].p)-p; d2.normalize();
+                if(fabs(d1.dot(d2))>0.999) return true;
+                vec3f n;
+                n.cross(d1,d2);
+                n.normalize();
+                deleted[k]=0;
+                if(n.dot(normals[tid])<0.2) return true;
+            }
+            return false;
+        }
+
+        // Values of vertex i0 after edge i0-i1 is collapsed to p (called
+        // before v0 is moved): projection of p onto the edge
+
+        void update_vertex_data(int i0,int i1,const vec3f &p)
+        {
+            if(vertex_data.empty()) return;
+            vec3f p0=vertices[i0].p;
+            vec3f e=vec3f(vertices[i1].p)-p0;
+            double length2=e.dot(e);
+            double s=length2>0 ? fmin(1.0,fmax(0.0,(p-p0).dot(e)/length2)) : 0.5;
+            double *d0=&vertex_data[size_t(i0)*vertex_data_size];
+            const double *d1=&vertex_data[size_t(i1)*vertex_data_size];
+            for (int k = 0; k < vertex_data_size; ++k)
+            {
+                if(!vertex_data_discrete.empty() && vertex_data_discrete[k])
+                {
+                    if(s>0.5) d0[k]=d1[k];
+                }
+                else
+                {
+                    d0[k]+=s*(d1[k]-d0[k]);
+                }
+            }
+        }
+
+        // update_uvs
+
+        void update_uvs(int i0,const Vertex &v,const vec3f &p,std::vector<int> &deleted)
+        {
+            (void)i0; // unused
+            for(size_t k = 0; k < v.tcount; ++k)
+            {
+                Ref &r=refs[v.tstart+k];
+                Triangle &t=triangles[r.tid];
+                if(t.deleted)continue;
+                if(deleted[k])continue;
+                vec3f p1=vertices[t.v[0]].p;
+                vec3f p2=vertices[t.v[1]].p;
+                vec3f p3=vertices[t.v[2]].p;
+                vec3f *uvs=attributes[r.tid].uvs;
+                uvs[r.tvertex] = interpolate(p,p1,p2,p3,uvs);
+            }
+        }
+
+        // Update triangle connections and edge error after a edge is collapsed
+
+        void update_triangles(int i0,Vertex &v,std::vector<int> &deleted,int &deleted_triangles)
+        {
+            for(size_t k = 0; k < v.tcount; ++k)
+            {
+                Ref &r=refs[v.tstart+k];
+                Triangle &t=triangles[r.tid];
+                if(t.deleted)continue;
+                if(deleted[k])
+                {
+                    t.deleted=1;
+                    deleted_triangles++;
+                    continue;
+                }
+                t.v[r.tvertex]=i0;
+                t.dirty=1;
+                const int id_v2[3] = { t.v[1], t.v[2], t.v[0] };
+                calculate_errors(t.v,id_v2,3,t.err);
+                t.err[3]=min(t.err[0],min(t.err[1],t.err[2]));
+                refs.push_back(r);
+            }
+        }
+
+        // Mark the vertices of the triangles around v as touched
+
+        void touch_neighbors(const Vertex &v,std::vector<char> &touched,std::vector<int> &touched_vertices)
+        {
+            for(size_t k = 0; k < v.tcount; ++k)
+            {
+                const Triangle &t=triangles[refs[v.tstart+k].tid];
+                if(t.deleted) continue;
+                for(int id: t.v)
+                {
+                    if(touched[id]) continue;
+                    touched[id]=1;
+                    touched_vertices.push_back(id);
+                }
+            }
+        }
+
+        // Make room for n more references before a collapse. Collapses append
+        // the references of the new vertex at the end, so before the list
+        // has to grow the references of the remaining vertices are moved to
+        // the front. Some free space is kept after compaction so that it is
+        // needed only once in a while.
+
+        void reserve_refs(size_t n)
+        {
+            if(refs.size()+n<=refs.capacity()) return;
+            compact_refs();
+            size_t size=refs.size()+n;
+            if(size+size/4>refs.capacity()) refs.reserve(size+size/4);
+        }
+
+        // Move the references of the vertices in use to the front of refs,
+        // in place, and drop the references to deleted triangles
+
+        void compact_refs()
+        {
+            std::vector<int> order;
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                if(vertices[i].tcount) order.push_back(i);
+            }
+            // reference ranges don't overlap, so they can be moved down in order
+            std::sort(order.begin(),order.end(),[this](int a,int b) { return vertices[a].tstart<vertices[b].tstart; });
+            size_t dst=0;
+            for(int i: order)
+            {
+                Vertex &v=vertices[i];
+                size_t src=v.tstart, end=src+v.tcount;
+                v.tstart=dst;
+                for(; src<end; ++src)
+                {
+                    if(!triangles[refs[src].tid].deleted) refs[dst++]=refs[src];
+                }
+                v.tcount=dst-v.tstart;
+            }
+            refs.resize(dst);
+        }
+
+        // Split triangles order[begin..end) into block_count spatial blocks,
+        // the start index of each block is appended to block_start
+
+        void split_blocks(const std::vector<vec3f> &centers,std::vector<int> &order,size_t begin,size_t end,int block_count,std::vector<size_t> &block_start)
+        {
+            if(block_count<=1)
+            {
+                block_start.push_back(begin);
+                return;
+            }
+            vec3f lo=centers[order[begin]], hi=lo;
+            for (size_t i = begin; i < end; ++i)
+            {
+                const vec3f &c=centers[order[i]];
+                lo.x=min(lo.x,c.x); lo.y=min(lo.y,c.y); lo.z=min(lo.z,c.z);
+                hi.x=fmax(hi.x,c.x); hi.y=fmax(hi.y,c.y); hi.z=fmax(hi.z,c.z);
+            }
+            vec3f size=hi-lo;
+            int axis = (size.x>=size.y && size.x>=size.z) ? 0 : (size.y>=size.z ? 1 : 2);
+            int left_count=block_count/2;
+            size_t mid=begin+(end-begin)*left_count/block_count;
+            std::nth_element(order.begin()+begin,order.begin()+mid,order.begin()+end,[&centers,axis](int a,int b)
+            {
+                const vec3f &ca=centers[a], &cb=centers[b];
+                return axis==0 ? ca.x<cb.x : (axis==1 ? ca.y<cb.y : ca.z<cb.z);
+            });
+            split_blocks(centers,order,begin,mid,left_count,block_start);
+            split_blocks(centers,order,mid,end,block_count-left_count,block_start);
+        }
+
+        // Collapse edge j of triangle t for simplify_mesh_heap,
+        // returns false if the collapse is not allowed
+
+        bool try_collapse_heap_edge(Triangle &t,int j,std::vector<int> &deleted0,std::vector<int> &deleted1,int &deleted_triangles)
+        {
+            int i0=t.v[ j     ]; Vertex &v0 = vertices[i0];
+            int i1=t.v[(j+1)%3]; Vertex &v1 = vertices[i1];
+            // Border check
+            if(v0.border != v1.border) return false;
+            if(preserve_border && v0.border) return false;
+            if(is_locked(i0) || is_locked(i1)) return false;
+            reserve_refs(v0.tcount+v1.tcount);
+
+            // Compute vertex to collapse to
+            vec3f p;
+            calculate_error(i0,i1,p);
+            deleted0.resize(v0.tcount); // normals temporarily
+            deleted1.resize(v1.tcount); // normals temporarily
+            // don't remove if flipped
+            if( flipped(p,i0,i1,v0,v1,deleted0) ) return false;
+            if( flipped(p,i1,i0,v1,v0,deleted1) ) return false;
+            if( accept_collapse && !accept_collapse(i0,i1,p) ) return false;
+
+            if ( (t.attr & TEXCOORD) == TEXCOORD  )
+            {
+                update_uvs(i0,v0,p,deleted0);
+                update_uvs(i0,v1,p,deleted1);
+            }
+
+            // triangles sharing the edge leave the queue
+            heap_remove_deleted(v0,deleted0);
+            heap_remove_deleted(v1,deleted1);
+
+            // not flipped, so remove edge
+            update_vertex_data(i0,i1,p);
+            v0.p=p;
+            quadrics[i0]+=quadrics[i1];
+            int tstart=refs.size();
+
+            update_triangles(i0,v0,deleted0,deleted_triangles);
+            update_triangles(i0,v1,deleted1,deleted_triangles);
+
+            size_t tcount = refs.size() - tstart;
+
+            if(tcount<=v0.tcount)
+            {
+                // save ram
+                if(tcount)memcpy(&refs[v0.tstart],&refs[tstart],tcount*sizeof(Ref));
+            }
+            else
+                // append
+                v0.tstart=tstart;
+
+            v0.tcount=tcount;
+            v1.tcount=0; // removed, its references can be reused
+            collapse_count++;
+
+            // edge errors changed around the new vertex, so all of its edges
+            // can be tried again. The flip test of an edge depends on the
+            // triangles around both of its vertices, so edges rejected around
+            // the neighbors of the new vertex are tried again as well.
+            for(size_t k = 0; k < v0.tcount; ++k)
+            {
+                int tid=refs[v0.tstart+k].tid;
+                triangles[tid].dirty=0;
+                heap_update_triangle(tid);
+            }
+            for(size_t k = 0; k < v0.tcount; ++k)
+            {
+                const Triangle &n=triangles[refs[v0.tstart+k].tid];
+                for(int id: n.v)
+                {
+                    if(id!=i0) heap_retry_rejected(vertices[id]);
+                }
+            }
+            return true;
+        }
+
+        // Queue the rejected edges of the triangles around v again
+
+        void heap_retry_rejected(const Vertex &v)
+        {
+            for(size_t k = 0; k < v.tcount; ++k)
+            {
+                int tid=refs[v.tstart+k].tid;
+                Triangle &t=triangles[tid];
+                if(t.deleted || !t.dirty) continue;
+                t.dirty=0;
+                heap_update_triangle(tid);
+            }
+        }
+
+        // Key a triangle in the heap by its cheapest edge that was not rejected
+
+        void heap_update_triangle(int tid)
+        {
+            const Triangle &t=triangles[tid];
+            double err=DBL_MAX;
+            for(int e: {0, 1, 2})
+            {
+                if(!(t.dirty & (1<<e))) err=min(err,t.err[e]);
+            }
+            if(t.dirty==7) heap.remove(tid);
+            else heap.update(tid,err);
+        }
+
+        // Remove triangles that are deleted by a collapse from the heap
+
+        void heap_remove_deleted(const Vertex &v,std::vector<int> &deleted)
+        {
+            for(size_t k = 0; k < v.tcount; ++k)
+            {
+                int tid=refs[v.tstart+k].tid;
+                if(triangles[tid].deleted || !deleted[k]) continue;
+                heap.remove(tid);
+            }
+        }
+
+        // compact triangles, compute edge error and build reference list
+
+        void update_mesh(int iteration)
+        {
+            PhaseTimer timer(*this,iteration==0 ? "init" : "update");
+            if(iteration>0) // compact triangles
+            {
+                int dst=0;
+                for (size_t i = 0; i < triangles.size(); ++i)
+                {
+                    if(triangles[i].deleted)
+                    {
+                        continue;
+                    }
+                    triangles[dst] = triangles[i];
+                    normals[dst] = normals[i];
+                    if(!attributes.empty()) attributes[dst] = attributes[i];
+                    dst++;
+                }
+                triangles.resize(dst);
+                normals.resize(dst);
+                if(!attributes.empty()) attributes.resize(dst);
+            }
+            //
+            // Init Quadrics by Plane & Edge Errors
+            //
+            // required at the beginning ( iteration == 0 )
+            // recomputing during the simplification is not required,
+            // but mostly improves the result for closed meshes
+            //
+            if( iteration == 0 )
+            {
+                bool init_quadrics=!(reuse_quadrics && quadrics.size()==vertices.size());
+                reuse_quadrics=false;
+                if(init_quadrics) quadrics.assign(vertices.size(), SymetricMatrix(0.0));
+                normals.resize(triangles.size());
+
+                for (size_t i = 0; i < triangles.size(); ++i)
+                {
+                    const Triangle &t = triangles[i];
+                    vec3f n,p[3];
+                    for(size_t j: {0, 1, 2})
+                    {
+                        p[j] = vertices[t.v[j]].p;
+                    }
+                    n.cross(p[1]-p[0],p[2]-p[0]);
+                    n.normalize();
+                    normals[i]=n;
+                    if(!init_quadrics) continue;
+                    for(size_t j: {0, 1, 2})
+                    {
+                        quadrics[t.v[j]] += SymetricMatrix(n.x,n.y,n.z,-n.dot(p[0]));
+                    }
+                }
+            }
+
+            // Init Reference ID list
+            for(Vertex& v: vertices)
+            {
+                v.tstart=0;
+                v.tcount=0;
+            }
+            for(Triangle& t: triangles)
+            {
+                for(size_t j: {0, 1, 2}) { vertices[t.v[j]].tcount++; }
+            }
+            int tstart=0;
+            for(Vertex& v: vertices)
+            {
+                v.tstart=tstart;
+                tstart+=v.tcount;
+                v.tcount=0;
+            }
+
+            // Write References
+            refs.resize(triangles.size()*3);
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                Triangle &t = triangles[i];
+                for(size_t j: {0, 1, 2})
+                {
+                    Vertex &v=vertices[t.v[j]];
+                    refs[v.tstart+v.tcount].tid=i;
+                    refs[v.tstart+v.tcount].tvertex=j;
+                    v.tcount++;
+                }
+            }
+
+            // Identify boundary : vertices[].border=0,1
+            if( iteration == 0 )
+            {
+                // A vertex is on the border if one of its edges belongs to a
+                // single triangle, i.e. a neighbor occurs only once in the
+                // triangles around it. Sorting the neighbor ids finds these
+                // in O(n log n) of the valence, and each vertex only writes
+                // its own flag so vertices can be processed in parallel.
+                parallel_for(vertices.size(), [this](size_t begin, size_t end)
+                {
+                    std::vector<int> vids;
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        Vertex &v = vertices[i];
+                        vids.clear();
+                        for(size_t j = 0; j < v.tcount; ++j)
+                        {
+                            const Ref &r=refs[v.tstart+j];
+                            const Triangle &t=triangles[r.tid];
+                            vids.push_back(t.v[(r.tvertex+1)%3]);
+                            vids.push_back(t.v[(r.tvertex+2)%3]);
+                        }
+                        std::sort(vids.begin(), vids.end());
+                        v.border=0;
+                        for(size_t j = 0; j < vids.size() && !v.border; )
+                        {
+                            size_t k=j+1;
+                            while(k < vids.size() && vids[k]==vids[j]) k++;
+                            if(k-j == 1) v.border=1;
+                            j=k;
+                        }
+                    }
+                });
+
+                // Calc Edge Error, after the border is known
+                parallel_for(triangles.size(), [this](size_t begin, size_t end) { update_edge_errors(begin, end); });
+            }
+        }
+
+        // Finally compact mesh before exiting
 
-                if(sscanf(line,"f %d %d %d",
-                    &integers[0],&integers[1],&integers[2])==3)
-                {
-                    tri_ok = true;
-                }else
-                if(sscanf(line,"f %d// %d// %d//",
-                    &integers[0],&integers[1],&integers[2])==3)
+        void compact_mesh()
+        {
+            PhaseTimer timer(*this,"compact");
+            int dst=0;
+            for(Vertex& v: vertices)
+            {
+                v.tcount = 0;
+            }
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                const Triangle &t = triangles[i];
+                if(t.deleted)
                 {
-                    tri_ok = true;
-                }else
-                if(sscanf(line,"f %d//%d %d//%d %d//%d",
-                    &integers[0],&integers[3],
-                    &integers[1],&integers[4],
-                    &integers[2],&integers[5])==6)
+                    continue;
+                }
+                for(size_t j: {0, 1, 2}) { vertices[t.v[j]].tcount=1; }
+                if(!normals.empty()) normals[dst]=normals[i];
+                if(!attributes.empty()) attributes[dst]=attributes[i];
+                triangles[dst++]=t;
+            }
+            triangles.resize(dst);
+            if(!attributes.empty()) attributes.resize(dst);
+            if(!normals.empty()) normals.resize(dst);
+            dst=0;
+            vertex_remap.resize(vertices.size());
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                Vertex &v = vertices[i];
+                if(v.tcount == 0)
                 {
-                    tri_ok = true;
-                }else
-                if(sscanf(line,"f %d/%d/%d %d/%d/%d %d/%d/%d",
-                    &integers[0],&integers[6],&integers[3],
-                    &integers[1],&integers[7],&integers[4],
-                    &integers[2],&integers[8],&integers[5])==9)
+                    vertex_remap[i]=-1;
+                    continue;
+                }
+                v.tstart=dst;
+                vertex_remap[i]=dst;
+                vertices[dst].p=v.p;
+                vertices[dst].border=v.border;
+                if(!quadrics.empty()) quadrics[dst]=quadrics[i];
+                if(!locked.empty()) locked[dst]=locked[i];
+                if(!vertex_data.empty()) memmove(&vertex_data[size_t(dst)*vertex_data_size],&vertex_data[i*vertex_data_size],vertex_data_size*sizeof(double));
+                dst++;
+            }
+            for(Triangle& t: triangles)
+            {
+                for(size_t j: {0, 1, 2}) { t.v[j]=vertices[t.v[j]].tstart; }
+            }
+            vertices.resize(dst);
+            if(!quadrics.empty()) quadrics.resize(dst);
+            if(!locked.empty()) locked.resize(dst);
+            if(!vertex_data.empty()) vertex_data.resize(size_t(dst)*vertex_data_size);
+        }
+
+        // Error between vertex and Quadric
+
+        double vertex_error(const SymetricMatrix &q, double x, double y, double z)
+        {
+             return   q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x + q[4]*y*y
+                  + 2*q[5]*y*z + 2*q[6]*y + q[7]*z*z + 2*q[8]*z + q[9];
+        }
+
+        // Error for one edge
+
+        double calculate_error(int id_v1, int id_v2, vec3f &p_result)
+        {
+            // compute interpolated vertex
+
+            SymetricMatrix q = quadrics[id_v1] + quadrics[id_v2];
+            bool   border = vertices[id_v1].border & vertices[id_v2].border;
+            double error=0;
+            double det = q.det(0, 1, 2, 1, 4, 5, 2, 5, 7);
+            if ( det != 0 && !border )
+            {
+
+                // q_delta is invertible
+                p_result.x = -1/det*(q.det(1, 2, 3, 4, 5, 6, 5, 7 , 8));    // vx = A41/det(q_delta)
+                p_result.y =  1/det*(q.det(0, 2, 3, 1, 5, 6, 2, 7 , 8));    // vy = A42/det(q_delta)
+                p_result.z = -1/det*(q.det(0, 1, 3, 1, 4, 6, 2, 5,  8));    // vz = A43/det(q_delta)
+
+                error = vertex_error(q, p_result.x, p_result.y, p_result.z);
+            }
+            else
+            {
+                // det = 0 -> try to find best result
+                vec3f p1=vertices[id_v1].p;
+                vec3f p2=vertices[id_v2].p;
+                vec3f p3=(p1+p2)/2;
+                double error1 = vertex_error(q, p1.x,p1.y,p1.z);
+                double error2 = vertex_error(q, p2.x,p2.y,p2.z);
+                double error3 = vertex_error(q, p3.x,p3.y,p3.z);
+                error = min(error1, min(error2, error3));
+                if (error1 == error) p_result=p1;
+                if (error2 == error) p_result=p2;
+                if (error3 == error) p_result=p3;
+            }
+            return error;
+        }
+
+        //
+        // Error for n edges (id_v1[i],id_v2[i]) at once, same result as
+        // calculate_error. Quadrics of simd::width edges are transposed into
+        // vectors and evaluated together; edges on the border or with
+        // singular quadric are evaluated by calculate_error.
+        //
+
+        void calculate_errors(const int *id_v1, const int *id_v2, size_t n, double *errors)
+        {
+            const int W = simd::width;
+            const double *qa[W], *qb[W];
+            double e[W];
+            for (size_t i0 = 0; i0 < n; i0 += W)
+            {
+                int count = n-i0 < size_t(W) ? int(n-i0) : W;
+                int border_mask = 0;
+                for (int k = 0; k < W; ++k)
                 {
-                    tri_ok = true;
-                    has_uv = true;
+                    size_t i = i0 + (k < count ? k : 0); // pad with the first edge
+                    qa[k] = quadrics[id_v1[i]].m;
+                    qb[k] = quadrics[id_v2[i]].m;
+                    if (vertices[id_v1[i]].border & vertices[id_v2[i]].border) border_mask |= 1<<k;
                 }
-                else
+                // q = quadrics[id_v1]+quadrics[id_v2]
+                simd::vdouble m[10];
+                for (int c = 0; c < 10; ++c)
                 {
-                    printf("unrecognized sequence\n");
-                    printf("%s\n",line);
-                    while(1);
+                    m[c] = simd::add(simd::gather(qa, c), simd::gather(qb, c));
                 }
-                if ( tri_ok )
+                simd::vdouble det = simd::det(m, 0, 1, 2, 1, 4, 5, 2, 5, 7);
+                int fallback_mask = border_mask | simd::zero_mask(det);
+                const simd::vdouble minus_one = simd::set1(-1), one = simd::set1(1);
+                simd::vdouble x = simd::mul(simd::div(minus_one,det), simd::det(m, 1, 2, 3, 4, 5, 6, 5, 7 , 8));
+                simd::vdouble y = simd::mul(simd::div(one,det), simd::det(m, 0, 2, 3, 1, 5, 6, 2, 7 , 8));
+                simd::vdouble z = simd::mul(simd::div(minus_one,det), simd::det(m, 0, 1, 3, 1, 4, 6, 2, 5,  8));
+                simd::store(e, simd::vertex_error(m, x, y, z));
+                for (int k = 0; k < count; ++k)
                 {
-                    t.v[0] = integers[0]-1-vertex_cnt;
-                    t.v[1] = integers[1]-1-vertex_cnt;
-                    t.v[2] = integers[2]-1-vertex_cnt;
-                    t.attr = 0;
+                    if (fallback_mask & (1<<k))
+                    {
+                        vec3f p;
+                        errors[i0+k] = calculate_error(id_v1[i0+k], id_v2[i0+k], p);
+                    }
+                    else
+                    {
+                        errors[i0+k] = e[k];
+                    }
+                }
+            }
+        }
 
-                    if ( process_uv && has_uv )
+        // Compute edge errors of triangles [begin,end)
+
+        void update_edge_errors(size_t begin, size_t end)
+        {
+            const size_t chunk = 256; // triangles per batch
+            int id_v1[chunk*3], id_v2[chunk*3];
+            double errors[chunk*3];
+            for (size_t c = begin; c < end; c += chunk)
+            {
+                size_t count = std::min(chunk, end-c);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const Triangle &t = triangles[c+i];
+                    for(size_t j: {0, 1, 2})
                     {
-                        std::vector<int> indices;
-                        indices.push_back(integers[6]-1-vertex_cnt);
-                        indices.push_back(integers[7]-1-vertex_cnt);
-                        indices.push_back(integers[8]-1-vertex_cnt);
-                        uvMap.push_back(indices);
-                        t.attr |= TEXCOORD;
+                        id_v1[i*3+j] = t.v[j];
+                        id_v2[i*3+j] = t.v[(j+1)%3];
                     }
+                }
+                calculate_errors(id_v1, id_v2, count*3, errors);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    Triangle &t = triangles[c+i];
+                    for(size_t j: {0, 1, 2})
+                    {
+                        t.err[j] = errors[i*3+j];
+                    }
+                    t.err[3]=min(t.err[0],min(t.err[1],t.err[2]));
+                }
+            }
+        }
 
-                    t.material = material;
-                    //geo.triangles.push_back ( tri );
-                    triangles.push_back(t);
-                    //state_before = state;
-                    //state ='f';
+        // Number of threads to use for n items, with at least min_range items per thread
+
+        int worker_count(size_t n, size_t min_range) const
+        {
+            int thread_count = threads > 0 ? int(threads) : int(std::thread::hardware_concurrency());
+            if (size_t(thread_count) > n/min_range) thread_count = int(n/min_range);
+            return thread_count > 1 ? thread_count : 1;
+        }
+
+        // Run f(begin,end) on subranges of [0,n) using 'threads' threads
+
+        template<class F>
+        void parallel_for(size_t n, F f, size_t min_range = 10000 /* not worth starting threads below this */)
+        {
+            int thread_count = worker_count(n, min_range);
+            if (thread_count <= 1)
+            {
+                f(size_t(0), n);
+                return;
+            }
+            std::vector<std::thread> workers;
+            for (int i = 1; i < thread_count; ++i)
+            {
+                workers.push_back(std::thread(f, n*i/thread_count, n*(i+1)/thread_count));
+            }
+            f(size_t(0), n/thread_count);
+            for(std::thread &worker: workers) worker.join();
+        }
+
+        static char *trimwhitespace(char *str)
+        {
+            char *end;
+
+            // Trim leading space
+            while(isspace((unsigned char)*str)) str++;
+
+            if(*str == 0)  // All spaces?
+            return str;
+
+            // Trim trailing space
+            end = str + strlen(str) - 1;
+            while(end > str && isspace((unsigned char)*end)) end--;
+
+            // Write new null terminator
+            *(end+1) = 0;
+
+            return str;
+        }
+
+        //
+        // OBJ parsing
+        //
+        // load_obj splits the file into chunks at line boundaries, parses the
+        // chunks in parallel into ObjChunk and then concatenates the chunks.
+        // Face indices in OBJ are absolute, so they do not depend on the chunk.
+        //
+
+        struct ObjChunk
+        {
+            std::vector<vec3f> positions;
+            std::vector<vec3f> uvs;
+            std::vector<Triangle> triangles;
+            std::vector<int> uv_indices;        // 3 per triangle if process_uv, -1 = none
+            size_t uv_triangles = 0;            // triangles with uv_indices
+            std::vector<std::pair<size_t,int> > material_runs; // (first triangle, index in material_names)
+            std::vector<std::string> material_names;
+            std::string mtllib;
+            size_t skipped_faces = 0;           // faces with less than 3 vertices or unreadable vertices
+            std::string skipped_face;           // first of these faces
+        };
+
+        static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+        // Read an integer at p and advance p, false if there is no integer at p
+
+        static bool parse_int(const char*& p, const char* end, int& value)
+        {
+            const char* s = p;
+            bool negative = false;
+            if (s < end && (*s == '-' || *s == '+'))
+            {
+                negative = *s == '-';
+                ++s;
+            }
+            if (s == end || *s < '0' || *s > '9') return false;
+            long long v = 0;
+            for (; s < end && *s >= '0' && *s <= '9'; ++s)
+            {
+                if (v < (1LL<<40)) v = v*10 + (*s-'0');
+            }
+            if (v > 0x7fffffff) v = 0x7fffffff;
+            value = int(negative ? -v : v);
+            p = s;
+            return true;
+        }
+
+        // Read a floating point number after blanks at p and advance p, false
+        // if there is no number. Numbers with at most 15 significant digits
+        // and a small exponent are exact integers times an exact power of ten,
+        // so they are converted with one correctly rounded multiplication or
+        // division (same result as strtod). Other numbers use strtod.
+
+        static bool parse_double(const char*& p, const char* end, double& value)
+        {
+            static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+            while (p < end && is_blank(*p)) ++p;
+            const char* s = p;
+            bool negative = false;
+            if (s < end && (*s == '-' || *s == '+'))
+            {
+                negative = *s == '-';
+                ++s;
+            }
+            unsigned long long mantissa = 0;
+            int digits = 0, exponent = 0;
+            bool any = false;
+            for (; s < end && *s >= '0' && *s <= '9'; ++s)
+            {
+                any = true;
+                mantissa = mantissa*10 + (*s-'0');
+                if (mantissa && ++digits > 15) break;
+            }
+            if (s < end && *s == '.' && digits <= 15)
+            {
+                for (++s; s < end && *s >= '0' && *s <= '9'; ++s)
+                {
+                    any = true;
+                    mantissa = mantissa*10 + (*s-'0');
+                    --exponent;
+                    if (mantissa && ++digits > 15) break;
+                }
+            }
+            if (s < end && (*s == 'e' || *s == 'E') && any)
+            {
+                const char* e = s+1;
+                bool exp_negative = false;
+                if (e < end && (*e == '-' || *e == '+'))
+                {
+                    exp_negative = *e == '-';
+                    ++e;
+                }
+                if (e < end && *e >= '0' && *e <= '9')
+                {
+                    int exp_value = 0;
+                    for (; e < end && *e >= '0' && *e <= '9'; ++e)
+                    {
+                        if (exp_value < 10000) exp_value = exp_value*10 + (*e-'0');
+                    }
+                    exponent += exp_negative ? -exp_value : exp_value;
+                    s = e;
                 }
+                else
+                {
+                    any = false; // let strtod decide
+                }
+            }
+            bool at_separator = s == end || is_blank(*s) || *s == '\n';
+            if (any && digits <= 15 && at_separator && exponent >= -22 && exponent <= 22)
+            {
+                double v = double(mantissa);
+                v = exponent < 0 ? v / pow10[-exponent] : v * pow10[exponent];
+                value = negative ? -v : v;
+                p = s;
+                return true;
+            }
+
+            // slow path, strtod needs a null terminated copy
+            char token[64];
+            size_t length = 0;
+            for (s = p; s < end && !is_blank(*s) && *s != '\n' && length < sizeof(token)-1; ++s)
+            {
+                token[length++] = *s;
             }
+            token[length] = 0;
+            char* token_end;
+            value = strtod(token, &token_end);
+            if (token_end == token) return false;
+            p += token_end - token;
+            return true;
         }
 
-        if ( process_uv && uvs.size() )
+        // Read a face vertex "v", "v/vt", "v//vn" or "v/vt/vn" at p and advance p
+
+        static bool parse_face_vertex(const char*& p, const char* end, int& v, int& vt)
         {
-            for(size_t i = 0; i < triangles.size(); ++i)
+            int vn;
+            vt = 0;
+            if (!parse_int(p, end, v)) return false;
+            if (p < end && *p == '/')
             {
-                Triangle& t = triangles[i];
-                for(size_t j: {0, 1, 2})
+                ++p;
+                if (p < end && *p != '/' && !parse_int(p, end, vt)) return false;
+                if (p < end && *p == '/')
                 {
-                    t.uvs[j] = uvs[uvMap[i][j]];
+                    ++p;
+                    if (!parse_int(p, end, vn)) return false;
                 }
             }
+            return p == end || is_blank(*p);
+        }
+
+        static std::string trimmed(const char* begin, const char* end)
+        {
+            while (begin < end && isspace((unsigned char)*begin)) ++begin;
+            while (end > begin && isspace((unsigned char)end[-1])) --end;
+            return std::string(begin, end);
         }
 
-        fclose(fn);
+        static void parse_obj_line(const char* line, const char* eol, ObjChunk& chunk, bool process_uv)
+        {
+            const char* p = line;
+            while (p < eol && is_blank(*p)) ++p;
+            if (eol - p < 2) return;
 
-        //printf("load_obj: vertices = %lu, triangles = %lu, uvs = %lu\n", vertices.size(), triangles.size(), uvs.size() );
-    } // load_obj()
+            if (p[0] == 'v' && is_blank(p[1]))
+            {
+                vec3f v;
+                ++p;
+                if (parse_double(p, eol, v.x) && parse_double(p, eol, v.y) && parse_double(p, eol, v.z))
+                {
+                    chunk.positions.push_back(v);
+                }
+            }
+            else if (p[0] == 'v' && p[1] == 't' && eol - p > 2 && is_blank(p[2]))
+            {
+                vec3f uv;
+                p += 2;
+                if (parse_double(p, eol, uv.x) && parse_double(p, eol, uv.y))
+                {
+                    if (!parse_double(p, eol, uv.z)) uv.z = 0;
+                    chunk.uvs.push_back(uv);
+                }
+            }
+            else if (p[0] == 'f' && is_blank(p[1]))
+            {
+                // polygons are split into a triangle fan
+                int first[2] = {0, 0}, prev[2] = {0, 0}, cur[2] = {0, 0};
+                int n = 0;
+                const size_t triangle_count = chunk.triangles.size();
+                const size_t uv_triangles = chunk.uv_triangles;
+                ++p;
+                for (;; ++n)
+                {
+                    while (p < eol && is_blank(*p)) ++p;
+                    if (p == eol) break;
+                    if (!parse_face_vertex(p, eol, cur[0], cur[1]))
+                    {
+                        // the whole face is skipped
+                        chunk.triangles.resize(triangle_count);
+                        if (process_uv) chunk.uv_indices.resize(3*triangle_count);
+                        chunk.uv_triangles = uv_triangles;
+                        n = 0;
+                        break;
+                    }
+                    if (n == 0)
+                    {
+                        first[0] = cur[0];
+                        first[1] = cur[1];
+                    }
+                    if (n >= 2)
+                    {
+                        Triangle t;
+                        t.v[0] = first[0]-1;
+                        t.v[1] = prev[0]-1;
+                        t.v[2] = cur[0]-1;
+                        t.deleted = 0;
+                        t.dirty = 0;
+                        t.attr = 0;
+                        if (process_uv)
+                        {
+                            bool has_uv = first[1] && prev[1] && cur[1];
+                            chunk.uv_indices.push_back(has_uv ? first[1]-1 : -1);
+                            chunk.uv_indices.push_back(has_uv ? prev[1]-1 : -1);
+                            chunk.uv_indices.push_back(has_uv ? cur[1]-1 : -1);
+                            if (has_uv)
+                            {
+                                t.attr |= TEXCOORD;
+                                chunk.uv_triangles++;
+                            }
+                        }
+                        chunk.triangles.push_back(t);
+                    }
+                    prev[0] = cur[0];
+                    prev[1] = cur[1];
+                }
+                if (n < 3)
+                {
+                    if (!chunk.skipped_faces++) chunk.skipped_face = trimmed(line, eol);
+                }
+            }
+            else if (eol - p > 6 && strncmp(p, "usemtl", 6) == 0 && is_blank(p[6]))
+            {
+                chunk.material_runs.push_back(std::make_pair(chunk.triangles.size(), int(chunk.material_names.size())));
+                chunk.material_names.push_back(trimmed(p+6, eol));
+            }
+            else if (eol - p > 6 && strncmp(p, "mtllib", 6) == 0 && is_blank(p[6]))
+            {
+                chunk.mtllib = trimmed(p+6, eol);
+            }
+        }
 
-    // Optional : Store as OBJ
+        static void parse_obj_lines(const char* p, const char* end, ObjChunk& chunk, bool process_uv)
+        {
+            while (p < end)
+            {
+                const char* eol = (const char*)memchr(p, '\n', end-p);
+                if (!eol) eol = end;
+                parse_obj_line(p, eol, chunk, process_uv);
+                p = eol+1;
+            }
+        }
 
-    void write_obj(const char* filename)
-    {
-        FILE *file=fopen(filename, "w");
-        int cur_material = -1;
-        bool has_uv = (triangles.size() && (triangles[0].attr & TEXCOORD) == TEXCOORD);
+        // Parse complete lines in [begin,end) in chunks of at least 4MB in parallel
 
-        if (!file)
+        void parse_obj_text(const char* begin, const char* end, std::vector<ObjChunk>& chunks, bool process_uv)
         {
-            printf("write_obj: can't write data file \"%s\".\n", filename);
-            exit(0);
+            size_t chunk_count = worker_count(end-begin, 1<<22);
+            std::vector<const char*> bounds(chunk_count+1);
+            bounds[0] = begin;
+            bounds[chunk_count] = end;
+            for (size_t i = 1; i < chunk_count; ++i)
+            {
+                const char* b = std::max(begin + (end-begin)*i/chunk_count, bounds[i-1]);
+                const char* eol = (const char*)memchr(b, '\n', end-b);
+                bounds[i] = eol ? eol+1 : end;
+            }
+            chunks.clear();
+            chunks.resize(chunk_count);
+            parallel_for(chunk_count, [&](size_t first, size_t last)
+            {
+                for (size_t c = first; c < last; ++c) parse_obj_lines(bounds[c], bounds[c+1], chunks[c], process_uv);
+            }, 1);
         }
-        if (!mtllib.empty())
+
+        //Option : Load OBJ
+        bool load_obj(const char* filename, bool process_uv=false){
+            PhaseTimer timer(*this,"load");
+            clear();
+            if(filename==NULL)        return false;
+            if((char)filename[0]==0)    return false;
+            FileView file;
+            if (!file.open(filename))
+            {
+                message("File %s not found!\n", filename);
+                return false;
+            }
+
+            std::vector<ObjChunk> chunks;
+            parse_obj_text(file.data, file.data + file.size, chunks, process_uv);
+            size_t chunk_count = chunks.size();
+
+            // Offsets of the chunks in the merged arrays, and materials in
+            // order of appearance
+            std::vector<size_t> vertex_offset(chunk_count), triangle_offset(chunk_count), uv_offset(chunk_count);
+            std::vector<std::vector<std::pair<size_t,int> > > chunk_materials(chunk_count); // (first triangle, material)
+            std::map<std::string, int> material_map;
+            size_t vertex_count = 0, triangle_count = 0, uv_count = 0, uv_triangles = 0;
+            int material = -1;
+            bool has_attributes = false;
+            size_t skipped_faces = 0;
+            for (size_t c = 0; c < chunk_count; ++c)
+            {
+                ObjChunk& chunk = chunks[c];
+                if (chunk.skipped_faces && !skipped_faces)
+                {
+                    message("load_obj: skipped unrecognized face in %s\n", filename);
+                    message("%s\n", chunk.skipped_face.c_str());
+                }
+                skipped_faces += chunk.skipped_faces;
+                vertex_offset[c] = vertex_count;
+                triangle_offset[c] = triangle_count;
+                uv_offset[c] = uv_count;
+                vertex_count += chunk.positions.size();
+                triangle_count += chunk.triangles.size();
+                uv_count += chunk.uvs.size();
+                uv_triangles += chunk.uv_triangles;
+                if (!chunk.mtllib.empty()) mtllib = chunk.mtllib;
+
+                chunk_materials[c].push_back(std::make_pair(size_t(0), material));
+                for (const std::pair<size_t,int>& run: chunk.material_runs)
+                {
+                    const std::string& usemtl = chunk.material_names[run.second];
+                    if (material_map.find(usemtl) == material_map.end())
+                    {
+                        material_map[usemtl] = materials.size();
+                        materials.push_back(usemtl);
+                    }
+                    material = material_map[usemtl];
+                    chunk_materials[c].push_back(std::make_pair(run.first, material));
+                }
+                for (size_t i = 0; i < chunk_materials[c].size(); ++i)
+                {
+                    size_t run_end = i+1 < chunk_materials[c].size() ? chunk_materials[c][i+1].first : chunk.triangles.size();
+                    if (chunk_materials[c][i].second >= 0 && chunk_materials[c][i].first < run_end) has_attributes = true;
+                }
+            }
+            if (uv_triangles) has_attributes = true;
+            bool assign_uvs = process_uv && uv_count && uv_triangles == triangle_count;
+
+            // Concatenate chunks
+            vertices.resize(vertex_count);
+            triangles.resize(triangle_count);
+            if (has_attributes) attributes.resize(triangle_count);
+            std::vector<vec3f> uvs;
+            if (assign_uvs)
+            {
+                uvs.reserve(uv_count);
+                for (ObjChunk& chunk: chunks) uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+            }
+            std::vector<char> index_error(chunk_count, 0);
+            parallel_for(chunk_count, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    ObjChunk& chunk = chunks[c];
+                    for (size_t i = 0; i < chunk.positions.size(); ++i)
+                    {
+                        vertices[vertex_offset[c]+i].p = chunk.positions[i];
+                    }
+                    for (size_t i = 0; i < chunk.triangles.size(); ++i)
+                    {
+                        const Triangle& t = chunk.triangles[i];
+                        for (int j: {0, 1, 2})
+                        {
+                            if (t.v[j] < 0 || size_t(t.v[j]) >= vertex_count) index_error[c] = 1;
+                        }
+                        triangles[triangle_offset[c]+i] = t;
+                    }
+                    if (has_attributes)
+                    {
+                        for (size_t r = 0; r < chunk_materials[c].size(); ++r)
+                        {
+                            size_t run_end = r+1 < chunk_materials[c].size() ? chunk_materials[c][r+1].first : chunk.triangles.size();
+                            for (size_t i = chunk_materials[c][r].first; i < run_end; ++i)
+                            {
+                                attributes[triangle_offset[c]+i].material = chunk_materials[c][r].second;
+                            }
+                        }
+                    }
+                    if (assign_uvs)
+                    {
+                        for (size_t i = 0; i < chunk.uv_indices.size(); ++i)
+                        {
+                            int uv = chunk.uv_indices[i];
+                            if (uv < 0 || size_t(uv) >= uv_count)
+                            {
+                                index_error[c] = 1;
+                                continue;
+                            }
+                            attributes[triangle_offset[c]+i/3].uvs[i%3] = uvs[uv];
+                        }
+                    }
+                    chunk = ObjChunk(); // release memory early
+                }
+            }, 1);
+            for (size_t c = 0; c < chunk_count; ++c)
+            {
+                if (index_error[c])
+                {
+                    message("load_obj: face index out of range in %s\n", filename);
+                    clear();
+                    return false;
+                }
+            }
+            if (skipped_faces > 1)
+            {
+                message("load_obj: skipped %zu unrecognized faces in %s\n", skipped_faces, filename);
+            }
+
+            //printf("load_obj: vertices = %lu, triangles = %lu, uvs = %lu\n", vertices.size(), triangles.size(), uvs.size() );
+            return true;
+        } // load_obj()
+
+        //
+        // OBJ writing
+        //
+        // Elements are formatted in blocks by worker threads and the blocks
+        // are written in order with one fwrite each.
+        //
+
+        static void append_int(std::string& out, int value)
         {
-            fprintf(file, "mtllib %s\n", mtllib.c_str());
+            char buffer[12];
+            char* p = buffer + sizeof(buffer);
+            unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+            do
+            {
+                *--p = char('0' + v%10);
+                v /= 10;
+            } while (v);
+            if (value < 0) *--p = '-';
+            out.append(p, buffer + sizeof(buffer) - p);
         }
-        for(Vertex& v: vertices)
+
+        static void append_double(std::string& out, double value)
         {
-            //fprintf(file, "v %lf %lf %lf\n", v.p.x, v.p.y, v.p.z);
-            fprintf(file, "v %g %g %g\n", v.p.x, v.p.y, v.p.z); //more compact: remove trailing zeros
+            char buffer[32];
+            int length = snprintf(buffer, sizeof(buffer), "%g", value); //more compact: remove trailing zeros
+            out.append(buffer, length);
         }
-        if (has_uv)
+
+        static const size_t write_block_size = 1<<16;
+
+        // Write format(begin,end,out) for blocks of [0,n) to file in order
+
+        template<class F>
+        bool write_blocks(FILE* file, size_t n, F format)
         {
-            for(Triangle& t: triangles)
+            size_t block_count = (n + write_block_size-1) / write_block_size;
+            size_t round = worker_count(block_count, 1);
+            std::vector<std::string> buffers(round);
+            for (size_t b0 = 0; b0 < block_count; b0 += round)
             {
-                if(t.deleted)
+                size_t count = std::min(round, block_count-b0);
+                parallel_for(count, [&](size_t begin, size_t end)
                 {
-                    continue;
+                    for (size_t k = begin; k < end; ++k)
+                    {
+                        size_t b = b0+k;
+                        buffers[k].clear();
+                        format(b*write_block_size, std::min((b+1)*write_block_size, n), buffers[k]);
+                    }
+                }, 1);
+                for (size_t k = 0; k < count; ++k)
+                {
+                    if (fwrite(buffers[k].data(), 1, buffers[k].size(), file) != buffers[k].size()) return false;
                 }
-                fprintf(file, "vt %g %g\n", t.uvs[0].x, t.uvs[0].y);
-                fprintf(file, "vt %g %g\n", t.uvs[1].x, t.uvs[1].y);
-                fprintf(file, "vt %g %g\n", t.uvs[2].x, t.uvs[2].y);
             }
+            return true;
         }
-        int uv = 1;
-        for(Triangle& t: triangles)
+
+        // Optional : Store as OBJ
+
+        bool write_obj(const char* filename)
         {
-            if(t.deleted)
+            PhaseTimer timer(*this,"write");
+            FILE *file=fopen(filename, "w");
+            bool has_uv = (triangles.size() && (triangles[0].attr & TEXCOORD) == TEXCOORD);
+
+            if (!file)
             {
-                continue;
+                message("write_obj: can't write data file \"%s\".\n", filename);
+                return false;
             }
-            if (t.material != cur_material)
+            if (!mtllib.empty())
+            {
+                fprintf(file, "mtllib %s\n", mtllib.c_str());
+            }
+            bool ok = write_blocks(file, vertices.size(), [this](size_t begin, size_t end, std::string& out)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const vec3f p = vertices[i].p;
+                    out += "v ";
+                    append_double(out, p.x);
+                    out += ' ';
+                    append_double(out, p.y);
+                    out += ' ';
+                    append_double(out, p.z);
+                    out += '\n';
+                }
+            });
+            if (ok && has_uv)
             {
-                cur_material = t.material;
-                fprintf(file, "usemtl %s\n", materials[t.material].c_str());
+                ok = write_blocks(file, triangles.size(), [this](size_t begin, size_t end, std::string& out)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        if(triangles[i].deleted)
+                        {
+                            continue;
+                        }
+                        for (const vec3f& uv: attributes[i].uvs)
+                        {
+                            out += "vt ";
+                            append_double(out, uv.x);
+                            out += ' ';
+                            append_double(out, uv.y);
+                            out += '\n';
+                        }
+                    }
+                });
             }
-            if (has_uv)
+
+            // Current material and uv index at the start of each block
+            size_t block_count = (triangles.size() + write_block_size-1) / write_block_size;
+            std::vector<int> block_material(block_count), block_uv(block_count);
+            int cur_material = -1;
+            int uv = 1;
+            for (size_t i = 0; i < triangles.size(); ++i)
             {
-                fprintf(file, "f %d/%d %d/%d %d/%d\n", t.v[0]+1, uv, t.v[1]+1, uv+1, t.v[2]+1, uv+2);
+                if (i % write_block_size == 0)
+                {
+                    block_material[i / write_block_size] = cur_material;
+                    block_uv[i / write_block_size] = uv;
+                }
+                if (triangles[i].deleted)
+                {
+                    continue;
+                }
+                if (i < attributes.size()) cur_material = attributes[i].material;
                 uv += 3;
             }
-            else
+            if (ok)
+            {
+                ok = write_blocks(file, triangles.size(), [&](size_t begin, size_t end, std::string& out)
+                {
+                    int cur_material = block_material[begin / write_block_size];
+                    int uv = block_uv[begin / write_block_size];
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const Triangle &t = triangles[i];
+                        if(t.deleted)
+                        {
+                            continue;
+                        }
+                        int material = i < attributes.size() ? attributes[i].material : -1;
+                        if (material != cur_material)
+                        {
+                            cur_material = material;
+                            if (material >= 0)
+                            {
+                                out += "usemtl ";
+                                out += materials[material];
+                                out += '\n';
+                            }
+                        }
+                        out += 'f';
+                        for (int j: {0, 1, 2})
+                        {
+                            out += ' ';
+                            append_int(out, t.v[j]+1);
+                            if (has_uv)
+                            {
+                                out += '/';
+                                append_int(out, uv+j);
+                            }
+                        }
+                        out += '\n';
+                        if (has_uv)
+                        {
+                            uv += 3;
+                        }
+                    }
+                });
+            }
+            if (fclose(file) != 0) ok = false;
+            if (!ok)
             {
-                fprintf(file, "f %d %d %d\n", t.v[0]+1, t.v[1]+1, t.v[2]+1);
+                message("write_obj: error writing \"%s\".\n", filename);
             }
-            //fprintf(file, "f %d// %d// %d//\n", t.v[0]+1, t.v[1]+1, t.v[2]+1); //more compact: remove trailing zeros
+            return ok;
         }
-        fclose(file);
-    }
-};
+    }; // class BasicSimplifier
+
+    typedef BasicSimplifier<double> Simplifier;
+} // namespace Simplify
 ///////////////////////////////////////////
+
+#endif // SIMPLIFY_H
@@ -0,0 +1,672 @@
+/////////////////////////////////////////////
+//
+// Geometric deviation between meshes and error-bounded simplification,
+// using the Simplifier of Simplify.h.
+//
+// SurfaceDistance is a bounding volume hierarchy (axis aligned boxes,
+// median split of triangle centers) over a triangle mesh for closest
+// point queries. measure_deviation() uses it in both directions: from the
+// vertices of the input mesh to the simplified surface, and from the
+// vertices and triangle centers of the simplified mesh to the input
+// surface. These are samples, points on the edges and inside the
+// triangles can be farther, so the result is an estimate for reporting.
+//
+// simplify_to_tolerance() removes as many triangles as possible while
+// the deviation stays within a distance tolerance. The bound holds for
+// every point of both surfaces, not only for samples: ToleranceGuard checks each collapse before it is done (see
+// Simplifier::accept_collapse) and rejects it if any point of the new
+// triangles would be farther than the tolerance from the input surface or
+// any point of the input surface farther than the tolerance from the
+// simplified surface. Points on the triangles are checked with
+// triangle_within(), which subdivides the triangles only where the
+// distance is close to the tolerance.
+//
+
+#ifndef SIMPLIFY_DEVIATION_H
+#define SIMPLIFY_DEVIATION_H
+
+#include "Simplify.h"
+
+#include <unordered_map>
+
+namespace Simplify
+{
+    // Largest and mean distance at the points sampled by measure_deviation
+    struct Deviation
+    {
+        double sampled_max = 0;
+        double sampled_mean = 0;
+    };
+
+    // Result of simplify_to_tolerance
+    struct ToleranceResult
+    {
+        // false if no edge could be collapsed within the tolerance, then
+        // the mesh is the unchanged input and deviation is 0
+        bool reduced = false;
+        Deviation deviation; // of the simplified mesh from the input
+    };
+
+    inline double length2(const vec3f& v) { return v.dot(v); }
+
+    // Squared distance of p to triangle abc (closest point by Voronoi
+    // regions, see Ericson: Real-Time Collision Detection, 5.1.5)
+    inline double triangle_distance2(const vec3f& p, const vec3f& a, const vec3f& b, const vec3f& c)
+    {
+        vec3f ab = b - a, ac = c - a, ap = p - a;
+        double d1 = ab.dot(ap), d2 = ac.dot(ap);
+        if (d1 <= 0 && d2 <= 0) return length2(ap);
+        vec3f bp = p - b;
+        double d3 = ab.dot(bp), d4 = ac.dot(bp);
+        if (d3 >= 0 && d4 <= d3) return length2(bp);
+        double vc = d1*d4 - d3*d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0) return length2(ap - ab*(d1/(d1-d3)));
+        vec3f cp = p - c;
+        double d5 = ab.dot(cp), d6 = ac.dot(cp);
+        if (d6 >= 0 && d5 <= d6) return length2(cp);
+        double vb = d5*d2 - d1*d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0) return length2(ap - ac*(d2/(d2-d6)));
+        double va = d3*d6 - d5*d4;
+        if (va <= 0 && (d4-d3) >= 0 && (d5-d6) >= 0) return length2(bp - (c-b)*((d4-d3)/((d4-d3)+(d5-d6))));
+        double denom = va + vb + vc;
+        if (denom == 0) return length2(ap); // degenerate triangle
+        return length2(ap - ab*(vb/denom) - ac*(vc/denom));
+    }
+
+    class SurfaceDistance
+    {
+    public:
+        template<class Mesh>
+        explicit SurfaceDistance(const Mesh& mesh)
+        {
+            size_t n = mesh.triangles.size();
+            std::vector<Bounds> bounds(n);
+            std::vector<int> order(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const Triangle& t = mesh.triangles[i];
+                Bounds& b = bounds[i];
+                b.lo = b.hi = vec3f(mesh.vertices[t.v[0]].p);
+                for (int j : {1, 2}) b.add(mesh.vertices[t.v[j]].p);
+                order[i] = i;
+            }
+            if (n)
+            {
+                nodes.resize(1);
+                build(0, bounds, order, 0, n);
+            }
+            // triangle corners in leaf order, so that leaves are contiguous
+            corners.resize(3*n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const Triangle& t = mesh.triangles[order[i]];
+                for (int j : {0, 1, 2}) corners[3*i+j] = mesh.vertices[t.v[j]].p;
+            }
+            // triangles that share an edge, in leaf order, by sorting the
+            // edges (only two of the triangles of non-manifold edges)
+            std::vector<std::pair<uint64_t,int> > edges(3*n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const Triangle& t = mesh.triangles[order[i]];
+                for (int j : {0, 1, 2})
+                {
+                    uint32_t a = t.v[j], b = t.v[(j+1)%3];
+                    if (a > b) std::swap(a, b);
+                    edges[3*i+j] = std::make_pair(uint64_t(a) << 32 | b, int(i));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            neighbors.assign(3*n, -1);
+            for (size_t i = 0; i + 1 < edges.size(); ++i)
+            {
+                if (edges[i].first != edges[i+1].first) continue;
+                add_neighbor(edges[i].second, edges[i+1].second);
+                add_neighbor(edges[i+1].second, edges[i].second);
+            }
+        }
+
+        // Distance of p to the closest point of the surface
+        double distance(const vec3f& p) const
+        {
+            int triangle = -1;
+            return closest(p, triangle);
+        }
+
+        // Distance of p to the closest point of the surface, and the
+        // triangle of that point for distance(triangle, p). triangle can be
+        // given a triangle near p (or -1), which speeds up the search.
+        double closest(const vec3f& p, int& triangle) const
+        {
+            if (nodes.empty()) return DBL_MAX;
+            double best = triangle < 0 ? DBL_MAX : // squared
+                triangle_distance2(p, corners[3*triangle], corners[3*triangle+1], corners[3*triangle+2]);
+            int stack[64];
+            int size = 0;
+            stack[size++] = 0;
+            while (size)
+            {
+                const Node& node = nodes[stack[--size]];
+                if (box_distance2(node, p) >= best) continue;
+                if (node.count)
+                {
+                    for (int i = node.first; i < node.first + node.count; ++i)
+                    {
+                        double d = triangle_distance2(p, corners[3*i], corners[3*i+1], corners[3*i+2]);
+                        if (d < best)
+                        {
+                            best = d;
+                            triangle = i;
+                        }
+                    }
+                    continue;
+                }
+                // visit the closer child first
+                int near = node.left, far = node.left + 1;
+                if (box_distance2(nodes[far], p) < box_distance2(nodes[near], p)) std::swap(near, far);
+                stack[size++] = far;
+                stack[size++] = near;
+            }
+            return sqrt(best);
+        }
+
+        // Distance of p to a triangle returned by closest
+        double distance(int triangle, const vec3f& p) const
+        {
+            return sqrt(triangle_distance2(p, corners[3*triangle], corners[3*triangle+1], corners[3*triangle+2]));
+        }
+
+        // A triangle near p, found by moving from triangle to the closer
+        // neighbors. Much faster than closest if triangle is near p, but it
+        // can stop at a triangle that is not the closest.
+        int walk(const vec3f& p, int triangle) const
+        {
+            double best = triangle_distance2(p, corners[3*triangle], corners[3*triangle+1], corners[3*triangle+2]);
+            for (int step = 0; step < 64; ++step)
+            {
+                int next = -1;
+                for (int j : {0, 1, 2})
+                {
+                    int neighbor = neighbors[3*triangle+j];
+                    if (neighbor < 0) continue;
+                    double d = triangle_distance2(p, corners[3*neighbor], corners[3*neighbor+1], corners[3*neighbor+2]);
+                    if (d < best)
+                    {
+                        best = d;
+                        next = neighbor;
+                    }
+                }
+                if (next < 0) break;
+                triangle = next;
+            }
+            return triangle;
+        }
+
+    private:
+        struct Bounds
+        {
+            vec3f lo, hi;
+            void add(const vec3f& p)
+            {
+                lo.x = fmin(lo.x, p.x); lo.y = fmin(lo.y, p.y); lo.z = fmin(lo.z, p.z);
+                hi.x = fmax(hi.x, p.x); hi.y = fmax(hi.y, p.y); hi.z = fmax(hi.z, p.z);
+            }
+            vec3f center() const { return (lo + hi) / 2; }
+        };
+        // Leaf if count > 0 (triangles first..first+count-1 in leaf order),
+        // otherwise the children are left and left+1
+        struct Node : Bounds
+        {
+            int first, count, left;
+        };
+        static const size_t leaf_size = 8;
+        std::vector<Node> nodes;
+        std::vector<vec3f> corners;
+        std::vector<int> neighbors; // 3 per triangle, -1 if none
+
+        void add_neighbor(int triangle, int neighbor)
+        {
+            for (int j : {0, 1, 2})
+            {
+                if (neighbors[3*triangle+j] >= 0) continue;
+                neighbors[3*triangle+j] = neighbor;
+                return;
+            }
+        }
+
+        void build(int id, const std::vector<Bounds>& bounds, std::vector<int>& order, size_t begin, size_t end)
+        {
+            Bounds box = bounds[order[begin]];
+            for (size_t i = begin + 1; i < end; ++i)
+            {
+                box.add(bounds[order[i]].lo);
+                box.add(bounds[order[i]].hi);
+            }
+            int first = begin, count = end - begin, left = -1;
+            if (end - begin > leaf_size)
+            {
+                // median split of the triangle (box) centers along the longest axis
+                vec3f size = box.hi - box.lo;
+                int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+                size_t mid = (begin + end) / 2;
+                std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&bounds, axis](int a, int b)
+                {
+                    vec3f ca = bounds[a].center(), cb = bounds[b].center();
+                    return axis == 0 ? ca.x < cb.x : (axis == 1 ? ca.y < cb.y : ca.z < cb.z);
+                });
+                left = nodes.size();
+                nodes.resize(left + 2);
+                build(left, bounds, order, begin, mid);
+                build(left + 1, bounds, order, mid, end);
+                first = count = 0;
+            }
+            Node& node = nodes[id];
+            node.lo = box.lo;
+            node.hi = box.hi;
+            node.first = first;
+            node.count = count;
+            node.left = left;
+        }
+
+        static double box_distance2(const Node& node, const vec3f& p)
+        {
+            double dx = fmax(0.0, fmax(node.lo.x - p.x, p.x - node.hi.x));
+            double dy = fmax(0.0, fmax(node.lo.y - p.y, p.y - node.hi.y));
+            double dz = fmax(0.0, fmax(node.lo.z - p.z, p.z - node.hi.z));
+            return dx*dx + dy*dy + dz*dz;
+        }
+    };
+
+    //
+    // Closest point queries as in SurfaceDistance on a few triangles (the
+    // triangles around a vertex), without a hierarchy.
+    //
+    struct TriangleList
+    {
+        const vec3f* corners;
+        size_t count;
+
+        double closest(const vec3f& p, int& triangle) const
+        {
+            double best = DBL_MAX; // squared
+            for (size_t i = 0; i < count; ++i)
+            {
+                double d = triangle_distance2(p, corners[3*i], corners[3*i+1], corners[3*i+2]);
+                if (d < best)
+                {
+                    best = d;
+                    triangle = i;
+                }
+            }
+            return sqrt(best);
+        }
+
+        double distance(int triangle, const vec3f& p) const
+        {
+            return sqrt(triangle_distance2(p, corners[3*triangle], corners[3*triangle+1], corners[3*triangle+2]));
+        }
+
+        int walk(const vec3f& p, int triangle) const
+        {
+            closest(p, triangle);
+            return triangle;
+        }
+    };
+
+    //
+    // True if every point of triangle abc is within tolerance of surface
+    // (SurfaceDistance or TriangleList). The distance to the surface changes
+    // at most as much as the position, so the triangle passes if the
+    // distance at its center plus the distance of the center to the corners
+    // is within tolerance. The distance to a single triangle is convex, so
+    // it also passes if the corners are within tolerance of one surface
+    // triangle, one close to the center. Otherwise the triangle is
+    // split into four. It fails if the center of a part is farther than
+    // tolerance (the centers of all four parts are checked before any part
+    // is split further), or if a part that does not pass is smaller than a
+    // quarter of the tolerance or was split depth times. So the result can
+    // be false for triangles very close to the tolerance but is never
+    // wrongly true.
+    //
+    template<class Surface>
+    bool triangle_within(const Surface& surface, const vec3f& a, const vec3f& b, const vec3f& c, double tolerance, int depth = 10)
+    {
+        struct Part
+        {
+            vec3f a, b, c;
+            int closest = -1;   // surface triangle close to the center, -1 if the part passed
+            bool small = false; // too small to split
+        };
+        auto check = [&surface, tolerance](Part& part, int hint)
+        {
+            auto within = [&](int triangle)
+            {
+                return surface.distance(triangle, part.a) <= tolerance && surface.distance(triangle, part.b) <= tolerance &&
+                    surface.distance(triangle, part.c) <= tolerance;
+            };
+            part.closest = -1;
+            if (hint >= 0 && within(hint)) return true;
+            vec3f center = (part.a + part.b + part.c) / 3;
+            // the triangle found by walking from the closest triangle of
+            // the parent serves as well if the center is within tolerance
+            // of it, any triangle gives an upper bound of the distance
+            part.closest = hint;
+            double distance = DBL_MAX;
+            if (hint >= 0)
+            {
+                part.closest = surface.walk(center, hint);
+                distance = surface.distance(part.closest, center);
+            }
+            if (distance > tolerance) distance = surface.closest(center, part.closest);
+            if (distance > tolerance) return false;
+            double radius = sqrt(fmax(length2(part.a - center), fmax(length2(part.b - center), length2(part.c - center))));
+            if (distance + radius <= tolerance || (part.closest != hint && within(part.closest))) part.closest = -1;
+            part.small = radius < tolerance / 4;
+            return true;
+        };
+        std::function<bool(const Part&, int)> split = [&](const Part& part, int depth)
+        {
+            if (part.closest < 0) return true;
+            if (part.small || depth == 0) return false;
+            vec3f ab = (part.a + part.b) / 2, bc = (part.b + part.c) / 2, ca = (part.c + part.a) / 2;
+            Part parts[4] = { { ab, bc, ca }, { part.a, ab, ca }, { part.b, bc, ab }, { part.c, ca, bc } };
+            for (Part& p : parts)
+            {
+                if (!check(p, part.closest)) return false;
+            }
+            for (const Part& p : parts)
+            {
+                if (!split(p, depth - 1)) return false;
+            }
+            return true;
+        };
+        Part part = { a, b, c };
+        return check(part, -1) && split(part, depth);
+    }
+
+    //
+    // Collapse check of simplify_to_tolerance (Simplifier::accept_collapse),
+    // keeps the simplified mesh within tolerance of the input surface in
+    // both directions.
+    //
+    // Only the triangles around the merged vertex are new, they are checked
+    // against the input surface. For the other direction every input
+    // triangle is owned by a vertex of the mesh whose star (the triangles
+    // around it) contains the input triangle within tolerance, initially its
+    // first vertex. A collapse only changes the stars of the two vertices of
+    // the edge and of their neighbors, so only the input triangles owned by
+    // these vertices are checked again: against the new star of their owner,
+    // otherwise of the merged vertex or a neighbor, which becomes the owner.
+    // If there is none the collapse is rejected.
+    //
+    template<class Mesh>
+    class ToleranceGuard
+    {
+    public:
+        // mesh must be the input mesh, with the surface of its triangles
+        ToleranceGuard(const Mesh& mesh, const SurfaceDistance& input_surface, double tolerance)
+          : mesh(mesh), input_surface(input_surface), tolerance(tolerance)
+        {
+            input_points.resize(mesh.vertices.size());
+            for (size_t i = 0; i < mesh.vertices.size(); ++i) input_points[i] = mesh.vertices[i].p;
+            size_t n = mesh.triangles.size();
+            input_triangles.resize(3*n);
+            head.assign(mesh.vertices.size(), -1);
+            next.resize(n);
+            last_change.assign(mesh.vertices.size(), 0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const Triangle& t = mesh.triangles[i];
+                for (int j : {0, 1, 2}) input_triangles[3*i+j] = t.v[j];
+                next[i] = head[t.v[0]];
+                head[t.v[0]] = i;
+            }
+        }
+
+        const std::vector<vec3f>& points() const { return input_points; }
+
+        // Called before edge i0-i1 of the mesh is collapsed to p, i0 is the
+        // merged vertex. Returns false if the collapse would exceed the
+        // tolerance, otherwise the owners are updated for the collapse.
+        bool accept(int i0, int i1, const vec3f& p)
+        {
+            // the merged vertex is stored with the precision of the mesh
+            typedef decltype(Mesh::Vertex::p) Position;
+            merged = vec3f(Position(p));
+            edge0 = i0;
+            edge1 = i1;
+            affected.assign({i0, i1});
+            for (int v : {i0, i1})
+            {
+                for_each_triangle(v, [&](const Triangle& t)
+                {
+                    for (int w : t.v)
+                    {
+                        if (std::find(affected.begin(), affected.end(), w) == affected.end()) affected.push_back(w);
+                    }
+                });
+            }
+
+            // the result only depends on the affected vertices (and p, which
+            // depends on i0 and i1), so a rejected collapse is rejected again
+            // until one of them changes. The sweep of simplify_mesh tries
+            // the same edges in each iteration.
+            uint64_t edge = uint64_t(uint32_t(i0)) << 32 | uint32_t(i1);
+            auto found = rejected.find(edge);
+            if (found != rejected.end())
+            {
+                bool changed = false;
+                for (int v : affected) changed = changed || last_change[v] > found->second;
+                if (!changed) return false;
+            }
+            if (!check())
+            {
+                rejected[edge] = accepted;
+                return false;
+            }
+
+            ++accepted;
+            for (int v : affected)
+            {
+                head[v] = -1;
+                last_change[v] = accepted;
+            }
+            for (const auto& owner : new_owners)
+            {
+                next[owner.first] = head[owner.second];
+                head[owner.second] = owner.first;
+            }
+            return true;
+        }
+
+    private:
+        const Mesh& mesh;
+        const SurfaceDistance& input_surface;
+        double tolerance;
+        std::vector<vec3f> input_points;
+        std::vector<int> input_triangles;
+        // input triangles owned by each vertex, as linked lists
+        std::vector<int> head, next;
+        // accepted collapses, the number when each vertex was last
+        // affected, and when each rejected edge was rejected
+        size_t accepted = 0;
+        std::vector<size_t> last_change;
+        std::unordered_map<uint64_t,size_t> rejected;
+        // state of the current accept() call
+        int edge0 = -1, edge1 = -1;
+        vec3f merged;
+        std::vector<int> affected;
+        std::vector<size_t> star_start;
+        std::vector<vec3f> star_corners;
+        std::vector<std::pair<int,int> > new_owners;
+
+        // Checks the collapse of edge0-edge1 to merged, sets new_owners
+        bool check()
+        {
+            if (input_surface.distance(merged) > tolerance) return false;
+
+            // stars after the collapse, of edge0 first, then of the
+            // other affected vertices
+            star_start.assign(1, 0);
+            star_corners.clear();
+            auto add_triangle = [this](const Triangle& t)
+            {
+                if (contains(t, edge0) && contains(t, edge1)) return; // removed by the collapse
+                for (int k : t.v) star_corners.push_back(position(k));
+            };
+            for (int v : affected)
+            {
+                if (v == edge1) continue;
+                for_each_triangle(v, add_triangle);
+                if (v == edge0) for_each_triangle(edge1, add_triangle);
+                star_start.push_back(star_corners.size());
+            }
+
+            // new triangles to the input surface
+            for (size_t k = 0; k < star_start[1]; k += 3)
+            {
+                if (!triangle_within(input_surface, star_corners[k], star_corners[k+1], star_corners[k+2], tolerance)) return false;
+            }
+
+            // input triangles to the new stars; star 0 is that of edge0 (and
+            // edge1), star s > 0 that of affected vertex s+1
+            new_owners.clear();
+            for (size_t a = 0; a < affected.size(); ++a)
+            {
+                size_t own = a < 2 ? 0 : a - 1;
+                for (int t = head[affected[a]]; t >= 0; t = next[t])
+                {
+                    size_t owner = own;
+                    if (!input_within(t, own))
+                    {
+                        for (owner = 0; owner + 1 < star_start.size(); ++owner)
+                        {
+                            if (owner != own && input_within(t, owner)) break;
+                        }
+                        if (owner + 1 == star_start.size()) return false;
+                    }
+                    new_owners.push_back(std::make_pair(t, affected[owner ? owner + 1 : 0]));
+                }
+            }
+            return true;
+        }
+
+        template<class F>
+        void for_each_triangle(int v, F f) const
+        {
+            const auto& vertex = mesh.vertices[v];
+            for (unsigned k = 0; k < vertex.tcount; ++k)
+            {
+                const Triangle& t = mesh.triangles[mesh.refs[vertex.tstart+k].tid];
+                if (!t.deleted) f(t);
+            }
+        }
+
+        static bool contains(const Triangle& t, int v)
+        {
+            return t.v[0] == v || t.v[1] == v || t.v[2] == v;
+        }
+
+        vec3f position(int v) const
+        {
+            return (v == edge0 || v == edge1) ? merged : vec3f(mesh.vertices[v].p);
+        }
+
+        bool input_within(int t, size_t star) const
+        {
+            TriangleList list = { star_corners.data() + star_start[star], (star_start[star+1] - star_start[star]) / 3 };
+            const int* v = &input_triangles[3*t];
+            return triangle_within(list, input_points[v[0]], input_points[v[1]], input_points[v[2]], tolerance);
+        }
+    };
+
+    //
+    // Deviation between input and output mesh: distances from the input
+    // vertices to the output surface and from the output vertices and
+    // triangle centers to the input surface. output.threads is used.
+    //
+    template<class Mesh>
+    Deviation measure_deviation(const std::vector<vec3f>& input_points, const SurfaceDistance& input_surface, Mesh& output)
+    {
+        SurfaceDistance output_surface(output);
+        size_t input_count = input_points.size();
+        size_t vertex_count = output.vertices.size();
+        std::vector<double> distances(input_count + vertex_count + output.triangles.size());
+        output.parallel_for(distances.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (i < input_count)
+                {
+                    distances[i] = output_surface.distance(input_points[i]);
+                }
+                else if (i < input_count + vertex_count)
+                {
+                    distances[i] = input_surface.distance(output.vertices[i-input_count].p);
+                }
+                else
+                {
+                    const Triangle& t = output.triangles[i-input_count-vertex_count];
+                    vec3f center = (vec3f(output.vertices[t.v[0]].p) + output.vertices[t.v[1]].p + output.vertices[t.v[2]].p) / 3;
+                    distances[i] = input_surface.distance(center);
+                }
+            }
+        }, 1000);
+        Deviation deviation;
+        double sum = 0;
+        for (double d : distances)
+        {
+            deviation.sampled_max = fmax(deviation.sampled_max, d);
+            sum += d;
+        }
+        if (!distances.empty()) deviation.sampled_mean = sum / distances.size();
+        return deviation;
+    }
+
+    template<class Mesh>
+    Deviation measure_deviation(const Mesh& input, const SurfaceDistance& input_surface, Mesh& output)
+    {
+        std::vector<vec3f> input_points(input.vertices.size());
+        for (size_t i = 0; i < input_points.size(); ++i) input_points[i] = input.vertices[i].p;
+        return measure_deviation(input_points, input_surface, output);
+    }
+
+    //
+    // Simplify mesh as much as possible with a deviation of at most
+    // tolerance from the input mesh, in a single run: simplify(mesh) runs
+    // one of the simplify_mesh* methods on mesh with a target of 0
+    // triangles, and a ToleranceGuard set as mesh.accept_collapse rejects
+    // the collapses that would exceed the tolerance (simplify_mesh_parallel
+    // runs serially then). mesh.max_error, if set, limits the collapses as
+    // well. The returned deviation is the sampled estimate of
+    // measure_deviation, for reporting.
+    //
+    template<class Mesh, class F>
+    ToleranceResult simplify_to_tolerance(Mesh& mesh, double tolerance, F simplify, bool verbose = false)
+    {
+        ToleranceResult result;
+        size_t input_count = mesh.triangles.size();
+        SurfaceDistance input_surface = [&mesh]()
+        {
+            typename Mesh::PhaseTimer timer(mesh, "deviation");
+            return SurfaceDistance(mesh);
+        }();
+        ToleranceGuard<Mesh> guard(mesh, input_surface, tolerance);
+        mesh.accept_collapse = [&guard](int i0, int i1, const vec3f& p) { return guard.accept(i0, i1, p); };
+        simplify(mesh);
+        mesh.accept_collapse = nullptr;
+        result.reduced = mesh.triangles.size() < input_count;
+        if (!result.reduced || mesh.aborted) return result;
+        {
+            typename Mesh::PhaseTimer timer(mesh, "deviation");
+            result.deviation = measure_deviation(guard.points(), input_surface, mesh);
+        }
+        if (verbose)
+        {
+            mesh.message("triangles %zu - sampled deviation max %g mean %g\n",
+                mesh.triangles.size(), result.deviation.sampled_max, result.deviation.sampled_mean);
+        }
+        return result;
+    }
+}
+
+#endif // SIMPLIFY_DEVIATION_H
@@ -0,0 +1,747 @@
+/////////////////////////////////////////////
+//
+// Out-of-core mesh simplification for OBJ files that do not fit into memory,
+// using the Simplifier of Simplify.h on one spatial block at a time.
+//
+// 1. The OBJ file is read in chunks and converted to a binary vertex file
+//    (3 doubles per vertex) and triangle file (3 ints per triangle).
+// 2. Triangles are counted on a grid by their center and the grid is split
+//    into blocks (kd-tree over grid cells) with at most as many triangles
+//    as fit into the memory budget, then the triangles are sorted into
+//    blocks in a partition file.
+// 3. Each block is simplified with the vertices that are shared with other
+//    blocks locked, so blocks are independent and their result is appended
+//    to an intermediate binary mesh as soon as it is ready, together with
+//    the quadric of each vertex (summed over the blocks for seam vertices).
+// 4. If the intermediate mesh fits into the budget then a final in-memory
+//    pass simplifies it to the target (including the block seams), starting
+//    from these quadrics, otherwise it is converted to OBJ as it is and the
+//    target is not reached.
+//
+// Binary files are memory mapped for random access to vertex positions
+// (mmap, or a file mapping on Windows), so only the pages that the blocks
+// access are read.
+// Texture coordinates and materials are not kept.
+//
+
+#ifndef SIMPLIFY_STREAMING_H
+#define SIMPLIFY_STREAMING_H
+
+#include "Simplify.h"
+
+#include <mutex>
+
+namespace Simplify
+{
+    class StreamingSimplifier
+    {
+    public:
+        size_t memory_budget = size_t(1)<<30; // bytes
+        int threads = 1;                      // 0 = number of CPU cores
+        double agressiveness = 7;
+        bool lossless = false;
+        bool priority_queue = false;
+        bool preserve_border = false;         // see Simplifier::preserve_border
+        bool verbose = false;
+        std::function<void(const char*)> log; // see Simplifier::log
+
+        // Statistics of the last run
+        size_t input_vertices = 0, input_triangles = 0;
+        size_t output_vertices = 0, output_triangles = 0;
+        size_t block_count = 0;
+        // False if the output has more triangles than the target, e.g. if
+        // the block seams could not be simplified within the memory budget
+        // (always true in lossless mode, which has no target)
+        bool target_reached = false;
+
+        // Estimated peak memory of simplifying a mesh, per triangle
+        // (Triangle, normal, refs, half a Vertex and quadric, block buffers)
+        static const size_t bytes_per_triangle = 256;
+
+        //
+        // Simplify OBJ file input to about (1-reduction) times the number of
+        // input triangles and write the result to OBJ file output. Temporary
+        // files are created next to the output file. Returns false on error;
+        // if the output is written but has more triangles than the target
+        // then target_reached is false.
+        //
+        bool simplify_obj(const char* input, const char* output, double reduction)
+        {
+            input_vertices = input_triangles = 0;
+            output_vertices = output_triangles = 0;
+            block_count = 0;
+            target_reached = false;
+            TemporaryFiles temp(output);
+            DiskMesh mesh;
+            mesh.vertex_file = temp.add(".vertices.tmp");
+            mesh.triangle_file = temp.add(".triangles.tmp");
+            if (!convert_obj(input, mesh)) return false;
+            input_vertices = mesh.vertex_count;
+            input_triangles = mesh.triangle_count;
+            int target_count = int(round(mesh.triangle_count * (1.0-reduction)));
+
+            if (!fits_in_memory(mesh))
+            {
+                DiskMesh reduced;
+                reduced.vertex_file = temp.add(".reduced-vertices.tmp");
+                reduced.triangle_file = temp.add(".reduced-triangles.tmp");
+                reduced.quadric_file = temp.add(".reduced-quadrics.tmp");
+                if (!simplify_blocks(mesh, reduced, target_count, temp)) return false;
+                temp.remove(mesh.vertex_file);
+                temp.remove(mesh.triangle_file);
+                mesh = reduced;
+            }
+            bool ok;
+            if (fits_in_memory(mesh))
+            {
+                ok = simplify_in_memory(mesh, output, target_count);
+            }
+            else
+            {
+                if (verbose) message("Result does not fit into the memory budget, block seams are not simplified\n");
+                ok = write_disk_mesh_obj(mesh, output);
+            }
+            target_reached = ok && (lossless || output_triangles <= size_t(std::max(target_count, 0)));
+            return ok;
+        }
+
+    private:
+        // Mesh stored as binary vertex and triangle files
+        struct DiskMesh
+        {
+            std::string vertex_file;
+            std::string triangle_file;
+            std::string quadric_file; // quadric of each vertex, optional
+            size_t vertex_count = 0;
+            size_t triangle_count = 0;
+            vec3f bmin, bmax;
+        };
+
+        // Files removed when the object is destroyed
+        class TemporaryFiles
+        {
+        public:
+            TemporaryFiles(const char* base) : base(base) {}
+            ~TemporaryFiles() { for (const std::string& name: names) ::remove(name.c_str()); }
+            std::string add(const char* suffix)
+            {
+                names.push_back(base + suffix);
+                return names.back();
+            }
+            void remove(const std::string& name)
+            {
+                ::remove(name.c_str());
+                names.erase(std::remove(names.begin(), names.end(), name), names.end());
+            }
+        private:
+            std::string base;
+            std::vector<std::string> names;
+        };
+
+        static bool seek(FILE* file, size_t offset)
+        {
+#if defined(_WIN32)
+            return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+            return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+        }
+
+        // Write a message (printf format) to log or stdout
+        void message(const char* format, ...) const
+        {
+            char text[1024];
+            va_list args;
+            va_start(args, format);
+            vsnprintf(text, sizeof(text), format, args);
+            va_end(args);
+            if (log) log(text);
+            else fputs(text, stdout);
+        }
+
+        int thread_count() const
+        {
+            return threads > 0 ? threads : std::max(1, int(std::thread::hardware_concurrency()));
+        }
+
+        bool fits_in_memory(const DiskMesh& mesh) const
+        {
+            return mesh.triangle_count * bytes_per_triangle <= memory_budget;
+        }
+
+        void simplify(Simplifier& simplifier, int target_count, int thread_count) const
+        {
+            if (lossless) simplifier.simplify_mesh_lossless(verbose);
+            else if (priority_queue) simplifier.simplify_mesh_heap(target_count, verbose);
+            else if (thread_count != 1) simplifier.simplify_mesh_parallel(target_count, thread_count, agressiveness, verbose);
+            else simplifier.simplify_mesh(target_count, agressiveness, verbose);
+        }
+
+        //
+        // Convert OBJ file to a DiskMesh, reading it in chunks
+        //
+        bool convert_obj(const char* filename, DiskMesh& mesh)
+        {
+            FILE* in = fopen(filename, "rb");
+            if (!in)
+            {
+                message("File %s not found!\n", filename);
+                return false;
+            }
+            FILE* vertex_out = fopen(mesh.vertex_file.c_str(), "wb");
+            FILE* triangle_out = fopen(mesh.triangle_file.c_str(), "wb");
+            bool ok = vertex_out && triangle_out;
+            if (!ok) message("Can't create temporary files for %s\n", filename);
+
+            Simplifier parser;
+            parser.threads = threads;
+            parser.log = log;
+            std::vector<Simplifier::ObjChunk> chunks;
+            size_t chunk_size = std::min(std::max(memory_budget/16, size_t(1)<<20), size_t(1)<<28);
+            std::vector<char> buffer(chunk_size);
+            std::vector<int> ids;
+            size_t carry = 0; // bytes of incomplete line at the start of buffer
+            int min_id = 0, max_id = -1;
+            size_t skipped_faces = 0;
+            mesh.vertex_count = 0;
+            mesh.triangle_count = 0;
+            mesh.bmin = vec3f(DBL_MAX, DBL_MAX, DBL_MAX);
+            mesh.bmax = vec3f(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+            while (ok)
+            {
+                if (carry == buffer.size()) buffer.resize(buffer.size()*2); // very long line
+                size_t length = carry + fread(&buffer[carry], 1, buffer.size()-carry, in);
+                bool at_end = length < buffer.size();
+                const char* begin = buffer.data();
+                const char* end = begin + length;
+                if (!at_end)
+                {
+                    // parse complete lines only
+                    const char* p = end;
+                    while (p > begin && p[-1] != '\n') --p;
+                    end = p;
+                }
+                parser.parse_obj_text(begin, end, chunks, false);
+                for (Simplifier::ObjChunk& chunk: chunks)
+                {
+                    if (chunk.skipped_faces && !skipped_faces)
+                    {
+                        message("load_obj: skipped unrecognized face in %s\n", filename);
+                        message("%s\n", chunk.skipped_face.c_str());
+                    }
+                    skipped_faces += chunk.skipped_faces;
+                    for (const vec3f& p: chunk.positions)
+                    {
+                        mesh.bmin = vec3f(std::min(mesh.bmin.x, p.x), std::min(mesh.bmin.y, p.y), std::min(mesh.bmin.z, p.z));
+                        mesh.bmax = vec3f(std::max(mesh.bmax.x, p.x), std::max(mesh.bmax.y, p.y), std::max(mesh.bmax.z, p.z));
+                    }
+                    ids.clear();
+                    for (const Triangle& t: chunk.triangles)
+                    {
+                        for (int v: t.v)
+                        {
+                            ids.push_back(v);
+                            min_id = std::min(min_id, v);
+                            max_id = std::max(max_id, v);
+                        }
+                    }
+                    if (!chunk.positions.empty())
+                    {
+                        ok = ok && fwrite(chunk.positions.data(), sizeof(vec3f), chunk.positions.size(), vertex_out) == chunk.positions.size();
+                    }
+                    if (!ids.empty())
+                    {
+                        ok = ok && fwrite(ids.data(), sizeof(int), ids.size(), triangle_out) == ids.size();
+                    }
+                    mesh.vertex_count += chunk.positions.size();
+                    mesh.triangle_count += chunk.triangles.size();
+                }
+                if (at_end) break;
+                carry = begin + length - end;
+                memmove(&buffer[0], end, carry);
+            }
+            if (ok && (min_id < 0 || size_t(max_id) >= mesh.vertex_count || mesh.vertex_count > 0x7fffffff))
+            {
+                message("load_obj: face index out of range in %s\n", filename);
+                ok = false;
+            }
+            if (skipped_faces > 1)
+            {
+                message("load_obj: skipped %zu unrecognized faces in %s\n", skipped_faces, filename);
+            }
+            fclose(in);
+            if (vertex_out && fclose(vertex_out) != 0) ok = false;
+            if (triangle_out && fclose(triangle_out) != 0) ok = false;
+            if (verbose && ok)
+            {
+                message("Converted %s: %zu vertices, %zu triangles\n", filename, mesh.vertex_count, mesh.triangle_count);
+            }
+            return ok;
+        }
+
+        //
+        // Read triangles of a DiskMesh in pieces of at most 'count' triangles
+        // and call f(first_triangle_index, ids, triangle_count)
+        //
+        template<class F>
+        bool for_each_triangles(const DiskMesh& mesh, size_t count, F f) const
+        {
+            FILE* in = fopen(mesh.triangle_file.c_str(), "rb");
+            if (!in) return false;
+            std::vector<int> ids(count*3);
+            bool ok = true;
+            for (size_t first = 0; first < mesh.triangle_count && ok; first += count)
+            {
+                size_t n = std::min(count, mesh.triangle_count-first);
+                ok = fread(ids.data(), sizeof(int)*3, n, in) == n;
+                if (ok) f(first, ids.data(), n);
+            }
+            fclose(in);
+            return ok;
+        }
+
+        // Grid of triangle centers used for partitioning
+        struct Grid
+        {
+            int size[3];
+            vec3f origin;
+            double cell_size;
+            std::vector<size_t> counts;
+
+            int cell(const vec3f& p) const
+            {
+                int c[3];
+                double x[3] = { p.x-origin.x, p.y-origin.y, p.z-origin.z };
+                for (int a = 0; a < 3; ++a)
+                {
+                    c[a] = std::min(std::max(int(x[a]/cell_size), 0), size[a]-1);
+                }
+                return (c[2]*size[1] + c[1])*size[0] + c[0];
+            }
+        };
+
+        // Box of grid cells [lo,hi) containing 'count' triangle centers
+        struct CellBox { int lo[3], hi[3]; size_t count; };
+
+        // Split box at the median along its longest axis until blocks are small enough
+        void split_cells(const Grid& grid, const CellBox& box, size_t max_triangles, std::vector<int>& cell_block, int& blocks) const
+        {
+            int axis = 0;
+            for (int a = 1; a < 3; ++a)
+            {
+                if (box.hi[a]-box.lo[a] > box.hi[axis]-box.lo[axis]) axis = a;
+            }
+            if (box.count > max_triangles && box.hi[axis]-box.lo[axis] > 1)
+            {
+                std::vector<size_t> slab(box.hi[axis]-box.lo[axis], 0);
+                for (int z = box.lo[2]; z < box.hi[2]; ++z)
+                    for (int y = box.lo[1]; y < box.hi[1]; ++y)
+                        for (int x = box.lo[0]; x < box.hi[0]; ++x)
+                        {
+                            int c[3] = { x, y, z };
+                            slab[c[axis]-box.lo[axis]] += grid.counts[(z*grid.size[1] + y)*grid.size[0] + x];
+                        }
+                CellBox lower = box, upper = box;
+                size_t sum = 0;
+                int split = box.lo[axis]+1;
+                for (int i = 0; i < int(slab.size())-1; ++i)
+                {
+                    sum += slab[i];
+                    split = box.lo[axis]+i+1;
+                    if (2*sum >= box.count) break;
+                }
+                lower.hi[axis] = upper.lo[axis] = split;
+                lower.count = 0;
+                for (int i = 0; i < split-box.lo[axis]; ++i) lower.count += slab[i];
+                upper.count = box.count - lower.count;
+                split_cells(grid, lower, max_triangles, cell_block, blocks);
+                split_cells(grid, upper, max_triangles, cell_block, blocks);
+                return;
+            }
+            if (box.count == 0) return;
+            if (box.count > max_triangles)
+            {
+                message("Warning: a block of %zu triangles exceeds the memory budget\n", box.count);
+            }
+            for (int z = box.lo[2]; z < box.hi[2]; ++z)
+                for (int y = box.lo[1]; y < box.hi[1]; ++y)
+                    for (int x = box.lo[0]; x < box.hi[0]; ++x)
+                    {
+                        cell_block[(z*grid.size[1] + y)*grid.size[0] + x] = blocks;
+                    }
+            blocks++;
+        }
+
+        //
+        // Simplify mesh block by block into 'reduced'
+        //
+        bool simplify_blocks(const DiskMesh& mesh, DiskMesh& reduced, int target_count, TemporaryFiles& temp)
+        {
+            FileView positions_file;
+            if (!positions_file.open(mesh.vertex_file.c_str())) return false;
+            const vec3f* positions = (const vec3f*)positions_file.data;
+
+            // Triangles read at once and grid resolution (cells along the
+            // longest axis) are scaled with the budget, so that they take
+            // at most about 1/10 and 1/16 of it
+            const size_t piece = std::min(size_t(1)<<20, std::max(size_t(1)<<12, memory_budget/(sizeof(int)*3*2*10)));
+            const size_t cell_bytes = sizeof(size_t)+sizeof(int); // count and block
+            const int resolution = std::min(128, std::max(8, int(cbrt(double(memory_budget/16/cell_bytes)))));
+
+            // Memory that is not per block: grid, read and partition buffers.
+            // The vertex owners are in a mapped temporary file, as the input
+            // vertices. Fewer threads are used if blocks would be too small
+            // otherwise.
+            size_t fixed = size_t(resolution)*resolution*resolution*cell_bytes + piece*sizeof(int)*3*2;
+            size_t block_budget = memory_budget > fixed ? (memory_budget-fixed) / bytes_per_triangle : 0;
+            int workers = int(std::max(size_t(1), std::min(size_t(thread_count()), block_budget/10000)));
+            size_t max_triangles = block_budget / workers;
+            if (max_triangles < 10000)
+            {
+                message("Memory budget is too small for streaming\n");
+                return false;
+            }
+
+            // Count triangle centers on the grid
+            Grid grid;
+            vec3f extent = mesh.bmax - mesh.bmin;
+            double longest = std::max(extent.x, std::max(extent.y, extent.z));
+            grid.cell_size = longest > 0 ? longest/resolution : 1;
+            grid.origin = mesh.bmin;
+            grid.size[0] = std::max(1, std::min(resolution, int(ceil(extent.x/grid.cell_size))));
+            grid.size[1] = std::max(1, std::min(resolution, int(ceil(extent.y/grid.cell_size))));
+            grid.size[2] = std::max(1, std::min(resolution, int(ceil(extent.z/grid.cell_size))));
+            grid.counts.assign(size_t(grid.size[0])*grid.size[1]*grid.size[2], 0);
+            bool ok = for_each_triangles(mesh, piece, [&](size_t, const int* ids, size_t n)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const int* t = ids+3*i;
+                    grid.counts[grid.cell((positions[t[0]]+positions[t[1]]+positions[t[2]])/3)]++;
+                }
+            });
+            if (!ok) return false;
+
+            // Blocks
+            std::vector<int> cell_block(grid.counts.size(), -1);
+            CellBox all = { { 0, 0, 0 }, { grid.size[0], grid.size[1], grid.size[2] }, mesh.triangle_count };
+            int blocks = 0;
+            split_cells(grid, all, max_triangles, cell_block, blocks);
+            block_count = blocks;
+            std::vector<size_t> block_start(blocks+1, 0);
+            for (size_t c = 0; c < grid.counts.size(); ++c)
+            {
+                if (cell_block[c] >= 0) block_start[cell_block[c]+1] += grid.counts[c];
+            }
+            for (int b = 0; b < blocks; ++b) block_start[b+1] += block_start[b];
+            if (verbose)
+            {
+                message("Streaming: %d blocks of at most %zu triangles, %d threads\n", blocks, max_triangles, workers);
+            }
+
+            // Sort triangles into blocks in the partition file, and find
+            // vertices that are used by more than one block.
+            // owner[v]: block that uses v, -1 = unused, -2 = seam vertex.
+            // It is mapped from a file, so that the system can write it to
+            // disk instead of keeping 4 bytes per input vertex in memory.
+            FileView owner_file;
+            std::string owner_name = temp.add(".owners.tmp");
+            if (!owner_file.create(owner_name.c_str(), mesh.vertex_count*sizeof(int))) return false;
+            int* owner = (int*)owner_file.writable();
+            std::fill(owner, owner+mesh.vertex_count, -1);
+            std::string partition_file = temp.add(".blocks.tmp");
+            FILE* partition = fopen(partition_file.c_str(), "wb+");
+            if (!partition) return false;
+            size_t buffer_triangles = std::max(size_t(1024), std::min(size_t(1)<<16, piece/blocks));
+            std::vector<std::vector<int> > buffers(blocks);
+            std::vector<size_t> written(blocks, 0);
+            auto flush = [&](int b) -> bool
+            {
+                std::vector<int>& buffer = buffers[b];
+                size_t n = buffer.size()/3;
+                bool done = seek(partition, (block_start[b]+written[b])*sizeof(int)*3)
+                    && fwrite(buffer.data(), sizeof(int)*3, n, partition) == n;
+                written[b] += n;
+                buffer.clear();
+                return done;
+            };
+            bool read_ok = for_each_triangles(mesh, piece, [&](size_t, const int* ids, size_t n)
+            {
+                for (size_t i = 0; i < n && ok; ++i)
+                {
+                    const int* t = ids+3*i;
+                    int b = cell_block[grid.cell((positions[t[0]]+positions[t[1]]+positions[t[2]])/3)];
+                    for (int j: {0, 1, 2})
+                    {
+                        int& o = owner[t[j]];
+                        if (o == -1) o = b;
+                        else if (o != b) o = -2;
+                        buffers[b].push_back(t[j]);
+                    }
+                    if (buffers[b].size() >= buffer_triangles*3) ok = flush(b);
+                }
+            });
+            ok = ok && read_ok;
+            for (int b = 0; b < blocks && ok; ++b) ok = flush(b);
+            std::vector<std::vector<int> >().swap(buffers);
+            std::vector<int>().swap(cell_block);
+            std::vector<size_t>().swap(grid.counts);
+            if (fflush(partition) != 0) ok = false;
+            if (!ok)
+            {
+                fclose(partition);
+                return false;
+            }
+
+            // From here owner[v] is -1 for vertices that are not on a seam,
+            // -2 for seam vertices that are not written yet, and the index
+            // of seam vertex v in reduced otherwise
+            for (size_t v = 0; v < mesh.vertex_count; ++v)
+            {
+                if (owner[v] != -2) owner[v] = -1;
+            }
+            auto seam = [owner](int v) { return owner[v] != -1; };
+
+            // Simplify blocks, the reduced mesh is appended to the output
+            // files. Quadrics that other blocks add to seam vertices are
+            // collected in seam_quadrics and added to the file at the end.
+            FILE* vertex_out = fopen(reduced.vertex_file.c_str(), "wb");
+            FILE* triangle_out = fopen(reduced.triangle_file.c_str(), "wb");
+            FILE* quadric_out = fopen(reduced.quadric_file.c_str(), "wb+");
+            ok = vertex_out && triangle_out && quadric_out;
+            std::vector<std::pair<int, SymetricMatrix> > seam_quadrics;
+            reduced.vertex_count = 0;
+            reduced.triangle_count = 0;
+            reduced.bmin = mesh.bmin;
+            reduced.bmax = mesh.bmax;
+            double ratio = double(target_count)/mesh.triangle_count;
+            std::mutex mutex;
+            int next_block = 0;
+            auto worker = [&]()
+            {
+                Simplifier part;
+                part.preserve_border = preserve_border;
+                part.log = log;
+                std::vector<int> ids, global_ids, new_ids;
+                for (;;)
+                {
+                    int b;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!ok || next_block >= blocks) return;
+                        b = next_block++;
+                    }
+                    size_t n = block_start[b+1]-block_start[b];
+                    ids.resize(n*3);
+                    {
+                        // partition is shared, read under lock
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!seek(partition, block_start[b]*sizeof(int)*3)
+                            || fread(ids.data(), sizeof(int)*3, n, partition) != n)
+                        {
+                            ok = false;
+                            return;
+                        }
+                    }
+
+                    // Block vertices are the sorted unique ids
+                    global_ids = ids;
+                    std::sort(global_ids.begin(), global_ids.end());
+                    global_ids.erase(std::unique(global_ids.begin(), global_ids.end()), global_ids.end());
+                    part.clear();
+                    part.vertices.resize(global_ids.size());
+                    part.locked.resize(global_ids.size());
+                    for (size_t i = 0; i < global_ids.size(); ++i)
+                    {
+                        part.vertices[i].p = positions[global_ids[i]];
+                        part.locked[i] = seam(global_ids[i]);
+                    }
+                    part.triangles.resize(n);
+                    int seam_triangles = 0;
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        Triangle& t = part.triangles[i];
+                        for (int j: {0, 1, 2})
+                        {
+                            t.v[j] = int(std::lower_bound(global_ids.begin(), global_ids.end(), ids[3*i+j]) - global_ids.begin());
+                        }
+                        t.attr = 0;
+                        if (part.locked[t.v[0]] || part.locked[t.v[1]] || part.locked[t.v[2]]) seam_triangles++;
+                    }
+                    // seam triangles are left for the final pass, as in simplify_mesh_parallel
+                    int part_target = int(round((n-seam_triangles)*ratio)) + seam_triangles;
+                    simplify(part, part_target, 1);
+                    // quadrics are not computed if there was nothing to do
+                    if (part.quadrics.size() != part.vertices.size()) part.update_mesh(0);
+
+                    // Append result
+                    new_ids.resize(part.vertices.size());
+                    std::vector<int> new_to_global(part.vertices.size());
+                    for (size_t i = 0; i < part.vertex_remap.size(); ++i)
+                    {
+                        if (part.vertex_remap[i] >= 0) new_to_global[part.vertex_remap[i]] = global_ids[i];
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (size_t i = 0; i < part.vertices.size() && ok; ++i)
+                    {
+                        int g = new_to_global[i];
+                        if (owner[g] >= 0)
+                        {
+                            // seam vertices are locked, so the block only
+                            // added the planes of its own triangles
+                            new_ids[i] = owner[g];
+                            seam_quadrics.push_back(std::make_pair(owner[g], part.quadrics[i]));
+                            continue;
+                        }
+                        new_ids[i] = int(reduced.vertex_count++);
+                        if (owner[g] == -2) owner[g] = new_ids[i];
+                        ok = fwrite(&part.vertices[i].p, sizeof(vec3f), 1, vertex_out) == 1
+                            && fwrite(&part.quadrics[i], sizeof(SymetricMatrix), 1, quadric_out) == 1;
+                    }
+                    ids.clear();
+                    for (const Triangle& t: part.triangles)
+                    {
+                        for (int v: t.v) ids.push_back(new_ids[v]);
+                    }
+                    ok = ok && fwrite(ids.data(), sizeof(int)*3, part.triangles.size(), triangle_out) == part.triangles.size();
+                    reduced.triangle_count += part.triangles.size();
+                    if (verbose)
+                    {
+                        message("Block %d: %zu -> %zu triangles\n", b, n, part.triangles.size());
+                    }
+                }
+            };
+            std::vector<std::thread> pool;
+            for (int i = 1; i < std::min(workers, blocks); ++i) pool.push_back(std::thread(worker));
+            worker();
+            for (std::thread& t: pool) t.join();
+
+            fclose(partition);
+            temp.remove(partition_file);
+            owner_file.close();
+            temp.remove(owner_name);
+
+            // Sum the quadrics of seam vertices
+            std::sort(seam_quadrics.begin(), seam_quadrics.end(),
+                [](const std::pair<int, SymetricMatrix>& a, const std::pair<int, SymetricMatrix>& b) { return a.first < b.first; });
+            for (size_t i = 0; i < seam_quadrics.size() && ok; )
+            {
+                int v = seam_quadrics[i].first;
+                SymetricMatrix q;
+                ok = seek(quadric_out, v*sizeof(SymetricMatrix)) && fread(&q, sizeof(SymetricMatrix), 1, quadric_out) == 1;
+                for (; i < seam_quadrics.size() && seam_quadrics[i].first == v; ++i) q += seam_quadrics[i].second;
+                ok = ok && seek(quadric_out, v*sizeof(SymetricMatrix)) && fwrite(&q, sizeof(SymetricMatrix), 1, quadric_out) == 1;
+            }
+            if (vertex_out && fclose(vertex_out) != 0) ok = false;
+            if (triangle_out && fclose(triangle_out) != 0) ok = false;
+            if (quadric_out && fclose(quadric_out) != 0) ok = false;
+            if (verbose && ok)
+            {
+                message("Blocks simplified: %zu vertices, %zu triangles\n", reduced.vertex_count, reduced.triangle_count);
+            }
+            return ok;
+        }
+
+        //
+        // Load mesh, simplify (starting from the quadrics of the mesh if
+        // there are any) and write OBJ
+        //
+        bool simplify_in_memory(const DiskMesh& mesh, const char* output, int target_count)
+        {
+            Simplifier simplifier;
+            simplifier.threads = threads;
+            simplifier.preserve_border = preserve_border;
+            simplifier.log = log;
+            simplifier.vertices.resize(mesh.vertex_count);
+            simplifier.triangles.resize(mesh.triangle_count);
+            FILE* in = fopen(mesh.vertex_file.c_str(), "rb");
+            bool ok = in != NULL;
+            for (size_t i = 0; i < mesh.vertex_count && ok; ++i)
+            {
+                ok = fread(&simplifier.vertices[i].p, sizeof(vec3f), 1, in) == 1;
+            }
+            if (in) fclose(in);
+            if (ok && !mesh.quadric_file.empty())
+            {
+                simplifier.quadrics.resize(mesh.vertex_count);
+                in = fopen(mesh.quadric_file.c_str(), "rb");
+                ok = in && fread(simplifier.quadrics.data(), sizeof(SymetricMatrix), mesh.vertex_count, in) == mesh.vertex_count;
+                if (in) fclose(in);
+                simplifier.reuse_quadrics = true;
+            }
+            size_t t = 0;
+            ok = ok && for_each_triangles(mesh, 1<<20, [&](size_t, const int* ids, size_t n)
+            {
+                for (size_t i = 0; i < n; ++i, ++t)
+                {
+                    Triangle& tri = simplifier.triangles[t];
+                    tri.v[0] = ids[3*i];
+                    tri.v[1] = ids[3*i+1];
+                    tri.v[2] = ids[3*i+2];
+                    tri.attr = 0;
+                }
+            });
+            if (!ok) return false;
+            if (int(mesh.triangle_count) > target_count || lossless)
+            {
+                simplify(simplifier, target_count, threads);
+            }
+            output_vertices = simplifier.vertices.size();
+            output_triangles = simplifier.triangles.size();
+            return simplifier.write_obj(output);
+        }
+
+        //
+        // Write DiskMesh as OBJ, in pieces
+        //
+        bool write_disk_mesh_obj(const DiskMesh& mesh, const char* output)
+        {
+            FILE* out = fopen(output, "w");
+            FILE* in = fopen(mesh.vertex_file.c_str(), "rb");
+            bool ok = out && in;
+            std::vector<vec3f> positions;
+            std::string text;
+            for (size_t first = 0; first < mesh.vertex_count && ok; first += positions.size())
+            {
+                positions.resize(std::min(size_t(1)<<16, mesh.vertex_count-first));
+                ok = fread(positions.data(), sizeof(vec3f), positions.size(), in) == positions.size();
+                text.clear();
+                for (const vec3f& p: positions)
+                {
+                    text += "v ";
+                    Simplifier::append_double(text, p.x);
+                    text += ' ';
+                    Simplifier::append_double(text, p.y);
+                    text += ' ';
+                    Simplifier::append_double(text, p.z);
+                    text += '\n';
+                }
+                ok = ok && fwrite(text.data(), 1, text.size(), out) == text.size();
+            }
+            if (in) fclose(in);
+            ok = ok && for_each_triangles(mesh, 1<<16, [&](size_t, const int* ids, size_t n)
+            {
+                if (!ok) return;
+                text.clear();
+                for (size_t i = 0; i < 3*n; i += 3)
+                {
+                    text += 'f';
+                    for (int j: {0, 1, 2})
+                    {
+                        text += ' ';
+                        Simplifier::append_int(text, ids[i+j]+1);
+                    }
+                    text += '\n';
+                }
+                ok = fwrite(text.data(), 1, text.size(), out) == text.size();
+            });
+            if (out && fclose(out) != 0) ok = false;
+            if (!ok) message("write_obj: error writing \"%s\".\n", output);
+            output_vertices = mesh.vertex_count;
+            output_triangles = mesh.triangle_count;
+            return ok;
+        }
+    }; // class StreamingSimplifier
+} // namespace Simplify
+
+#endif // SIMPLIFY_STREAMING_H
@@ -0,0 +1,635 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Benchmark of the decimation methods of the Decimation module.
+//
+// Generated meshes (a bumpy sphere with the requested number of triangles)
+// or the given model files are decimated with each method and reduction
+// factor. For each run the wall time, peak resident memory, input triangles
+// per second, achieved reduction, and the maximum and mean deviation of the
+// output from the input surface at sample points (see
+// Simplify::measure_deviation) are written as CSV or JSON.
+//
+// Each run is done in a child process (this executable with --case), so that
+// its peak memory is not that of a previous run. It includes the input mesh,
+// which is generated or read in the child, and not the deviation, which is
+// measured after the peak is taken.
+//
+// Usage: DecimationBenchmark [options] [model files]
+//   --sizes 10000,100000    triangle counts of generated meshes, used if no
+//                           model file is given (default 10K, 100K, 1M)
+//   --reductions 0.5,0.9    reduction factors (default 0.5, 0.8, 0.95)
+//   --methods FastQuadric,Quadric
+//                           FastQuadric, Clustering, Quadric, DecimatePro
+//                           (default all)
+//   --threads 4             threads of FastQuadric and Clustering (default 1)
+//   --no-error              do not compute the distances
+//   --json                  write JSON instead of CSV
+//   --output results.csv    output file (default standard output)
+//   --case                  do a single run, in this process, with the given
+//                           size or model file, method and reduction factor,
+//                           and write its result line for the parent process
+
+#include "SimplifyDeviation.h"
+#include "vtkFastQuadricDecimation.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDecimatePro.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkOBJReader.h>
+#include <vtkPLYReader.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkQuadricDecimation.h>
+#include <vtkSmartPointer.h>
+#include <vtkSTLReader.h>
+#include <vtkTriangleFilter.h>
+#include <vtkXMLPolyDataReader.h>
+#include <vtksys/Process.h>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+struct Result
+{
+  std::string Model;
+  std::string Method;
+  vtkIdType InputTriangles{ 0 };
+  vtkIdType OutputTriangles{ 0 };
+  double ReductionFactor{ 0.0 };
+  double AchievedReduction{ 0.0 };
+  double Seconds{ 0.0 };
+  double TrianglesPerSecond{ 0.0 };
+  double PeakMemoryMB{ 0.0 };
+  double MaxSampledDeviation{ -1.0 }; // negative if not computed
+  double MeanSampledDeviation{ -1.0 };
+};
+
+// Prefix of the result line written by a child process, other lines of its
+// standard output (VTK messages) are ignored
+const char* CaseResultPrefix = "case result:";
+
+//----------------------------------------------------------------------------
+double GetPeakMemoryMB()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+    return 0.0;
+    }
+  return counters.PeakWorkingSetSize / 1048576.0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+    return 0.0;
+    }
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1048576.0; // bytes
+#else
+  return usage.ru_maxrss / 1024.0; // kilobytes
+#endif
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Sphere with bumps (so that decimation has to trade off accuracy) with
+// about triangleCount triangles
+vtkSmartPointer<vtkPolyData> GenerateMesh(vtkIdType triangleCount)
+{
+  // a latitude-longitude grid of n rows and 2n columns has 4n(n-1) triangles
+  vtkIdType rows = std::max<vtkIdType>(3, static_cast<vtkIdType>(std::sqrt(triangleCount / 4.0)) + 1);
+  vtkIdType columns = 2 * rows;
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints((rows - 1) * columns + 2);
+  points->SetPoint(0, 0.0, 0.0, 1.0);
+  for (vtkIdType i = 1; i < rows; ++i)
+    {
+    double theta = vtkMath::Pi() * i / rows;
+    for (vtkIdType j = 0; j < columns; ++j)
+      {
+      double phi = 2.0 * vtkMath::Pi() * j / columns;
+      double r = 1.0 + 0.05 * std::sin(5.0 * theta) * std::cos(3.0 * phi) + 0.01 * std::sin(23.0 * theta) * std::sin(17.0 * phi);
+      points->SetPoint(1 + (i - 1) * columns + j,
+        r * std::sin(theta) * std::cos(phi), r * std::sin(theta) * std::sin(phi), r * std::cos(theta));
+      }
+    }
+  vtkIdType lastPoint = (rows - 1) * columns + 1;
+  points->SetPoint(lastPoint, 0.0, 0.0, -1.0);
+
+  auto pointId = [columns](vtkIdType i, vtkIdType j) { return 1 + (i - 1) * columns + j % columns; };
+  vtkNew<vtkCellArray> polys;
+  polys->AllocateExact(2 * columns * (rows - 1), 6 * columns * (rows - 1));
+  for (vtkIdType j = 0; j < columns; ++j)
+    {
+    vtkIdType cap[3] = { 0, pointId(1, j), pointId(1, j + 1) };
+    polys->InsertNextCell(3, cap);
+    }
+  for (vtkIdType i = 1; i < rows - 1; ++i)
+    {
+    for (vtkIdType j = 0; j < columns; ++j)
+      {
+      vtkIdType lower[3] = { pointId(i, j), pointId(i + 1, j), pointId(i + 1, j + 1) };
+      vtkIdType upper[3] = { pointId(i, j), pointId(i + 1, j + 1), pointId(i, j + 1) };
+      polys->InsertNextCell(3, lower);
+      polys->InsertNextCell(3, upper);
+      }
+    }
+  for (vtkIdType j = 0; j < columns; ++j)
+    {
+    vtkIdType cap[3] = { pointId(rows - 1, j + 1), pointId(rows - 1, j), lastPoint };
+    polys->InsertNextCell(3, cap);
+    }
+
+  vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+  mesh->SetPoints(points);
+  mesh->SetPolys(polys);
+  return mesh;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> ReadMesh(const std::string& fileName)
+{
+  std::string ext = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(fileName));
+  vtkSmartPointer<vtkPolyDataAlgorithm> reader;
+  if (ext == ".obj")
+    {
+    vtkNew<vtkOBJReader> objReader;
+    objReader->SetFileName(fileName.c_str());
+    reader = objReader;
+    }
+  else if (ext == ".vtp")
+    {
+    vtkNew<vtkXMLPolyDataReader> vtpReader;
+    vtpReader->SetFileName(fileName.c_str());
+    reader = vtpReader;
+    }
+  else if (ext == ".stl")
+    {
+    vtkNew<vtkSTLReader> stlReader;
+    stlReader->SetFileName(fileName.c_str());
+    reader = stlReader;
+    }
+  else if (ext == ".ply")
+    {
+    vtkNew<vtkPLYReader> plyReader;
+    plyReader->SetFileName(fileName.c_str());
+    reader = plyReader;
+    }
+  else
+    {
+    return nullptr;
+    }
+  vtkNew<vtkTriangleFilter> triangles;
+  triangles->SetInputConnection(reader->GetOutputPort());
+  triangles->PassVertsOff();
+  triangles->PassLinesOff();
+  triangles->Update();
+  if (triangles->GetOutput()->GetNumberOfPolys() == 0)
+    {
+    return nullptr;
+    }
+  return triangles->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+// Copy triangle mesh for distance computation
+void ToSimplifier(vtkPolyData* polyData, Simplify::Simplifier& mesh)
+{
+  mesh.clear();
+  mesh.vertices.resize(polyData->GetNumberOfPoints());
+  double p[3];
+  for (size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+    polyData->GetPoint(i, p);
+    mesh.vertices[i].p = vec3f(p[0], p[1], p[2]);
+    }
+  vtkCellArray* polys = polyData->GetPolys();
+  mesh.triangles.reserve(polys->GetNumberOfCells());
+  vtkIdType numberOfPoints = 0;
+  const vtkIdType* pointIds = nullptr;
+  for (vtkIdType cellId = 0; cellId < polys->GetNumberOfCells(); ++cellId)
+    {
+    polys->GetCellAtId(cellId, numberOfPoints, pointIds);
+    if (numberOfPoints != 3)
+      {
+      continue;
+      }
+    Simplify::Triangle t;
+    for (int j = 0; j < 3; ++j)
+      {
+      t.v[j] = static_cast<int>(pointIds[j]);
+      }
+    t.attr = 0;
+    mesh.triangles.push_back(t);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> Decimate(vtkPolyData* input, const std::string& method, double reductionFactor, int threads)
+{
+  vtkSmartPointer<vtkPolyDataAlgorithm> decimate;
+  if (method == "FastQuadric" || method == "Clustering")
+    {
+    vtkNew<vtkFastQuadricDecimation> fastQuadric;
+    fastQuadric->SetTargetReduction(reductionFactor);
+    fastQuadric->SetVertexClustering(method == "Clustering");
+    fastQuadric->SetNumberOfThreads(threads);
+    decimate = fastQuadric;
+    }
+  else if (method == "Quadric")
+    {
+    vtkNew<vtkQuadricDecimation> quadric;
+    quadric->SetTargetReduction(reductionFactor);
+    decimate = quadric;
+    }
+  else if (method == "DecimatePro")
+    {
+    vtkNew<vtkDecimatePro> decimatePro;
+    decimatePro->SetTargetReduction(reductionFactor);
+    decimatePro->PreserveTopologyOn();
+    decimate = decimatePro;
+    }
+  else
+    {
+    return nullptr;
+    }
+  decimate->SetInputData(input);
+  decimate->Update();
+  return decimate->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+template<class T>
+bool ParseList(const std::string& text, std::vector<T>& values)
+{
+  values.clear();
+  std::istringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    {
+    std::istringstream itemStream(item);
+    T value;
+    if (!(itemStream >> value))
+      {
+      return false;
+      }
+    values.push_back(value);
+    }
+  return !values.empty();
+}
+
+//----------------------------------------------------------------------------
+// Decimate the input and measure the run, in this process
+bool RunCase(vtkPolyData* input, const std::string& method, double reductionFactor, int threads, bool computeError,
+  Result& result)
+{
+  auto startTime = std::chrono::steady_clock::now();
+  vtkSmartPointer<vtkPolyData> output = Decimate(input, method, reductionFactor, threads);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  if (!output)
+    {
+    std::cerr << "Unknown method: " << method << std::endl;
+    return false;
+    }
+  if (output->GetNumberOfPolys() == 0)
+    {
+    std::cerr << method << " " << reductionFactor << ": empty output" << std::endl;
+    return false;
+    }
+  result.Method = method;
+  result.InputTriangles = input->GetNumberOfPolys();
+  result.OutputTriangles = output->GetNumberOfPolys();
+  result.ReductionFactor = reductionFactor;
+  result.AchievedReduction = 1.0 - static_cast<double>(result.OutputTriangles) / result.InputTriangles;
+  result.Seconds = seconds;
+  result.TrianglesPerSecond = seconds > 0.0 ? result.InputTriangles / seconds : 0.0;
+  result.PeakMemoryMB = GetPeakMemoryMB();
+  if (computeError)
+    {
+    Simplify::Simplifier inputMesh;
+    ToSimplifier(input, inputMesh);
+    Simplify::SurfaceDistance inputSurface(inputMesh);
+    Simplify::Simplifier outputMesh;
+    outputMesh.threads = 0; // all cores, not part of the timing
+    ToSimplifier(output, outputMesh);
+    Simplify::Deviation deviation = Simplify::measure_deviation(inputMesh, inputSurface, outputMesh);
+    result.MaxSampledDeviation = deviation.sampled_max;
+    result.MeanSampledDeviation = deviation.sampled_mean;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Result line of a run in a child process, see ReadCaseResult
+void WriteCaseResult(std::ostream& os, const Result& r)
+{
+  os << CaseResultPrefix << std::setprecision(std::numeric_limits<double>::max_digits10)
+    << " " << r.InputTriangles << " " << r.OutputTriangles << " " << r.Seconds << " " << r.PeakMemoryMB
+    << " " << r.MaxSampledDeviation << " " << r.MeanSampledDeviation << std::endl;
+}
+
+//----------------------------------------------------------------------------
+bool ReadCaseResult(const std::string& output, Result& r)
+{
+  size_t start = output.find(CaseResultPrefix);
+  if (start == std::string::npos)
+    {
+    return false;
+    }
+  std::istringstream line(output.substr(start + strlen(CaseResultPrefix)));
+  if (!(line >> r.InputTriangles >> r.OutputTriangles >> r.Seconds >> r.PeakMemoryMB
+    >> r.MaxSampledDeviation >> r.MeanSampledDeviation))
+    {
+    return false;
+    }
+  r.AchievedReduction = 1.0 - static_cast<double>(r.OutputTriangles) / r.InputTriangles;
+  r.TrianglesPerSecond = r.Seconds > 0.0 ? r.InputTriangles / r.Seconds : 0.0;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Run a command, with its standard error shared with this process. Returns
+// true if it exited with EXIT_SUCCESS.
+bool RunProcess(const std::vector<std::string>& arguments, std::string& output)
+{
+  std::vector<const char*> command;
+  for (const std::string& argument : arguments)
+    {
+    command.push_back(argument.c_str());
+    }
+  command.push_back(nullptr);
+
+  vtksysProcess* process = vtksysProcess_New();
+  vtksysProcess_SetCommand(process, command.data());
+  vtksysProcess_SetPipeShared(process, vtksysProcess_Pipe_STDERR, 1);
+  vtksysProcess_Execute(process);
+  char* data = nullptr;
+  int length = 0;
+  while (int pipe = vtksysProcess_WaitForData(process, &data, &length, nullptr))
+    {
+    if (pipe == vtksysProcess_Pipe_STDOUT)
+      {
+      output.append(data, length);
+      }
+    }
+  vtksysProcess_WaitForExit(process, nullptr);
+  bool success = vtksysProcess_GetState(process) == vtksysProcess_State_Exited
+    && vtksysProcess_GetExitValue(process) == EXIT_SUCCESS;
+  if (vtksysProcess_GetState(process) == vtksysProcess_State_Error)
+    {
+    std::cerr << "Failed to run " << arguments[0] << ": " << vtksysProcess_GetErrorString(process) << std::endl;
+    }
+  else if (vtksysProcess_GetState(process) == vtksysProcess_State_Exception)
+    {
+    std::cerr << arguments[0] << " crashed: " << vtksysProcess_GetExceptionString(process) << std::endl;
+    }
+  vtksysProcess_Delete(process);
+  return success;
+}
+
+//----------------------------------------------------------------------------
+template<class T>
+std::string ToString(const T& value)
+{
+  std::ostringstream os;
+  os << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+  return os.str();
+}
+
+//----------------------------------------------------------------------------
+void WriteCSV(std::ostream& os, const std::vector<Result>& results)
+{
+  os << "model,method,input_triangles,output_triangles,reduction_factor,achieved_reduction,"
+    << "seconds,triangles_per_second,peak_memory_mb,max_sampled_deviation,mean_sampled_deviation\n";
+  for (const Result& r : results)
+    {
+    os << r.Model << "," << r.Method << "," << r.InputTriangles << "," << r.OutputTriangles << ","
+      << r.ReductionFactor << "," << r.AchievedReduction << "," << r.Seconds << "," << r.TrianglesPerSecond << ","
+      << r.PeakMemoryMB << "," << r.MaxSampledDeviation << "," << r.MeanSampledDeviation << "\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+void WriteJSON(std::ostream& os, const std::vector<Result>& results)
+{
+  os << "[\n";
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+    const Result& r = results[i];
+    // model names are file names, only quotes and backslashes need escaping
+    std::string model;
+    for (char c : r.Model)
+      {
+      if (c == '"' || c == '\\')
+        {
+        model += '\\';
+        }
+      model += c;
+      }
+    os << "  {\"model\": \"" << model << "\", \"method\": \"" << r.Method << "\""
+      << ", \"input_triangles\": " << r.InputTriangles << ", \"output_triangles\": " << r.OutputTriangles
+      << ", \"reduction_factor\": " << r.ReductionFactor << ", \"achieved_reduction\": " << r.AchievedReduction
+      << ", \"seconds\": " << r.Seconds << ", \"triangles_per_second\": " << r.TrianglesPerSecond
+      << ", \"peak_memory_mb\": " << r.PeakMemoryMB;
+    if (r.MaxSampledDeviation >= 0.0)
+      {
+      os << ", \"max_sampled_deviation\": " << r.MaxSampledDeviation
+        << ", \"mean_sampled_deviation\": " << r.MeanSampledDeviation;
+      }
+    os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+  os << "]\n";
+}
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  std::vector<vtkIdType> sizes = { 10000, 100000, 1000000 };
+  std::vector<double> reductionFactors = { 0.5, 0.8, 0.95 };
+  std::vector<std::string> methods = { "FastQuadric", "Clustering", "Quadric", "DecimatePro" };
+  int threads = 1;
+  bool computeError = true;
+  bool json = false;
+  bool singleCase = false;
+  std::string outputFileName;
+  std::vector<std::string> modelFileNames;
+  for (int i = 1; i < argc; ++i)
+    {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    bool valid = true;
+    if (arg == "--sizes" && hasValue)
+      {
+      valid = ParseList(argv[++i], sizes);
+      }
+    else if (arg == "--reductions" && hasValue)
+      {
+      valid = ParseList(argv[++i], reductionFactors);
+      }
+    else if (arg == "--methods" && hasValue)
+      {
+      valid = ParseList(argv[++i], methods);
+      }
+    else if (arg == "--threads" && hasValue)
+      {
+      threads = atoi(argv[++i]);
+      }
+    else if (arg == "--output" && hasValue)
+      {
+      outputFileName = argv[++i];
+      }
+    else if (arg == "--no-error")
+      {
+      computeError = false;
+      }
+    else if (arg == "--json")
+      {
+      json = true;
+      }
+    else if (arg == "--case")
+      {
+      singleCase = true;
+      }
+    else if (arg.compare(0, 2, "--") == 0)
+      {
+      valid = false;
+      }
+    else
+      {
+      modelFileNames.push_back(arg);
+      }
+    if (!valid)
+      {
+      std::cerr << "Invalid argument: " << arg << std::endl;
+      std::cerr << "Usage: " << argv[0] << " [--sizes n,...] [--reductions r,...] [--methods m,...] [--threads n]"
+        << " [--no-error] [--json] [--output file] [--case] [model files]" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  size_t modelCount = modelFileNames.empty() ? sizes.size() : modelFileNames.size();
+
+  if (singleCase)
+    {
+    if (modelCount != 1 || methods.size() != 1 || reductionFactors.size() != 1)
+      {
+      std::cerr << "--case needs a single size or model file, method and reduction factor" << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkSmartPointer<vtkPolyData> input = modelFileNames.empty() ? GenerateMesh(sizes[0]) : ReadMesh(modelFileNames[0]);
+    if (!input)
+      {
+      std::cerr << "Failed to read triangle mesh: " << modelFileNames[0] << std::endl;
+      return EXIT_FAILURE;
+      }
+    Result result;
+    if (!RunCase(input, methods[0], reductionFactors[0], threads, computeError, result))
+      {
+      return EXIT_FAILURE;
+      }
+    WriteCaseResult(std::cout, result);
+    return EXIT_SUCCESS;
+    }
+
+  std::vector<Result> results;
+  for (size_t modelIndex = 0; modelIndex < modelCount; ++modelIndex)
+    {
+    std::string modelName;
+    std::vector<std::string> modelArguments;
+    if (modelFileNames.empty())
+      {
+      modelName = "sphere" + ToString(sizes[modelIndex]);
+      modelArguments = { "--sizes", ToString(sizes[modelIndex]) };
+      }
+    else
+      {
+      modelName = modelFileNames[modelIndex];
+      modelArguments = { modelName };
+      }
+    std::cerr << modelName << std::endl;
+
+    for (const std::string& method : methods)
+      {
+      for (double reductionFactor : reductionFactors)
+        {
+        std::vector<std::string> arguments = { argv[0], "--case", "--methods", method,
+          "--reductions", ToString(reductionFactor), "--threads", ToString(threads) };
+        arguments.insert(arguments.end(), modelArguments.begin(), modelArguments.end());
+        if (!computeError)
+          {
+          arguments.push_back("--no-error");
+          }
+        std::string output;
+        Result result;
+        if (!RunProcess(arguments, output) || !ReadCaseResult(output, result))
+          {
+          std::cerr << modelName << " " << method << " " << reductionFactor << ": run failed" << std::endl;
+          return EXIT_FAILURE;
+          }
+        result.Model = modelName;
+        result.Method = method;
+        result.ReductionFactor = reductionFactor;
+        std::cerr << "  " << method << " " << reductionFactor << ": " << result.InputTriangles << " triangles, "
+          << result.Seconds << " s, " << result.PeakMemoryMB << " MB" << std::endl;
+        results.push_back(result);
+        }
+      }
+    }
+
+  std::ofstream outputFile;
+  if (!outputFileName.empty())
+    {
+    outputFile.open(outputFileName.c_str());
+    if (!outputFile)
+      {
+      std::cerr << "Failed to write " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::ostream& os = outputFileName.empty() ? std::cout : outputFile;
+  if (json)
+    {
+    WriteJSON(os, results);
+    }
+  else
+    {
+    WriteCSV(os, results);
+    }
+  return EXIT_SUCCESS;
+}
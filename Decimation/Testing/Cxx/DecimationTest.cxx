@@ -19,7 +19,20 @@
 
 extern "C" MODULE_IMPORT int ModuleEntryPoint(int, char* []);
 
+int SimplifyHeapTest(int, char* []);
+int SimplifyLosslessTest(int, char* []);
+int SimplifyOBJTest(int, char* []);
+int SimplifyParallelTest(int, char* []);
+int SimplifyStreamingTest(int, char* []);
+int SimplifyToleranceTest(int, char* []);
+
 void RegisterTests()
 {
   StringToTestFunctionMap["ModuleEntryPoint"] = ModuleEntryPoint;
+  StringToTestFunctionMap["SimplifyHeapTest"] = SimplifyHeapTest;
+  StringToTestFunctionMap["SimplifyLosslessTest"] = SimplifyLosslessTest;
+  StringToTestFunctionMap["SimplifyOBJTest"] = SimplifyOBJTest;
+  StringToTestFunctionMap["SimplifyParallelTest"] = SimplifyParallelTest;
+  StringToTestFunctionMap["SimplifyStreamingTest"] = SimplifyStreamingTest;
+  StringToTestFunctionMap["SimplifyToleranceTest"] = SimplifyToleranceTest;
 }
@@ -0,0 +1,66 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Priority queue mode of the FastQuadric simplifier (simplify_mesh_heap):
+// it reaches the same targets as the threshold sweep of simplify_mesh, and
+// since it collapses edges in order of increasing error, the result is at
+// least about as close to the input.
+
+#include "SimplifyDeviation.h"
+#include "SimplifyTestUtilities.h"
+
+// STD includes
+#include <cstdlib>
+
+//----------------------------------------------------------------------------
+int SimplifyHeapTest(int, char*[])
+{
+  Simplify::Simplifier input;
+  SimplifyTest::MakeBumpySphere(input, 70);
+  const Simplify::SurfaceDistance inputSurface(input);
+
+  for (double reduction : { 0.9, 0.98, 0.999 })
+    {
+    const int target = static_cast<int>(input.triangles.size() * (1.0 - reduction));
+
+    Simplify::Simplifier sweep = input;
+    sweep.simplify_mesh(target);
+    Simplify::Simplifier heap = input;
+    heap.simplify_mesh_heap(target);
+
+    CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(heap));
+    // edges that were rejected are retried, so the queue does not run dry
+    // before the target is reached
+    CHECK_SIMPLIFY(static_cast<int>(heap.triangles.size()) <= target);
+    CHECK_SIMPLIFY(heap.collapse_count > 0);
+
+    Simplify::Deviation sweepDeviation = Simplify::measure_deviation(input, inputSurface, sweep);
+    Simplify::Deviation heapDeviation = Simplify::measure_deviation(input, inputSurface, heap);
+    std::cout << "reduction " << reduction << " triangles " << heap.triangles.size()
+              << " mean deviation sweep " << sweepDeviation.sampled_mean << " heap " << heapDeviation.sampled_mean << std::endl;
+    CHECK_SIMPLIFY(heapDeviation.sampled_mean <= 1.05 * sweepDeviation.sampled_mean);
+    }
+
+  // the heap mode also honors locked and border vertices
+  Simplify::Simplifier open;
+  SimplifyTest::MakeBumpySphere(open, 40, true);
+  const int borderVertices = SimplifyTest::CountBorderVertices(open);
+  open.preserve_border = true;
+  open.simplify_mesh_heap(static_cast<int>(open.triangles.size() / 10));
+  CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(open));
+  CHECK_SIMPLIFY(SimplifyTest::CountBorderVertices(open) == borderVertices);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Lossless mode of the FastQuadric simplifier (simplify_mesh_lossless):
+// flat regions are reduced without moving the surface, and revisiting only
+// the triangles around changed vertices gives exactly the same mesh as
+// revisiting all triangles in every pass.
+
+#include "SimplifyDeviation.h"
+#include "SimplifyTestUtilities.h"
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Surface of the box [0,n]^3 made of unit squares split into triangles,
+// oriented outwards, added to the mesh
+void AddGridBox(Simplify::Simplifier& mesh, int n, const vec3f& origin)
+{
+  std::map<int, int> ids;
+  auto pointId = [&](int x, int y, int z)
+    {
+    int key = (z * (n + 1) + y) * (n + 1) + x;
+    auto found = ids.find(key);
+    if (found != ids.end())
+      {
+      return found->second;
+      }
+    Simplify::Simplifier::Vertex v = {};
+    v.p = origin + vec3f(x, y, z);
+    mesh.vertices.push_back(v);
+    ids[key] = static_cast<int>(mesh.vertices.size()) - 1;
+    return ids[key];
+    };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    for (int side = 0; side <= n; side += n)
+      {
+      for (int i = 0; i < n; ++i)
+        {
+        for (int j = 0; j < n; ++j)
+          {
+          int corners[4][3];
+          const int offsets[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+          for (int c = 0; c < 4; ++c)
+            {
+            corners[c][axis] = side;
+            corners[c][(axis + 1) % 3] = i + offsets[c][0];
+            corners[c][(axis + 2) % 3] = j + offsets[c][1];
+            }
+          int v[4];
+          for (int c = 0; c < 4; ++c)
+            {
+            v[c] = pointId(corners[c][0], corners[c][1], corners[c][2]);
+            }
+          // (axis+1, axis+2) is counterclockwise seen from +axis
+          const bool outwards = side == n;
+          const int fan[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+          for (const int* tri : fan)
+            {
+            Simplify::Triangle t;
+            t.v[0] = v[tri[0]];
+            t.v[1] = outwards ? v[tri[1]] : v[tri[2]];
+            t.v[2] = outwards ? v[tri[2]] : v[tri[1]];
+            t.attr = 0;
+            mesh.triangles.push_back(t);
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Lossless simplification that updates the mesh and tries all triangles in
+// every pass, as simplify_mesh_lossless did before only changed triangles
+// were revisited
+void SimplifyLosslessAllTriangles(Simplify::Simplifier& mesh)
+{
+  for (Simplify::Triangle& t : mesh.triangles)
+    {
+    t.deleted = 0;
+    }
+  int deletedTriangles = 0;
+  std::vector<int> deleted0, deleted1;
+  for (int iteration = 0; iteration < 9999; ++iteration)
+    {
+    mesh.update_mesh(iteration);
+    for (Simplify::Triangle& t : mesh.triangles)
+      {
+      t.dirty = 0;
+      }
+    const double threshold = DBL_EPSILON;
+    for (Simplify::Triangle& t : mesh.triangles)
+      {
+      if (t.err[3] > threshold || t.deleted || t.dirty)
+        {
+        continue;
+        }
+      for (int j = 0; j < 3; ++j)
+        {
+        if (t.err[j] >= threshold)
+          {
+          continue;
+          }
+        int i0 = t.v[j];
+        int i1 = t.v[(j + 1) % 3];
+        Simplify::Simplifier::Vertex& v0 = mesh.vertices[i0];
+        Simplify::Simplifier::Vertex& v1 = mesh.vertices[i1];
+        if (v0.border != v1.border || (mesh.preserve_border && v0.border)
+          || mesh.is_locked(i0) || mesh.is_locked(i1))
+          {
+          continue;
+          }
+        mesh.reserve_refs(v0.tcount + v1.tcount);
+        vec3f p;
+        mesh.calculate_error(i0, i1, p);
+        deleted0.resize(v0.tcount);
+        deleted1.resize(v1.tcount);
+        if (mesh.flipped(p, i0, i1, v0, v1, deleted0) || mesh.flipped(p, i1, i0, v1, v0, deleted1))
+          {
+          continue;
+          }
+        mesh.update_vertex_data(i0, i1, p);
+        v0.p = p;
+        mesh.quadrics[i0] += mesh.quadrics[i1];
+        size_t tstart = mesh.refs.size();
+        mesh.update_triangles(i0, v0, deleted0, deletedTriangles);
+        mesh.update_triangles(i0, v1, deleted1, deletedTriangles);
+        size_t tcount = mesh.refs.size() - tstart;
+        if (tcount <= v0.tcount)
+          {
+          if (tcount)
+            {
+            memcpy(&mesh.refs[v0.tstart], &mesh.refs[tstart], tcount * sizeof(Simplify::Ref));
+            }
+          }
+        else
+          {
+          v0.tstart = tstart;
+          }
+        v0.tcount = tcount;
+        v1.tcount = 0;
+        break;
+        }
+      }
+    if (deletedTriangles <= 0)
+      {
+      break;
+      }
+    deletedTriangles = 0;
+    }
+  mesh.compact_mesh();
+}
+}
+
+//----------------------------------------------------------------------------
+int SimplifyLosslessTest(int, char*[])
+{
+  // flat boxes next to a curved part, which needs many passes
+  Simplify::Simplifier input;
+  SimplifyTest::MakeBumpySphere(input, 40);
+  AddGridBox(input, 40, vec3f(2.0, 0.0, 0.0));
+  AddGridBox(input, 7, vec3f(2.0, 0.0, 50.0));
+  const Simplify::SurfaceDistance inputSurface(input);
+
+  Simplify::Simplifier lossless = input;
+  lossless.simplify_mesh_lossless();
+  CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(lossless));
+  CHECK_SIMPLIFY(lossless.triangles.size() < input.triangles.size() / 2);
+  Simplify::Deviation deviation = Simplify::measure_deviation(input, inputSurface, lossless);
+  std::cout << "triangles " << input.triangles.size() << " -> " << lossless.triangles.size()
+            << ", maximum deviation " << deviation.sampled_max << std::endl;
+  CHECK_SIMPLIFY(deviation.sampled_max < 1e-9);
+
+  // same mesh as revisiting all triangles
+  Simplify::Simplifier reference = input;
+  SimplifyLosslessAllTriangles(reference);
+  CHECK_SIMPLIFY(reference.vertices.size() == lossless.vertices.size());
+  CHECK_SIMPLIFY(reference.triangles.size() == lossless.triangles.size());
+  for (size_t i = 0; i < reference.vertices.size(); ++i)
+    {
+    const vec3f& a = reference.vertices[i].p;
+    const vec3f& b = lossless.vertices[i].p;
+    CHECK_SIMPLIFY(a.x == b.x && a.y == b.y && a.z == b.z);
+    }
+  for (size_t i = 0; i < reference.triangles.size(); ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      CHECK_SIMPLIFY(reference.triangles[i].v[j] == lossless.triangles[i].v[j]);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
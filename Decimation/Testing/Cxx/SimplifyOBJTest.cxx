@@ -0,0 +1,175 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// OBJ reading and writing of the FastQuadric simplifier: texture
+// coordinates, materials and polygons are read, faces that cannot be read
+// are skipped, and writing then reading again gives the same mesh.
+//
+// Usage: SimplifyOBJTest <temporary directory>
+
+#include "SimplifyTestUtilities.h"
+
+// STD includes
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+//----------------------------------------------------------------------------
+bool WriteFile(const std::string& fileName, const char* text)
+{
+  FILE* file = fopen(fileName.c_str(), "wb");
+  if (!file)
+    {
+    return false;
+    }
+  bool ok = fputs(text, file) >= 0;
+  return fclose(file) == 0 && ok;
+}
+
+//----------------------------------------------------------------------------
+bool Equal(const vec3f& a, const vec3f& b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+//----------------------------------------------------------------------------
+bool EqualMeshes(const Simplify::Simplifier& a, const Simplify::Simplifier& b)
+{
+  if (a.vertices.size() != b.vertices.size() || a.triangles.size() != b.triangles.size()
+    || a.attributes.size() != b.attributes.size() || a.materials != b.materials || a.mtllib != b.mtllib)
+    {
+    return false;
+    }
+  for (size_t i = 0; i < a.vertices.size(); ++i)
+    {
+    if (!Equal(a.vertices[i].p, b.vertices[i].p))
+      {
+      return false;
+      }
+    }
+  for (size_t i = 0; i < a.triangles.size(); ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      if (a.triangles[i].v[j] != b.triangles[i].v[j])
+        {
+        return false;
+        }
+      }
+    if (i < a.attributes.size())
+      {
+      if (a.attributes[i].material != b.attributes[i].material)
+        {
+        return false;
+        }
+      for (int j = 0; j < 3; ++j)
+        {
+        if (!Equal(a.attributes[i].uvs[j], b.attributes[i].uvs[j]))
+          {
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+}
+
+//----------------------------------------------------------------------------
+int SimplifyOBJTest(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: SimplifyOBJTest <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  const std::string inputFile = directory + "/SimplifyOBJTestInput.obj";
+  const std::string outputFile = directory + "/SimplifyOBJTestOutput.obj";
+
+  // A square pyramid with texture coordinates and two materials, the base
+  // is a quad. Faces with less than 3 vertices or unreadable vertices are
+  // skipped. Some lines end with CR LF.
+  const char* text =
+    "# pyramid\n"
+    "mtllib pyramid.mtl\n"
+    "v 0 0 0\n"
+    "v 1 0 0\r\n"
+    "v 1 1 0\n"
+    "v 0 1 0\n"
+    "v 0.5 0.5 1.25\n"
+    "vt 0 0\n"
+    "vt 1 0\n"
+    "vt 1 1\n"
+    "vt 0 1\n"
+    "vt 0.5 0.5\n"
+    "usemtl base\n"
+    "f 1/1 4/4 3/3 2/2\n"
+    "f 1/1 2/2\n"
+    "usemtl side\n"
+    "f 1/1/1 2/2/1 5/5/1\r\n"
+    "f 2/2 3/3 5/5 x\n"
+    "f 2/2 3/3 5/5\n"
+    "f 3/3 4/4 5/5\n"
+    "f 4/4 1/1 5/5\n";
+  CHECK_SIMPLIFY(WriteFile(inputFile, text));
+
+  Simplify::Simplifier input;
+  CHECK_SIMPLIFY(input.load_obj(inputFile.c_str(), true));
+  CHECK_SIMPLIFY(input.vertices.size() == 5);
+  CHECK_SIMPLIFY(input.triangles.size() == 6);
+  CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(input));
+  CHECK_SIMPLIFY(input.mtllib == "pyramid.mtl");
+  CHECK_SIMPLIFY(input.materials.size() == 2 && input.materials[0] == "base" && input.materials[1] == "side");
+  CHECK_SIMPLIFY(Equal(input.vertices[4].p, vec3f(0.5, 0.5, 1.25)));
+  CHECK_SIMPLIFY(input.attributes.size() == 6);
+  // the quad is split into a triangle fan
+  const int base[2][3] = { { 0, 3, 2 }, { 0, 2, 1 } };
+  for (int i = 0; i < 2; ++i)
+    {
+    CHECK_SIMPLIFY(input.attributes[i].material == 0);
+    for (int j = 0; j < 3; ++j)
+      {
+      CHECK_SIMPLIFY(input.triangles[i].v[j] == base[i][j]);
+      }
+    }
+  for (int i = 2; i < 6; ++i)
+    {
+    CHECK_SIMPLIFY(input.attributes[i].material == 1);
+    CHECK_SIMPLIFY(input.triangles[i].attr & Simplify::TEXCOORD);
+    }
+  CHECK_SIMPLIFY(Equal(input.attributes[2].uvs[2], vec3f(0.5, 0.5, 0.0)));
+  CHECK_SIMPLIFY(Equal(input.attributes[3].uvs[0], vec3f(1.0, 0.0, 0.0)));
+
+  // round trip
+  CHECK_SIMPLIFY(input.write_obj(outputFile.c_str()));
+  Simplify::Simplifier output;
+  CHECK_SIMPLIFY(output.load_obj(outputFile.c_str(), true));
+  CHECK_SIMPLIFY(EqualMeshes(input, output));
+
+  // faces with out of range vertices make the file unreadable
+  CHECK_SIMPLIFY(WriteFile(inputFile, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n"));
+  CHECK_SIMPLIFY(!input.load_obj(inputFile.c_str()));
+  CHECK_SIMPLIFY(input.triangles.empty());
+
+  // a missing file is reported
+  CHECK_SIMPLIFY(!input.load_obj((directory + "/SimplifyOBJTestMissing.obj").c_str()));
+
+  remove(inputFile.c_str());
+  remove(outputFile.c_str());
+  return EXIT_SUCCESS;
+}
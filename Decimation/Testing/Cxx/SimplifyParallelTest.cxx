@@ -0,0 +1,90 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Multi-threaded FastQuadric simplification (simplify_mesh_parallel): the
+// target is reached, vertices locked by the caller are kept (also inside
+// the blocks), locked and vertex_remap refer to the output mesh, and the
+// result is about as close to the input as simplify_mesh.
+
+#include "SimplifyDeviation.h"
+#include "SimplifyTestUtilities.h"
+
+// STD includes
+#include <cstdlib>
+
+//----------------------------------------------------------------------------
+int SimplifyParallelTest(int, char*[])
+{
+  Simplify::Simplifier input;
+  // 4 blocks need at least 40000 triangles
+  SimplifyTest::MakeBumpySphere(input, 110);
+  const Simplify::SurfaceDistance inputSurface(input);
+  const int target = static_cast<int>(input.triangles.size() / 20);
+
+  Simplify::Simplifier serial = input;
+  serial.simplify_mesh(target);
+
+  Simplify::Simplifier parallel = input;
+  parallel.simplify_mesh_parallel(target, 4);
+  CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(parallel));
+  CHECK_SIMPLIFY(static_cast<int>(parallel.triangles.size()) <= target);
+
+  // the seam pass continues with the error accumulated in the blocks
+  Simplify::Deviation serialDeviation = Simplify::measure_deviation(input, inputSurface, serial);
+  Simplify::Deviation parallelDeviation = Simplify::measure_deviation(input, inputSurface, parallel);
+  std::cout << "mean deviation serial " << serialDeviation.sampled_mean << " parallel " << parallelDeviation.sampled_mean
+            << ", max deviation serial " << serialDeviation.sampled_max << " parallel " << parallelDeviation.sampled_max << std::endl;
+  CHECK_SIMPLIFY(parallelDeviation.sampled_mean <= 1.1 * serialDeviation.sampled_mean);
+  CHECK_SIMPLIFY(parallelDeviation.sampled_max <= 1.5 * serialDeviation.sampled_max);
+
+  // vertex_remap maps input vertices to output vertices
+  CHECK_SIMPLIFY(parallel.vertex_remap.size() == input.vertices.size());
+  std::vector<char> used(parallel.vertices.size(), 0);
+  for (int id : parallel.vertex_remap)
+    {
+    CHECK_SIMPLIFY(id >= -1 && id < static_cast<int>(parallel.vertices.size()));
+    if (id >= 0)
+      {
+      used[id] = 1;
+      }
+    }
+  CHECK_SIMPLIFY(std::count(used.begin(), used.end(), 1) == static_cast<int>(parallel.vertices.size()));
+
+  // locked vertices are neither moved nor removed, in the blocks and in the
+  // seam pass
+  Simplify::Simplifier locked = input;
+  locked.locked.assign(input.vertices.size(), 0);
+  for (size_t i = 0; i < input.vertices.size(); i += 37)
+    {
+    locked.locked[i] = 1;
+    }
+  locked.simplify_mesh_parallel(target, 4);
+  CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(locked));
+  CHECK_SIMPLIFY(locked.locked.size() == locked.vertices.size());
+  int lockedCount = 0;
+  for (size_t i = 0; i < input.vertices.size(); i += 37)
+    {
+    const int id = locked.vertex_remap[i];
+    CHECK_SIMPLIFY(id >= 0);
+    CHECK_SIMPLIFY(locked.locked[id]);
+    const vec3f p = locked.vertices[id].p;
+    const vec3f p0 = input.vertices[i].p;
+    CHECK_SIMPLIFY(p.x == p0.x && p.y == p0.y && p.z == p0.z);
+    ++lockedCount;
+    }
+  CHECK_SIMPLIFY(std::count(locked.locked.begin(), locked.locked.end(), 1) == lockedCount);
+
+  return EXIT_SUCCESS;
+}
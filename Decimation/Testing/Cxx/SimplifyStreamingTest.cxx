@@ -0,0 +1,95 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Out-of-core simplification of OBJ files (SimplifyStreaming.h): small
+// memory budgets split the mesh into blocks, the seams are simplified in
+// the final pass with the quadrics of the blocks, a target that cannot be
+// reached within the budget is reported, and the statistics of a failed
+// run are not left over from the previous run.
+//
+// Usage: SimplifyStreamingTest <temporary directory>
+
+#include "SimplifyDeviation.h"
+#include "SimplifyStreaming.h"
+#include "SimplifyTestUtilities.h"
+
+// STD includes
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+//----------------------------------------------------------------------------
+int SimplifyStreamingTest(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: SimplifyStreamingTest <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  const std::string inputFile = directory + "/SimplifyStreamingTestInput.obj";
+  const std::string outputFile = directory + "/SimplifyStreamingTestOutput.obj";
+
+  // about 17 MB when simplified in memory
+  Simplify::Simplifier input;
+  SimplifyTest::MakeBumpySphere(input, 130);
+  CHECK_SIMPLIFY(input.write_obj(inputFile.c_str()));
+  const Simplify::SurfaceDistance inputSurface(input);
+  const double reduction = 0.9;
+  const int target = static_cast<int>(round(input.triangles.size() * (1.0 - reduction)));
+
+  // a budget of a few MB is split into blocks, and the block seams are
+  // simplified in the final pass
+  Simplify::StreamingSimplifier streaming;
+  streaming.memory_budget = size_t(8) << 20;
+  streaming.threads = 2;
+  CHECK_SIMPLIFY(streaming.simplify_obj(inputFile.c_str(), outputFile.c_str(), reduction));
+  CHECK_SIMPLIFY(streaming.input_triangles == input.triangles.size());
+  CHECK_SIMPLIFY(streaming.block_count > 1);
+  CHECK_SIMPLIFY(streaming.target_reached);
+  CHECK_SIMPLIFY(static_cast<int>(streaming.output_triangles) <= target);
+  Simplify::Simplifier output;
+  CHECK_SIMPLIFY(output.load_obj(outputFile.c_str()));
+  CHECK_SIMPLIFY(output.triangles.size() == streaming.output_triangles);
+  CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(output));
+
+  // the final pass continues with the error accumulated in the blocks, so
+  // the result is about as close to the input as in memory
+  Simplify::Simplifier inMemory = input;
+  inMemory.simplify_mesh(target);
+  Simplify::Deviation inMemoryDeviation = Simplify::measure_deviation(input, inputSurface, inMemory);
+  Simplify::Deviation streamingDeviation = Simplify::measure_deviation(input, inputSurface, output);
+  std::cout << "mean deviation in memory " << inMemoryDeviation.sampled_mean << " streaming " << streamingDeviation.sampled_mean
+            << " (" << streaming.block_count << " blocks)" << std::endl;
+  CHECK_SIMPLIFY(streamingDeviation.sampled_mean <= 1.2 * inMemoryDeviation.sampled_mean);
+
+  // if the blocks are not reduced enough to simplify the seams within the
+  // budget then the output is written but the target is not reached
+  CHECK_SIMPLIFY(streaming.simplify_obj(inputFile.c_str(), outputFile.c_str(), 0.3));
+  CHECK_SIMPLIFY(!streaming.target_reached);
+  CHECK_SIMPLIFY(streaming.output_triangles > static_cast<size_t>(round(input.triangles.size() * 0.7)));
+  CHECK_SIMPLIFY(output.load_obj(outputFile.c_str()));
+  CHECK_SIMPLIFY(output.triangles.size() == streaming.output_triangles);
+
+  // a failed run does not report the output of the previous one
+  streaming.memory_budget = size_t(1) << 16;
+  CHECK_SIMPLIFY(!streaming.simplify_obj(inputFile.c_str(), outputFile.c_str(), reduction));
+  CHECK_SIMPLIFY(streaming.output_vertices == 0 && streaming.output_triangles == 0);
+  CHECK_SIMPLIFY(!streaming.target_reached);
+
+  remove(inputFile.c_str());
+  remove(outputFile.c_str());
+  return EXIT_SUCCESS;
+}
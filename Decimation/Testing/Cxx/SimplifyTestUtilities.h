@@ -0,0 +1,147 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Meshes and checks shared by the tests of the FastQuadric simplifier
+// (Simplify.h).
+
+#ifndef __SimplifyTestUtilities_h
+#define __SimplifyTestUtilities_h
+
+#include "Simplify.h"
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+#define CHECK_SIMPLIFY(condition) \
+  if (!(condition)) \
+    { \
+    std::cerr << __FILE__ << "(" << __LINE__ << "): check failed: " #condition << std::endl; \
+    return EXIT_FAILURE; \
+    }
+
+namespace SimplifyTest
+{
+
+//----------------------------------------------------------------------------
+// Sphere with bumps (so that decimation has to trade off accuracy) made of
+// a latitude-longitude grid of rows rows and 2*rows columns, that is
+// 4*rows*(rows-1) triangles. If open, the triangles around the south pole
+// are left out, which leaves a boundary.
+template<class SimplifierType>
+void MakeBumpySphere(SimplifierType& simplifier, int rows, bool open = false)
+{
+  const double pi = 3.14159265358979323846;
+  const int columns = 2 * rows;
+  simplifier.clear();
+  simplifier.vertices.resize((rows - 1) * columns + 2);
+  simplifier.vertices[0].p = vec3f(0.0, 0.0, 1.0);
+  for (int i = 1; i < rows; ++i)
+    {
+    double theta = pi * i / rows;
+    for (int j = 0; j < columns; ++j)
+      {
+      double phi = 2.0 * pi * j / columns;
+      double r = 1.0 + 0.05 * sin(5.0 * theta) * cos(3.0 * phi) + 0.01 * sin(23.0 * theta) * sin(17.0 * phi);
+      simplifier.vertices[1 + (i - 1) * columns + j].p =
+        vec3f(r * sin(theta) * cos(phi), r * sin(theta) * sin(phi), r * cos(theta));
+      }
+    }
+  const int lastPoint = (rows - 1) * columns + 1;
+  simplifier.vertices[lastPoint].p = vec3f(0.0, 0.0, -1.0);
+
+  auto pointId = [columns](int i, int j) { return 1 + (i - 1) * columns + j % columns; };
+  auto addTriangle = [&simplifier](int a, int b, int c)
+    {
+    Simplify::Triangle t;
+    t.v[0] = a;
+    t.v[1] = b;
+    t.v[2] = c;
+    t.attr = 0;
+    simplifier.triangles.push_back(t);
+    };
+  for (int j = 0; j < columns; ++j)
+    {
+    addTriangle(0, pointId(1, j), pointId(1, j + 1));
+    }
+  for (int i = 1; i < rows - 1; ++i)
+    {
+    for (int j = 0; j < columns; ++j)
+      {
+      addTriangle(pointId(i, j), pointId(i + 1, j), pointId(i + 1, j + 1));
+      addTriangle(pointId(i, j), pointId(i + 1, j + 1), pointId(i, j + 1));
+      }
+    }
+  if (!open)
+    {
+    for (int j = 0; j < columns; ++j)
+      {
+      addTriangle(pointId(rows - 1, j + 1), pointId(rows - 1, j), lastPoint);
+      }
+    }
+  else
+    {
+    // the south pole is not used
+    simplifier.vertices.pop_back();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Number of vertices of the mesh on its boundary (edges with one triangle)
+template<class SimplifierType>
+int CountBorderVertices(const SimplifierType& simplifier)
+{
+  std::map<std::pair<int, int>, int> edges;
+  for (const Simplify::Triangle& t : simplifier.triangles)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      int a = t.v[j], b = t.v[(j + 1) % 3];
+      edges[std::make_pair(std::min(a, b), std::max(a, b))]++;
+      }
+    }
+  std::vector<char> border(simplifier.vertices.size(), 0);
+  for (const auto& edge : edges)
+    {
+    if (edge.second == 1)
+      {
+      border[edge.first.first] = border[edge.first.second] = 1;
+      }
+    }
+  return static_cast<int>(std::count(border.begin(), border.end(), 1));
+}
+
+//----------------------------------------------------------------------------
+// True if all triangles use valid and distinct vertices
+template<class SimplifierType>
+bool IsValidMesh(const SimplifierType& simplifier)
+{
+  const int n = static_cast<int>(simplifier.vertices.size());
+  for (const Simplify::Triangle& t : simplifier.triangles)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      if (t.v[j] < 0 || t.v[j] >= n || t.v[j] == t.v[(j + 1) % 3])
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Error-bounded simplification (simplify_to_tolerance): the mesh is reduced
+// in a single run while its deviation from the input stays within the
+// tolerance, densely sampled on the triangles of both meshes, larger
+// tolerances give smaller meshes, and if no reduction is within the
+// tolerance then the input is kept and reported as not reduced.
+
+#include "SimplifyDeviation.h"
+#include "SimplifyTestUtilities.h"
+
+// STD includes
+#include <cstdlib>
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Largest distance to surface of points on a grid of barycentric
+// coordinates in each triangle of mesh, including edges and corners
+double SampleMaximumDistance(const Simplify::Simplifier& mesh, const Simplify::SurfaceDistance& surface)
+{
+  const int steps = 8;
+  double maximum = 0;
+  for (const Simplify::Triangle& t : mesh.triangles)
+    {
+    vec3f a = mesh.vertices[t.v[0]].p, b = mesh.vertices[t.v[1]].p, c = mesh.vertices[t.v[2]].p;
+    for (int i = 0; i <= steps; ++i)
+      {
+      for (int j = 0; i + j <= steps; ++j)
+        {
+        vec3f p = a * (double(steps - i - j) / steps) + b * (double(i) / steps) + c * (double(j) / steps);
+        maximum = std::max(maximum, surface.distance(p));
+        }
+      }
+    }
+  return maximum;
+}
+}
+
+//----------------------------------------------------------------------------
+int SimplifyToleranceTest(int, char*[])
+{
+  Simplify::Simplifier input;
+  SimplifyTest::MakeBumpySphere(input, 30);
+  const Simplify::SurfaceDistance inputSurface(input);
+
+  size_t previousCount = input.triangles.size();
+  for (double tolerance : { 0.01, 0.03 })
+    {
+    for (bool heap : { false, true })
+      {
+      Simplify::Simplifier mesh = input;
+      int runs = 0;
+      Simplify::ToleranceResult result = Simplify::simplify_to_tolerance(mesh, tolerance,
+        [heap, &runs](Simplify::Simplifier& run)
+        {
+        ++runs;
+        if (heap)
+          {
+          run.simplify_mesh_heap(0);
+          }
+        else
+          {
+          run.simplify_mesh(0);
+          }
+        });
+      std::cout << "tolerance " << tolerance << (heap ? " heap" : " sweep") << ": triangles "
+                << mesh.triangles.size() << ", sampled deviation " << result.deviation.sampled_max << std::endl;
+      CHECK_SIMPLIFY(runs == 1);
+      CHECK_SIMPLIFY(result.reduced);
+      CHECK_SIMPLIFY(!mesh.aborted);
+      CHECK_SIMPLIFY(SimplifyTest::IsValidMesh(mesh));
+      CHECK_SIMPLIFY(mesh.triangles.size() < input.triangles.size());
+      CHECK_SIMPLIFY(!mesh.accept_collapse);
+
+      // the reported deviation is that of the returned mesh
+      Simplify::Deviation deviation = Simplify::measure_deviation(input, inputSurface, mesh);
+      CHECK_SIMPLIFY(deviation.sampled_max <= tolerance);
+      CHECK_SIMPLIFY(deviation.sampled_max == result.deviation.sampled_max);
+      CHECK_SIMPLIFY(deviation.sampled_mean == result.deviation.sampled_mean);
+
+      // the tolerance also holds on the edges and inside the triangles
+      const Simplify::SurfaceDistance outputSurface(mesh);
+      CHECK_SIMPLIFY(SampleMaximumDistance(mesh, inputSurface) <= tolerance);
+      CHECK_SIMPLIFY(SampleMaximumDistance(input, outputSurface) <= tolerance);
+      if (!heap)
+        {
+        CHECK_SIMPLIFY(mesh.triangles.size() < previousCount);
+        previousCount = mesh.triangles.size();
+        }
+      }
+    }
+
+  // no edge of the curved surface can be collapsed within a tiny tolerance
+  Simplify::Simplifier mesh = input;
+  Simplify::ToleranceResult result = Simplify::simplify_to_tolerance(mesh, 1e-9,
+    [](Simplify::Simplifier& run) { run.simplify_mesh(0); });
+  CHECK_SIMPLIFY(!result.reduced);
+  CHECK_SIMPLIFY(result.deviation.sampled_max == 0 && result.deviation.sampled_mean == 0);
+  CHECK_SIMPLIFY(mesh.triangles.size() == input.triangles.size());
+  CHECK_SIMPLIFY(mesh.vertices.size() == input.vertices.size());
+
+  return EXIT_SUCCESS;
+}
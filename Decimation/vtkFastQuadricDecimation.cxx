@@ -0,0 +1,429 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkFastQuadricDecimation.h"
+
+#include "Simplify.h"
+#include "SimplifyDeviation.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCommand.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+vtkStandardNewMacro(vtkFastQuadricDecimation);
+
+namespace
+{
+//----------------------------------------------------------------------------
+template<class T, class SimplifierType>
+void ReadPoints(const T* coords, SimplifierType& simplifier)
+{
+  simplifier.parallel_for(simplifier.vertices.size(), [&](size_t begin, size_t end)
+    {
+    for (size_t i = begin; i < end; ++i)
+      {
+      simplifier.vertices[i].p = vec3f(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+template<class SimplifierType, class T>
+void WritePoints(SimplifierType& simplifier, T* coords)
+{
+  simplifier.parallel_for(simplifier.vertices.size(), [&](size_t begin, size_t end)
+    {
+    for (size_t i = begin; i < end; ++i)
+      {
+      const vec3f p = simplifier.vertices[i].p;
+      coords[3 * i] = static_cast<T>(p.x);
+      coords[3 * i + 1] = static_cast<T>(p.y);
+      coords[3 * i + 2] = static_cast<T>(p.z);
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+// Copy triangles from cell array storage. Non-triangle cells are ignored and
+// counted in ignoredCells. Returns false if a point id is out of range.
+template<class T, class SimplifierType>
+bool ReadTriangles(const T* offsets, const T* connectivity, vtkIdType numberOfCells, vtkIdType numberOfPoints,
+  SimplifierType& simplifier, vtkIdType& ignoredCells)
+{
+  auto validIds = [numberOfPoints](const T* pointIds)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      if (pointIds[j] < 0 || static_cast<vtkIdType>(pointIds[j]) >= numberOfPoints)
+        {
+        return false;
+        }
+      }
+    return true;
+    };
+
+  ignoredCells = 0;
+  if (offsets[numberOfCells] == 3 * numberOfCells)
+    {
+    // all cells are triangles
+    simplifier.triangles.resize(numberOfCells);
+    std::atomic<bool> valid(true);
+    simplifier.parallel_for(numberOfCells, [&](size_t begin, size_t end)
+      {
+      for (size_t i = begin; i < end; ++i)
+        {
+        const T* pointIds = connectivity + 3 * i;
+        if (!validIds(pointIds))
+          {
+          valid = false;
+          return;
+          }
+        Simplify::Triangle& t = simplifier.triangles[i];
+        t.v[0] = static_cast<int>(pointIds[0]);
+        t.v[1] = static_cast<int>(pointIds[1]);
+        t.v[2] = static_cast<int>(pointIds[2]);
+        t.attr = 0;
+        }
+      });
+    return valid;
+    }
+
+  simplifier.triangles.reserve(numberOfCells);
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+    {
+    if (offsets[cellId + 1] - offsets[cellId] != 3)
+      {
+      ++ignoredCells;
+      continue;
+      }
+    const T* pointIds = connectivity + offsets[cellId];
+    if (!validIds(pointIds))
+      {
+      return false;
+      }
+    Simplify::Triangle t;
+    t.v[0] = static_cast<int>(pointIds[0]);
+    t.v[1] = static_cast<int>(pointIds[1]);
+    t.v[2] = static_cast<int>(pointIds[2]);
+    t.attr = 0;
+    simplifier.triangles.push_back(t);
+    }
+  return true;
+}
+}
+
+//----------------------------------------------------------------------------
+vtkFastQuadricDecimation::vtkFastQuadricDecimation() = default;
+
+//----------------------------------------------------------------------------
+vtkFastQuadricDecimation::~vtkFastQuadricDecimation() = default;
+
+//----------------------------------------------------------------------------
+int vtkFastQuadricDecimation::RequestData(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkPolyData* input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+
+  vtkPoints* inputPoints = input->GetPoints();
+  vtkCellArray* inputPolys = input->GetPolys();
+  if (!inputPoints || !inputPolys || inputPolys->GetNumberOfCells() == 0)
+    {
+    vtkDebugMacro(<< "No input triangles");
+    return 1;
+    }
+  if (inputPoints->GetNumberOfPoints() > std::numeric_limits<int>::max())
+    {
+    vtkErrorMacro(<< "Too many input points: " << inputPoints->GetNumberOfPoints());
+    return 0;
+    }
+  if (inputPolys->GetNumberOfCells() > std::numeric_limits<int>::max())
+    {
+    vtkErrorMacro(<< "Too many input cells: " << inputPolys->GetNumberOfCells());
+    return 0;
+    }
+
+  if (this->SinglePrecision)
+    {
+    return this->Decimate<Simplify::BasicSimplifier<float> >(inputPoints, inputPolys, input->GetPointData(), output);
+    }
+  return this->Decimate<Simplify::Simplifier>(inputPoints, inputPolys, input->GetPointData(), output);
+}
+
+//----------------------------------------------------------------------------
+template<class SimplifierType>
+int vtkFastQuadricDecimation::Decimate(vtkPoints* inputPoints, vtkCellArray* inputPolys,
+  vtkPointData* inputPointData, vtkPolyData* output)
+{
+  SimplifierType simplifier;
+  simplifier.threads = this->NumberOfThreads;
+  simplifier.preserve_border = this->PreserveBoundary;
+  if (this->HasObserver(vtkCommand::MessageEvent))
+    {
+    simplifier.log = [this](const char* text)
+      {
+      this->InvokeEvent(vtkCommand::MessageEvent, const_cast<char*>(text));
+      };
+    }
+
+  // Input points
+  simplifier.vertices.resize(inputPoints->GetNumberOfPoints());
+  vtkDataArray* inputCoords = inputPoints->GetData();
+  if (vtkDoubleArray* coords = vtkDoubleArray::FastDownCast(inputCoords))
+    {
+    ReadPoints(coords->GetPointer(0), simplifier);
+    }
+  else if (vtkFloatArray* coords = vtkFloatArray::FastDownCast(inputCoords))
+    {
+    ReadPoints(coords->GetPointer(0), simplifier);
+    }
+  else
+    {
+    double p[3];
+    for (size_t i = 0; i < simplifier.vertices.size(); ++i)
+      {
+      inputPoints->GetPoint(i, p);
+      simplifier.vertices[i].p = vec3f(p[0], p[1], p[2]);
+      }
+    }
+
+  // Input triangles
+  vtkIdType numberOfPoints = inputPoints->GetNumberOfPoints();
+  vtkIdType ignoredCells = 0;
+  bool validIds = inputPolys->IsStorage64Bit()
+    ? ReadTriangles(inputPolys->GetOffsetsArray64()->GetPointer(0), inputPolys->GetConnectivityArray64()->GetPointer(0),
+        inputPolys->GetNumberOfCells(), numberOfPoints, simplifier, ignoredCells)
+    : ReadTriangles(inputPolys->GetOffsetsArray32()->GetPointer(0), inputPolys->GetConnectivityArray32()->GetPointer(0),
+        inputPolys->GetNumberOfCells(), numberOfPoints, simplifier, ignoredCells);
+  if (!validIds)
+    {
+    vtkErrorMacro(<< "Input triangles have point ids out of range [0, " << numberOfPoints << ")");
+    return 0;
+    }
+  if (ignoredCells > 0)
+    {
+    vtkWarningMacro(<< "Input contains " << ignoredCells << " non-triangle cells, they are ignored");
+    }
+
+  // Input point data, the components of all numeric arrays are stored
+  // together for each vertex
+  std::vector<int> pointArrays;
+  if (this->MapPointData && inputPointData)
+    {
+    for (int arrayIndex = 0; arrayIndex < inputPointData->GetNumberOfArrays(); ++arrayIndex)
+      {
+      vtkDataArray* array = inputPointData->GetArray(arrayIndex); // nullptr if not numeric
+      if (!array)
+        {
+        continue;
+        }
+      pointArrays.push_back(arrayIndex);
+      bool discrete = array->GetDataType() != VTK_FLOAT && array->GetDataType() != VTK_DOUBLE;
+      simplifier.vertex_data_discrete.insert(simplifier.vertex_data_discrete.end(), array->GetNumberOfComponents(), discrete);
+      simplifier.vertex_data_size += array->GetNumberOfComponents();
+      }
+    }
+  if (simplifier.vertex_data_size > 0)
+    {
+    simplifier.vertex_data.resize(simplifier.vertices.size() * simplifier.vertex_data_size);
+    int offset = 0;
+    for (int arrayIndex : pointArrays)
+      {
+      vtkDataArray* array = inputPointData->GetArray(arrayIndex);
+      simplifier.parallel_for(simplifier.vertices.size(), [&](size_t begin, size_t end)
+        {
+        for (size_t i = begin; i < end; ++i)
+          {
+          array->GetTuple(i, &simplifier.vertex_data[i * simplifier.vertex_data_size + offset]);
+          }
+        });
+      offset += array->GetNumberOfComponents();
+      }
+    }
+  this->UpdateProgress(0.1);
+  simplifier.progress = [this](double fraction)
+    {
+    this->UpdateProgress(0.1 + 0.8 * fraction);
+    return !this->GetAbortExecute();
+    };
+
+  auto simplify = [this](SimplifierType& mesh, int targetCount)
+    {
+    if (this->PriorityQueue)
+      {
+      mesh.simplify_mesh_heap(targetCount, this->Verbose);
+      }
+    else if (this->NumberOfThreads != 1)
+      {
+      mesh.simplify_mesh_parallel(targetCount, this->NumberOfThreads, this->Aggressiveness, this->Verbose);
+      }
+    else
+      {
+      mesh.simplify_mesh(targetCount, this->Aggressiveness, this->Verbose);
+      }
+    };
+  this->OutputSampledMaximumDeviation = 0.0;
+  this->OutputSampledMeanDeviation = 0.0;
+  this->OutputReduced = true;
+  int targetCount = static_cast<int>(std::round(simplifier.triangles.size() * (1.0 - this->TargetReduction)));
+  if (this->VertexClustering)
+    {
+    simplifier.simplify_mesh_clustering(targetCount, this->ClusterCellSize, this->Verbose);
+    }
+  else if (this->Lossless)
+    {
+    simplifier.simplify_mesh_lossless(this->Verbose);
+    }
+  else if (this->MaximumDeviation > 0.0)
+    {
+    Simplify::ToleranceResult result = Simplify::simplify_to_tolerance(simplifier, this->MaximumDeviation,
+      [&simplify](SimplifierType& mesh) { simplify(mesh, 0); }, this->Verbose);
+    this->OutputReduced = result.reduced;
+    this->OutputSampledMaximumDeviation = result.deviation.sampled_max;
+    this->OutputSampledMeanDeviation = result.deviation.sampled_mean;
+    }
+  else
+    {
+    simplify(simplifier, targetCount);
+    }
+  if (this->Verbose)
+    {
+    simplifier.print_statistics();
+    }
+  if (simplifier.aborted)
+    {
+    // leave the output empty, as other filters do on abort
+    return 1;
+    }
+  this->UpdateProgress(0.9);
+
+  // Output points, same precision as input
+  vtkNew<vtkPoints> points;
+  points->SetDataType(inputPoints->GetDataType() == VTK_DOUBLE ? VTK_DOUBLE : VTK_FLOAT);
+  points->SetNumberOfPoints(simplifier.vertices.size());
+  if (vtkDoubleArray* coords = vtkDoubleArray::FastDownCast(points->GetData()))
+    {
+    WritePoints(simplifier, coords->GetPointer(0));
+    }
+  else
+    {
+    WritePoints(simplifier, vtkFloatArray::FastDownCast(points->GetData())->GetPointer(0));
+    }
+
+  // Output triangles
+  vtkIdType numberOfTriangles = static_cast<vtkIdType>(simplifier.triangles.size());
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(numberOfTriangles + 1);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(3 * numberOfTriangles);
+  vtkIdType* offsetsPtr = offsets->GetPointer(0);
+  vtkIdType* connectivityPtr = connectivity->GetPointer(0);
+  simplifier.parallel_for(simplifier.triangles.size(), [&](size_t begin, size_t end)
+    {
+    for (size_t i = begin; i < end; ++i)
+      {
+      const Simplify::Triangle& t = simplifier.triangles[i];
+      offsetsPtr[i] = 3 * i;
+      connectivityPtr[3 * i] = t.v[0];
+      connectivityPtr[3 * i + 1] = t.v[1];
+      connectivityPtr[3 * i + 2] = t.v[2];
+      }
+    });
+  offsetsPtr[numberOfTriangles] = 3 * numberOfTriangles;
+  vtkNew<vtkCellArray> polys;
+  polys->SetData(offsets.GetPointer(), connectivity.GetPointer());
+
+  // Output point data, same arrays as input
+  vtkPointData* outputPointData = output->GetPointData();
+  int offset = 0;
+  for (int arrayIndex : pointArrays)
+    {
+    vtkDataArray* array = inputPointData->GetArray(arrayIndex);
+    int numberOfComponents = array->GetNumberOfComponents();
+    int attribute = inputPointData->IsArrayAnAttribute(arrayIndex);
+    vtkSmartPointer<vtkDataArray> outputArray = vtkSmartPointer<vtkDataArray>::Take(array->NewInstance());
+    outputArray->SetName(array->GetName());
+    outputArray->SetNumberOfComponents(numberOfComponents);
+    outputArray->SetNumberOfTuples(simplifier.vertices.size());
+    std::vector<double> tuple(numberOfComponents);
+    for (size_t i = 0; i < simplifier.vertices.size(); ++i)
+      {
+      const double* values = &simplifier.vertex_data[i * simplifier.vertex_data_size + offset];
+      tuple.assign(values, values + numberOfComponents);
+      if (attribute == vtkDataSetAttributes::NORMALS)
+        {
+        double length = 0.0;
+        for (double value : tuple)
+          {
+          length += value * value;
+          }
+        length = std::sqrt(length);
+        for (double& value : tuple)
+          {
+          value = length > 0.0 ? value / length : value;
+          }
+        }
+      outputArray->SetTuple(i, tuple.data());
+      }
+    int outputArrayIndex = outputPointData->AddArray(outputArray);
+    if (attribute >= 0)
+      {
+      outputPointData->SetActiveAttribute(outputArrayIndex, attribute);
+      }
+    offset += numberOfComponents;
+    }
+
+  output->SetPoints(points);
+  output->SetPolys(polys);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkFastQuadricDecimation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "TargetReduction: " << this->TargetReduction << "\n";
+  os << indent << "Aggressiveness: " << this->Aggressiveness << "\n";
+  os << indent << "Lossless: " << (this->Lossless ? "On" : "Off") << "\n";
+  os << indent << "PriorityQueue: " << (this->PriorityQueue ? "On" : "Off") << "\n";
+  os << indent << "PreserveBoundary: " << (this->PreserveBoundary ? "On" : "Off") << "\n";
+  os << indent << "MaximumDeviation: " << this->MaximumDeviation << "\n";
+  os << indent << "OutputSampledMaximumDeviation: " << this->OutputSampledMaximumDeviation << "\n";
+  os << indent << "OutputSampledMeanDeviation: " << this->OutputSampledMeanDeviation << "\n";
+  os << indent << "OutputReduced: " << this->OutputReduced << "\n";
+  os << indent << "SinglePrecision: " << (this->SinglePrecision ? "On" : "Off") << "\n";
+  os << indent << "VertexClustering: " << (this->VertexClustering ? "On" : "Off") << "\n";
+  os << indent << "ClusterCellSize: " << this->ClusterCellSize << "\n";
+  os << indent << "MapPointData: " << (this->MapPointData ? "On" : "Off") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "Verbose: " << (this->Verbose ? "On" : "Off") << "\n";
+}
@@ -0,0 +1,169 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkFastQuadricDecimation - Reduce the number of triangles in a mesh
+// .SECTION Description
+// Decimates a triangle mesh using Sven Forstmann's fast quadric mesh
+// simplification (see Simplify.h). Points and triangles are read directly
+// from the input point and cell array buffers and the output is written the
+// same way, so no intermediate file or per-element VTK API calls are needed.
+//
+// The input must contain triangles only (use vtkTriangleFilter otherwise),
+// non-triangle cells are ignored. Cell data is not passed to the output,
+// point data only if MapPointData is enabled.
+//
+// ProgressEvent is invoked during the decimation. If AbortExecute is set
+// then the decimation stops at the next progress update and the output is
+// empty.
+
+#ifndef vtkFastQuadricDecimation_h
+#define vtkFastQuadricDecimation_h
+
+#include <vtkPolyDataAlgorithm.h>
+
+class vtkCellArray;
+class vtkPointData;
+class vtkPoints;
+
+class vtkFastQuadricDecimation : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkFastQuadricDecimation* New();
+  vtkTypeMacro(vtkFastQuadricDecimation, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Ratio of triangles that are requested to be eliminated.
+  /// 0.8 means that the mesh size is requested to be reduced by 80%.
+  vtkSetClampMacro(TargetReduction, double, 0.0, 1.0);
+  vtkGetMacro(TargetReduction, double);
+
+  /// Balances between accuracy and computation time (default = 7.0).
+  vtkSetMacro(Aggressiveness, double);
+  vtkGetMacro(Aggressiveness, double);
+
+  /// Remove all edges that can be removed without changing the shape,
+  /// TargetReduction is ignored.
+  vtkSetMacro(Lossless, bool);
+  vtkGetMacro(Lossless, bool);
+  vtkBooleanMacro(Lossless, bool);
+
+  /// Collapse edges strictly in order of increasing error.
+  vtkSetMacro(PriorityQueue, bool);
+  vtkGetMacro(PriorityQueue, bool);
+  vtkBooleanMacro(PriorityQueue, bool);
+
+  /// Keep all vertices on the boundary of open surfaces (edges used by a
+  /// single triangle) unchanged. Otherwise boundary edges can be collapsed
+  /// along the boundary. Ignored by VertexClustering. Default is off.
+  vtkSetMacro(PreserveBoundary, bool);
+  vtkGetMacro(PreserveBoundary, bool);
+  vtkBooleanMacro(PreserveBoundary, bool);
+
+  /// If positive then the mesh is reduced as much as possible while its
+  /// distance from the input surface is at most this value, and
+  /// TargetReduction is ignored. Each collapse is checked against the input
+  /// surface, so the distance holds for every point of both surfaces (see
+  /// SimplifyDeviation.h). The decimation is slower then and runs on a
+  /// single thread. Default is 0 (disabled).
+  vtkSetClampMacro(MaximumDeviation, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(MaximumDeviation, double);
+
+  /// Maximum and mean distance between output and input surface at the
+  /// vertices of both meshes and the triangle centers of the output,
+  /// computed if MaximumDeviation is enabled.
+  vtkGetMacro(OutputSampledMaximumDeviation, double);
+  vtkGetMacro(OutputSampledMeanDeviation, double);
+
+  /// False if MaximumDeviation is enabled and the mesh could not be reduced
+  /// within it, then the output is the input mesh.
+  vtkGetMacro(OutputReduced, bool);
+
+  /// Store vertex positions in single precision during decimation, which
+  /// reduces memory usage. Quadrics are still accumulated in double
+  /// precision. Output points have the same data type as the input points.
+  vtkSetMacro(SinglePrecision, bool);
+  vtkGetMacro(SinglePrecision, bool);
+  vtkBooleanMacro(SinglePrecision, bool);
+
+  /// Merge vertices in the cells of a uniform grid instead of collapsing
+  /// edges. Much faster but lower quality and the topology is not
+  /// preserved, mainly useful for previews. Finding the cell of each vertex
+  /// and the merged points uses NumberOfThreads, numbering the cells and
+  /// removing duplicate triangles is done on one thread.
+  /// The cell size is chosen to approximately reach TargetReduction, unless
+  /// ClusterCellSize is set. Lossless, PriorityQueue and MaximumDeviation
+  /// are ignored.
+  vtkSetMacro(VertexClustering, bool);
+  vtkGetMacro(VertexClustering, bool);
+  vtkBooleanMacro(VertexClustering, bool);
+
+  /// Edge length of the grid cells for VertexClustering, in the units of
+  /// the points. Default is 0 (computed from TargetReduction).
+  vtkSetClampMacro(ClusterCellSize, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(ClusterCellSize, double);
+
+  /// Pass numeric point data arrays to the output. Values of the merged
+  /// vertices are interpolated at the position of the collapse, so the
+  /// input does not need to be resampled afterwards. Integer arrays (e.g.
+  /// labels) take the value of the nearer vertex instead and normals are
+  /// normalized. Default is off.
+  vtkSetMacro(MapPointData, bool);
+  vtkGetMacro(MapPointData, bool);
+  vtkBooleanMacro(MapPointData, bool);
+
+  /// Number of threads, 0 means the number of processor cores.
+  /// If not 1 then the mesh is decimated in spatial blocks concurrently.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Print progress of the decimation and the time spent in each phase.
+  /// Messages are sent as vtkCommand::MessageEvent (call data is the
+  /// const char* text) if there is an observer, otherwise they are printed
+  /// to standard output.
+  vtkSetMacro(Verbose, bool);
+  vtkGetMacro(Verbose, bool);
+  vtkBooleanMacro(Verbose, bool);
+
+protected:
+  vtkFastQuadricDecimation();
+  ~vtkFastQuadricDecimation() override;
+
+  int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) override;
+
+  template<class SimplifierType>
+  int Decimate(vtkPoints* inputPoints, vtkCellArray* inputPolys, vtkPointData* inputPointData, vtkPolyData* output);
+
+  double TargetReduction{ 0.8 };
+  double Aggressiveness{ 7.0 };
+  bool Lossless{ false };
+  bool PriorityQueue{ false };
+  bool PreserveBoundary{ false };
+  double MaximumDeviation{ 0.0 };
+  double OutputSampledMaximumDeviation{ 0.0 };
+  double OutputSampledMeanDeviation{ 0.0 };
+  bool OutputReduced{ true };
+  bool SinglePrecision{ false };
+  bool VertexClustering{ false };
+  double ClusterCellSize{ 0.0 };
+  bool MapPointData{ false };
+  int NumberOfThreads{ 1 };
+  bool Verbose{ false };
+
+private:
+  vtkFastQuadricDecimation(const vtkFastQuadricDecimation&) = delete;
+  void operator=(const vtkFastQuadricDecimation&) = delete;
+};
+
+#endif
@@ -2,6 +2,8 @@
 #include "GW_Mesh.h"
 #include "GW_VertexIterator.h"
 
+#include <thread>
+
 #ifndef GW_USE_INLINE
     #include "GW_Mesh.inl"
 #endif
@@ -270,75 +272,127 @@ void GW_Mesh::BuildCurvatureData()
 /*------------------------------------------------------------------------------*/
 // Name : GW_Mesh::BuildConnectivity
 /**
+ *  \param  nNbrThread [GW_U32] Number of threads, 0 for the number of cores.
+ *
 *  Call this method when you have set the vertex and the face.
 *	This will set up the neighboorhood for each face.
 */
 /*------------------------------------------------------------------------------*/
-void GW_Mesh::BuildConnectivity()
+void GW_Mesh::BuildConnectivity( GW_U32 nNbrThread )
 {
-	T_FaceList* VertexToFaceMap = new T_FaceList[this->GetNbrVertex()];
-
-	// build the inverse map vertex->face
-	for(IT_FaceVector it = FaceVector_.begin(); it!=FaceVector_.end(); ++it )
+	const GW_U32 nNbrFace = this->GetNbrFace();
+	std::vector<int> Faces( 3*nNbrFace );
+	for( GW_U32 nFace=0; nFace<nNbrFace; ++nFace )
 	{
-		GW_Face* pFace = *it;
+		GW_Face* pFace = FaceVector_[nFace];
 		GW_ASSERT( pFace!=NULL );
 		for( GW_U32 i=0; i<3; ++i )
 		{
 			GW_Vertex* pVert = pFace->GetVertex(i);
 			GW_ASSERT(pVert!=NULL);
 			GW_ASSERT( pVert->GetID() <= this->GetNbrVertex() ); 
-			VertexToFaceMap[pVert->GetID()].push_back( pFace );
+			Faces[3*nFace+i] = (int) pVert->GetID();
 		}
 	}
 
-	// now we can set up connectivity
-	for( IT_FaceVector it=FaceVector_.begin(); it!=FaceVector_.end(); ++it )
-	{
-		GW_Face* pFace = *it;
-		GW_ASSERT( pFace!=NULL );
+	std::vector<int> FaceNeighbors( 3*nNbrFace );
+	GW_Mesh::ComputeFaceNeighbors( Faces.data(), nNbrFace, this->GetNbrVertex(), FaceNeighbors.data(), nNbrThread );
 
-		/* set up the neigbooring faces of the 3 vertices */
-		T_FaceList* pFaceLists[3];
+	for( GW_U32 nFace=0; nFace<nNbrFace; ++nFace )
+	{
 		for( GW_U32 i=0; i<3; ++i )
 		{
-			GW_Vertex* pVert = pFace->GetVertex(i);
-			pFaceLists[i] = &VertexToFaceMap[pVert->GetID()];
+			int nNeighbor = FaceNeighbors[3*nFace+i];
+			FaceVector_[nFace]->SetFaceNeighbor( nNeighbor>=0 ? FaceVector_[nNeighbor] : NULL, i );
 		}
+	}
+}
 
-		/* compute neighbor in the 3 directions */
-		for( GW_U32 i=0; i<3; ++i )
+/*------------------------------------------------------------------------------*/
+// Name : GW_Mesh::ComputeFaceNeighbors
+/**
+ *  \param  pFaces [int*] The 3 vertices of each face.
+ *  \param  nNbrFace [GW_U32] Number of faces.
+ *  \param  nNbrVertex [GW_U32] Number of vertices.
+ *  \param  pFaceNeighbors [int*] The 3 neighbors of each face, the i-th one
+ *		in front of the i-th vertex, -1 on borders.
+ *  \param  nNbrThread [GW_U32] Number of threads, 0 for the number of cores.
+ *
+ *  Match the half edges of the faces. They are bucketed by their smallest
+ *	vertex, then each bucket is sorted by the other vertex, so that the
+ *	faces sharing an edge are next to each other in increasing order.
+ *	The buckets are matched concurrently. The neighbors are the ones the
+ *	former face list intersection gave: on a manifold edge the two faces
+ *	see each other, on an edge shared by faces f0<f1<...<fn the first one
+ *	sees fn and the others see f0. Degenerate edges have no neighbor.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_Mesh::ComputeFaceNeighbors( const int* pFaces, GW_U32 nNbrFace, GW_U32 nNbrVertex, int* pFaceNeighbors, GW_U32 nNbrThread )
+{
+	const size_t nNbrHalfEdge = 3*(size_t) nNbrFace;
+
+	/* bucket the half edges (smallest vertex -> (other vertex, half edge)) */
+	std::vector<int> Offsets( nNbrVertex+1, 0 );
+	for( size_t h=0; h<nNbrHalfEdge; ++h )
+	{
+		size_t nFace = h-h%3;
+		int nVert1 = pFaces[nFace+(h+1)%3];
+		int nVert2 = pFaces[nFace+(h+2)%3];
+		if( nVert1!=nVert2 )
+			Offsets[GW_MIN(nVert1,nVert2)+1]++;
+	}
+	for( GW_U32 i=0; i<nNbrVertex; ++i )
+		Offsets[i+1] += Offsets[i];
+	std::vector< std::pair<int,int> > HalfEdges( Offsets[nNbrVertex] );
+	std::vector<int> Cursor( Offsets.begin(), Offsets.end()-1 );
+	for( size_t h=0; h<nNbrHalfEdge; ++h )
+	{
+		size_t nFace = h-h%3;
+		int nVert1 = pFaces[nFace+(h+1)%3];
+		int nVert2 = pFaces[nFace+(h+2)%3];
+		pFaceNeighbors[h] = -1;
+		if( nVert1!=nVert2 )
+			HalfEdges[Cursor[GW_MIN(nVert1,nVert2)]++] = std::make_pair( GW_MAX(nVert1,nVert2), (int) h );
+	}
+
+	/* match the half edges of a range of buckets */
+	auto MatchBuckets = [&]( GW_U32 nFirst, GW_U32 nLast )
+	{
+		for( GW_U32 nVert=nFirst; nVert<nLast; ++nVert )
 		{
-			GW_Face* pNeighbor = NULL;
-			GW_U32 i1 = (i+1)%3;
-			GW_U32 i2 = (i+2)%3;
-			/* we must find the intersection of the surrounding faces of these 2 vertex */
-			GW_Bool bFind = GW_False;
-			for( IT_FaceList it1 = pFaceLists[i1]->begin(); it1!=pFaceLists[i1]->end() && bFind!=GW_True; ++it1 )
+			std::pair<int,int>* pBegin = HalfEdges.data()+Offsets[nVert];
+			std::pair<int,int>* pEnd = HalfEdges.data()+Offsets[nVert+1];
+			std::sort( pBegin, pEnd );
+			for( std::pair<int,int>* pEdge=pBegin; pEdge!=pEnd; )
 			{
-				GW_Face* pFace1 = *it1;
-				for( IT_FaceList it2 = pFaceLists[i2]->begin(); it2!=pFaceLists[i2]->end() && bFind!=GW_True; ++it2 )
+				std::pair<int,int>* pNext = pEdge+1;
+				while( pNext!=pEnd && pNext->first==pEdge->first )
+					++pNext;
+				if( pNext-pEdge>1 )
 				{
-					GW_Face* pFace2 = *it2;
-					if( pFace1==pFace2 && pFace1!=pFace )
-					{
-						pNeighbor = pFace1;
-						bFind=GW_True;
-					}
+					pFaceNeighbors[pEdge->second] = (pNext-1)->second/3;
+					for( std::pair<int,int>* pOther=pEdge+1; pOther!=pNext; ++pOther )
+						pFaceNeighbors[pOther->second] = pEdge->second/3;
 				}
-			}
-			pFace->SetFaceNeighbor( pNeighbor, i );
-			/* make some test on the neighbor to assure symetry in the connectivity relationship */
-			if( pNeighbor!=NULL )
-			{
-				GW_I32 nEdgeNumber = pNeighbor->GetEdgeNumber( *pFace->GetVertex(i1),*pFace->GetVertex(i2) );
-				GW_ASSERT( nEdgeNumber>=0 );
-				pNeighbor->SetFaceNeighbor( pFace, nEdgeNumber );
+				pEdge = pNext;
 			}
 		}
-	}
-
-	GW_DELETEARRAY( VertexToFaceMap );
+	};
+
+	/* small meshes are not worth the threads */
+	if( nNbrThread==0 )
+		nNbrThread = std::thread::hardware_concurrency();
+	nNbrThread = GW_MIN( nNbrThread, nNbrFace/100000 );
+	if( nNbrThread<=1 )
+	{
+		MatchBuckets( 0, nNbrVertex );
+		return;
+	}
+	std::vector<std::thread> Threads;
+	for( GW_U32 i=0; i<nNbrThread; ++i )
+		Threads.push_back( std::thread( MatchBuckets, (GW_U32) (nNbrVertex*i/nNbrThread), (GW_U32) (nNbrVertex*(i+1)/nNbrThread) ) );
+	for( GW_U32 i=0; i<nNbrThread; ++i )
+		Threads[i].join();
 }
 
 
@@ -85,7 +85,8 @@ public:
 	void ScaleVertex( GW_Float rScale );
 	void TranslateVertex( const GW_Vector3D& Vect );
 
-	void BuildConnectivity();
+	void BuildConnectivity( GW_U32 nNbrThread=0 );
+	static void ComputeFaceNeighbors( const int* pFaces, GW_U32 nNbrFace, GW_U32 nNbrVertex, int* pFaceNeighbors, GW_U32 nNbrThread=0 );
 	void BuildRawNormal();
 	void BuildCurvatureData();
 
@@ -0,0 +1,448 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_CompactGeodesicMesh.cpp
+ *  \brief  Definition of class \c GW_CompactGeodesicMesh
+ */
+/*------------------------------------------------------------------------------*/
+
+#include "stdafx.h"
+#include "GW_CompactGeodesicMesh.h"
+
+#ifndef GW_USE_INLINE
+    #include "GW_CompactGeodesicMesh.inl"
+#endif
+
+using namespace GW;
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh constructor
+/**
+ *  Constructor.
+ */
+/*------------------------------------------------------------------------------*/
+GW_CompactGeodesicMesh::GW_CompactGeodesicMesh()
+:	WeightCallback_				( GW_CompactGeodesicMesh::BasicWeightCallback ),
+	ForceStopCallback_			( NULL ),
+	VertexInsersionCallback_	( NULL ),
+	bIsMarchingBegin_			( GW_False ),
+	bIsMarchingEnd_				( GW_False ),
+	bUseUnfolding_				( GW_True ),
+	CallbackData_				( NULL )
+{
+	Connectivity_ = std::make_shared<T_Connectivity>();
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh destructor
+/**
+ *  Destructor.
+ */
+/*------------------------------------------------------------------------------*/
+GW_CompactGeodesicMesh::~GW_CompactGeodesicMesh()
+{
+	/* nothing */
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::SetNbrVertex
+/**
+ *  \param  nNum [GW_U32] The number of vertex.
+ *
+ *  Resize the vertex array. The positions are set to zero and the
+ *  marching is reset.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::SetNbrVertex( GW_U32 nNum )
+{
+	this->DetachConnectivity();
+	heap.clear();
+	Connectivity_->Positions.assign( 3*nNum, 0 );
+	Vertices_.resize( nNum );
+	Connectivity_->VertexFaceOffsets.clear();
+	Connectivity_->VertexFaces.clear();
+	Connectivity_->VertexVertexOffsets.clear();
+	Connectivity_->VertexVertices.clear();
+	this->ResetGeodesicMesh();
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::SetNbrFace
+/**
+ *  \param  nNum [GW_U32] The number of faces.
+ *
+ *  Resize the face array.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::SetNbrFace( GW_U32 nNum )
+{
+	this->DetachConnectivity();
+	Connectivity_->Faces.assign( 3*nNum, 0 );
+	Connectivity_->FaceNeighbors.assign( 3*nNum, -1 );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::BuildConnectivity
+/**
+ *  \param  nNbrThread [GW_U32] Number of threads, 0 for the number of cores.
+ *
+ *  Compute the face neighbors and the rings of faces and vertices
+ *  around each vertex, as \c GW_Mesh::BuildConnectivity and the
+ *  iterators of \c GW_Vertex do.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::BuildConnectivity( GW_U32 nNbrThread )
+{
+	this->DetachConnectivity();
+	const int nNbrVertex = (int) this->GetNbrVertex();
+	const int nNbrFace = (int) this->GetNbrFace();
+
+	// build the inverse map vertex->face, faces in increasing order
+	std::vector<int> IncidenceOffsets( nNbrVertex+1, 0 );
+	for( int i=0; i<3*nNbrFace; ++i )
+		IncidenceOffsets[Connectivity_->Faces[i]+1]++;
+	for( int i=0; i<nNbrVertex; ++i )
+		IncidenceOffsets[i+1] += IncidenceOffsets[i];
+	std::vector<int> Incidence( 3*nNbrFace );
+	std::vector<int> Cursor( IncidenceOffsets.begin(), IncidenceOffsets.end()-1 );
+	for( int i=0; i<3*nNbrFace; ++i )
+		Incidence[Cursor[Connectivity_->Faces[i]]++] = i/3;
+
+	// now we can set up connectivity
+	Connectivity_->FaceNeighbors.resize( 3*nNbrFace );
+	GW_Mesh::ComputeFaceNeighbors( Connectivity_->Faces.data(), nNbrFace, nNbrVertex, Connectivity_->FaceNeighbors.data(), nNbrThread );
+
+	// the rings, starting from the first face of each vertex as GW_Face::SetVertex
+	Connectivity_->VertexFaceOffsets.assign( 1, 0 );
+	Connectivity_->VertexFaceOffsets.reserve( nNbrVertex+1 );
+	Connectivity_->VertexFaces.clear();
+	Connectivity_->VertexFaces.reserve( 3*nNbrFace );
+	Connectivity_->VertexVertexOffsets.assign( 1, 0 );
+	Connectivity_->VertexVertexOffsets.reserve( nNbrVertex+1 );
+	Connectivity_->VertexVertices.clear();
+	Connectivity_->VertexVertices.reserve( 3*nNbrFace+nNbrVertex );
+	for( int nVert=0; nVert<nNbrVertex; ++nVert )
+	{
+		int nNbrIncidentFace = IncidenceOffsets[nVert+1]-IncidenceOffsets[nVert];
+		int nFirstFace = nNbrIncidentFace>0 ? Incidence[IncidenceOffsets[nVert]] : -1;
+		this->BuildFaceRing( nVert, nFirstFace, nNbrIncidentFace );
+		Connectivity_->VertexFaceOffsets.push_back( (int) Connectivity_->VertexFaces.size() );
+		this->BuildVertexRing( nVert, nFirstFace, nNbrIncidentFace+1 );
+		Connectivity_->VertexVertexOffsets.push_back( (int) Connectivity_->VertexVertices.size() );
+	}
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::BuildFaceRing
+/**
+ *  \param  nVert [int] The vertex.
+ *  \param  nFirstFace [int] Its first face, -1 if none.
+ *  \param  nMaxSize [int] Bound on the size of the ring.
+ *
+ *  Append the faces around a vertex to \c T_Connectivity::VertexFaces, in the order of
+ *  \c GW_FaceIterator.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::BuildFaceRing( int nVert, int nFirstFace, int nMaxSize )
+{
+	if( nFirstFace<0 )
+		return;
+	int nFace = nFirstFace;
+	int nDirection = this->GetNextVertex( nFirstFace, nVert );
+	for( int nSize=0; nSize<nMaxSize; ++nSize )
+	{
+		Connectivity_->VertexFaces.push_back( nFace );
+		int nNextFace = this->GetFaceNeighbor( nFace, nDirection );
+		/* check for end() */
+		if( nNextFace==nFirstFace )
+			return;
+		if( nNextFace<0 )
+		{
+			/* we are on a border face : Rewind on the first face */
+			int nPrevFace = nFace;
+			nDirection = this->GetVertex( nFace, nDirection, nVert );
+			GW_U32 nIter = 0;
+			do
+			{
+				nFace = nPrevFace;
+				nPrevFace = this->GetFaceNeighbor( nPrevFace, nDirection );
+				nDirection = this->GetVertex( nFace, nVert, nDirection );
+				nIter++;
+				if( nIter>=20 )
+					return;	// this is on non-manifold ...
+			}
+			while( nPrevFace>=0 );
+			if( nFace==nFirstFace )
+				return;
+		}
+		else
+		{
+			nDirection = this->GetVertex( nFace, nVert, nDirection );
+			nFace = nNextFace;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::BuildVertexRing
+/**
+ *  \param  nVert [int] The vertex.
+ *  \param  nFirstFace [int] Its first face, -1 if none.
+ *  \param  nMaxSize [int] Bound on the size of the ring.
+ *
+ *  Append the vertices around a vertex to \c T_Connectivity::VertexVertices, in the
+ *  order of \c GW_VertexIterator.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::BuildVertexRing( int nVert, int nFirstFace, int nMaxSize )
+{
+	if( nFirstFace<0 )
+		return;
+	int nFace = nFirstFace;
+	int nDirection = this->GetNextVertex( nFirstFace, nVert );
+	int nPrevFace = -1;
+	for( int nSize=0; nSize<nMaxSize; ++nSize )
+	{
+		Connectivity_->VertexVertices.push_back( nDirection );
+		if( nFace<0 )
+		{
+			/* we are on a border face : Rewind on the first face */
+			for( int nIter=0; nPrevFace>=0 && nIter<nMaxSize; ++nIter )
+			{
+				nFace = nPrevFace;
+				nPrevFace = this->GetFaceNeighbor( nPrevFace, nDirection );
+				nDirection = this->GetVertex( nFace, nVert, nDirection );
+			}
+			if( nFace==nFirstFace || nPrevFace>=0 )
+				return;
+		}
+		else
+		{
+			int nNextFace = this->GetFaceNeighbor( nFace, nDirection );
+			/* check for end() */
+			if( nNextFace==nFirstFace )
+				return;
+			/* RMK : nNextFace can be -1 in case of a border edge */
+			nDirection = this->GetVertex( nFace, nVert, nDirection );
+			nPrevFace = nFace;
+			nFace = nNextFace;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetMemorySize
+/**
+ *  \return [size_t] Size of the arrays of the mesh, in bytes.
+ */
+/*------------------------------------------------------------------------------*/
+size_t GW_CompactGeodesicMesh::GetMemorySize() const
+{
+	return sizeof(*this) + Connectivity_->GetMemorySize()
+		+ Vertices_.capacity()*sizeof(T_CompactVertex);
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::T_Connectivity::GetMemorySize
+/**
+ *  \return [size_t] Size of the arrays, in bytes.
+ */
+/*------------------------------------------------------------------------------*/
+size_t GW_CompactGeodesicMesh::T_Connectivity::GetMemorySize() const
+{
+	return sizeof(*this)
+		+ Positions.capacity()*sizeof(GW_Float)
+		+ ( Faces.capacity() + FaceNeighbors.capacity()
+		  + VertexFaceOffsets.capacity() + VertexFaces.capacity()
+		  + VertexVertexOffsets.capacity() + VertexVertices.capacity() )*sizeof(int);
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetConnectivity
+/**
+ *  \return [std::shared_ptr<const T_Connectivity>] The geometry and adjacency.
+ *
+ *  Share the built mesh, e.g. to march on it with another
+ *  \c GW_CompactGeodesicMesh (see \c SetConnectivity).
+ */
+/*------------------------------------------------------------------------------*/
+std::shared_ptr<const GW_CompactGeodesicMesh::T_Connectivity> GW_CompactGeodesicMesh::GetConnectivity() const
+{
+	return Connectivity_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::SetConnectivity
+/**
+ *  \param  pConnectivity [std::shared_ptr<const T_Connectivity>] The geometry
+ *		and adjacency of a built mesh.
+ *
+ *  Use a mesh built by another \c GW_CompactGeodesicMesh instead of
+ *	building it again. It is not copied: the mesh construction methods
+ *	make a private copy before changing it. The marching is reset.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::SetConnectivity( const std::shared_ptr<const T_Connectivity>& pConnectivity )
+{
+	GW_ASSERT( pConnectivity!=NULL );
+	/* never written while shared, see DetachConnectivity */
+	Connectivity_ = std::const_pointer_cast<T_Connectivity>( pConnectivity );
+	heap.clear();
+	Vertices_.resize( Connectivity_->Positions.size()/3 );
+	this->ResetGeodesicMesh();
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::DetachConnectivity
+/**
+ *  Copy the geometry and adjacency if it is shared, before changing it.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::DetachConnectivity()
+{
+	if( Connectivity_.use_count()>1 )
+		Connectivity_ = std::make_shared<T_Connectivity>( *Connectivity_ );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::ResetGeodesicMesh
+/**
+ *  Reset the marching data of each vertex.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::ResetGeodesicMesh()
+{
+	heap.clear();
+	for( size_t i=0; i<Vertices_.size(); ++i )
+	{
+		T_CompactVertex& Vert = Vertices_[i];
+		Vert.rDistance = GW_INFINITE;
+		Vert.nFront = -1;
+		Vert.nHeapPosition = -1;
+		Vert.nState = GW_GeodesicVertex::kFar;
+	}
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::PerformFastMarching
+/**
+ *  \param  nStartVert [GW_I32] The starting point, -1 to use the ones already added.
+ *
+ *  Compute geodesic distance from a vertex to other one.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::PerformFastMarching( GW_I32 nStartVert )
+{
+	this->SetUpFastMarching( nStartVert );
+
+	/* main loop */
+	while( !this->PerformFastMarchingOneStep() )
+	{ }
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::SetUpFastMarching
+/**
+ *  \param  nStartVert [GW_I32] A start vertex to add, -1 if none.
+ *
+ *  Just initialize the fast marching process.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::SetUpFastMarching( GW_I32 nStartVert )
+{
+	GW_ASSERT( WeightCallback_!=NULL );
+	GW_ASSERT( Connectivity_->VertexVertexOffsets.size()==Vertices_.size()+1 );
+
+	if( nStartVert>=0 )
+		this->AddStartVertex( (GW_U32) nStartVert );
+
+	bIsMarchingBegin_ = GW_True;
+	bIsMarchingEnd_ = GW_False;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::PerformFastMarchingFlush
+/**
+ *  Continue the algorithm until it termins.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::PerformFastMarchingFlush()
+{
+	if( !bIsMarchingBegin_ )
+		this->SetUpFastMarching();
+
+	/* main loop */
+	while( !this->PerformFastMarchingOneStep() )
+	{ }
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::IsFastMarchingFinished
+/**
+ *  \return [GW_Bool] Response.
+ *
+ *  Is the algorhm finished ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_Bool GW_CompactGeodesicMesh::IsFastMarchingFinished()
+{
+	return bIsMarchingEnd_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::BuildGeodesicMesh
+/**
+ *  \param  Mesh [GW_GeodesicMesh&] An empty mesh.
+ *
+ *  Create the vertices and faces of an object mesh with the same
+ *  geometry, and build its connectivity.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::BuildGeodesicMesh( GW_GeodesicMesh& Mesh ) const
+{
+	const GW_U32 nNbrVertex = this->GetNbrVertex();
+	Mesh.SetNbrVertex( nNbrVertex );
+	for( GW_U32 i=0; i<nNbrVertex; ++i )
+	{
+		GW_GeodesicVertex& Vert = (GW_GeodesicVertex&) Mesh.CreateNewVertex();
+		Vert.SetPosition( this->GetPosition( i ) );
+		Mesh.SetVertex( i, &Vert );
+	}
+	const GW_U32 nNbrFace = this->GetNbrFace();
+	Mesh.SetNbrFace( nNbrFace );
+	for( GW_U32 i=0; i<nNbrFace; ++i )
+	{
+		GW_GeodesicFace& Face = (GW_GeodesicFace&) Mesh.CreateNewFace();
+		Face.SetVertex( *Mesh.GetVertex( this->GetFaceVertex( i, 0 ) ),
+						*Mesh.GetVertex( this->GetFaceVertex( i, 1 ) ),
+						*Mesh.GetVertex( this->GetFaceVertex( i, 2 ) ) );
+		Mesh.SetFace( i, &Face );
+	}
+	Mesh.BuildConnectivity();
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::CopyDistanceToGeodesicMesh
+/**
+ *  \param  Mesh [GW_GeodesicMesh&] A mesh made by \c BuildGeodesicMesh.
+ *
+ *  Copy the distance, state and front of each vertex.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicMesh::CopyDistanceToGeodesicMesh( GW_GeodesicMesh& Mesh ) const
+{
+	GW_ASSERT( Mesh.GetNbrVertex()==this->GetNbrVertex() );
+	const GW_U32 nNbrVertex = this->GetNbrVertex();
+	for( GW_U32 i=0; i<nNbrVertex; ++i )
+	{
+		const T_CompactVertex& CompactVert = Vertices_[i];
+		GW_GeodesicVertex* pVert = (GW_GeodesicVertex*) Mesh.GetVertex( i );
+		pVert->SetDistance( CompactVert.rDistance );
+		pVert->SetState( CompactVert.nState );
+		pVert->SetFront( CompactVert.nFront>=0 ? (GW_GeodesicVertex*) Mesh.GetVertex( CompactVert.nFront ) : NULL );
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,210 @@
+
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_CompactGeodesicMesh.h
+ *  \brief  Definition of class \c GW_CompactGeodesicMesh
+ */
+/*------------------------------------------------------------------------------*/
+
+#ifndef _GW_COMPACTGEODESICMESH_H_
+#define _GW_COMPACTGEODESICMESH_H_
+
+#include "../gw_core/GW_Config.h"
+#include "GW_GeodesicVertex.h"
+#include "GW_GeodesicMesh.h"
+
+#include "fmmtypes.h"
+
+#include <memory>
+
+namespace GW {
+
+/*------------------------------------------------------------------------------*/
+/**
+ *  \class  GW_CompactGeodesicMesh
+ *  \brief  A triangle mesh stored in flat arrays, for fast marching only.
+ *
+ *  Same fast marching as \c GW_GeodesicMesh, but vertices and faces are
+ *  indices instead of objects: positions and triangles are contiguous
+ *  arrays, the adjacency is stored in compressed rows (vertex->face and
+ *  vertex->vertex offsets), and the marching state of all vertices is one
+ *  array. The rings are stored in the order of \c GW_FaceIterator and
+ *  \c GW_VertexIterator, so that the marching visits the vertices in the
+ *  same order and gives the same distances as \c GW_GeodesicMesh.
+ *
+ *  Stopping vertices, front overlap information and the new dead vertex
+ *  and heuristic callbacks are not supported. Paths are extracted with
+ *  \c GW_CompactGeodesicPath, \c BuildGeodesicMesh gives an object mesh
+ *  with the same geometry if one is needed.
+ */
+/*------------------------------------------------------------------------------*/
+
+class GW_CompactGeodesicMesh
+{
+
+public:
+
+    /*------------------------------------------------------------------------------*/
+    /** \name Constructor and destructor */
+    /*------------------------------------------------------------------------------*/
+    //@{
+    GW_CompactGeodesicMesh();
+    virtual ~GW_CompactGeodesicMesh();
+    //@}
+
+    //-------------------------------------------------------------------------
+    /** \name Mesh construction. */
+    //-------------------------------------------------------------------------
+	//@{
+	void SetNbrVertex( GW_U32 nNum );
+	GW_U32 GetNbrVertex() const;
+	void SetPosition( GW_U32 nVert, GW_Float x, GW_Float y, GW_Float z );
+	GW_Vector3D GetPosition( GW_U32 nVert ) const;
+	void SetNbrFace( GW_U32 nNum );
+	GW_U32 GetNbrFace() const;
+	void SetFace( GW_U32 nFace, GW_U32 nVert0, GW_U32 nVert1, GW_U32 nVert2 );
+	GW_U32 GetFaceVertex( GW_U32 nFace, GW_U32 nNum ) const;
+	void BuildConnectivity( GW_U32 nNbrThread=0 );
+	size_t GetMemorySize() const;
+	//@}
+
+    //-------------------------------------------------------------------------
+    /** \name Fast marching computations. */
+    //-------------------------------------------------------------------------
+	//@{
+	void ResetGeodesicMesh();
+	void AddStartVertex( GW_U32 nStartVert );
+	void PerformFastMarching( GW_I32 nStartVert=-1 );
+	void SetUpFastMarching( GW_I32 nStartVert=-1 );
+	GW_Bool PerformFastMarchingOneStep();
+	void PerformFastMarchingFlush();
+	GW_Bool IsFastMarchingFinished();
+	//@}
+
+	GW_Float GetDistance( GW_U32 nVert ) const;
+	GW_GeodesicVertex::T_GeodesicVertexState GetState( GW_U32 nVert ) const;
+	GW_I32 GetFront( GW_U32 nVert ) const;
+
+	void SetUseUnfolding( GW_Bool bUseUnfolding );
+	GW_Bool GetUseUnfolding( );
+
+    //-------------------------------------------------------------------------
+    /** \name Sharing of the geometry and adjacency. */
+    //-------------------------------------------------------------------------
+	//@{
+	/** the part of the mesh that does not change when marching */
+	struct T_Connectivity
+	{
+		/** 3 coordinates per vertex */
+		std::vector<GW_Float> Positions;
+		/** 3 vertices per face */
+		std::vector<int> Faces;
+		/** 3 neighbors per face, the i-th one is in front of the i-th vertex, -1 on borders */
+		std::vector<int> FaceNeighbors;
+		/** the faces around each vertex, from VertexFaceOffsets[i] to VertexFaceOffsets[i+1] */
+		std::vector<int> VertexFaceOffsets;
+		std::vector<int> VertexFaces;
+		/** the vertices around each vertex, from VertexVertexOffsets[i] to VertexVertexOffsets[i+1] */
+		std::vector<int> VertexVertexOffsets;
+		std::vector<int> VertexVertices;
+
+		size_t GetMemorySize() const;
+	};
+	std::shared_ptr<const T_Connectivity> GetConnectivity() const;
+	void SetConnectivity( const std::shared_ptr<const T_Connectivity>& pConnectivity );
+	//@}
+
+    //-------------------------------------------------------------------------
+    /** \name Conversion to an object mesh. */
+    //-------------------------------------------------------------------------
+	//@{
+	void BuildGeodesicMesh( GW_GeodesicMesh& Mesh ) const;
+	void CopyDistanceToGeodesicMesh( GW_GeodesicMesh& Mesh ) const;
+	//@}
+
+    //-------------------------------------------------------------------------
+    /** \name Callback management. */
+    //-------------------------------------------------------------------------
+    //@{
+	typedef GW_Float (*T_WeightCallbackFunction)( GW_U32 nVert, void *calldata );
+	void RegisterWeightCallbackFunction( T_WeightCallbackFunction pFunc );
+	typedef GW_Bool (*T_FastMarchingCallbackFunction)( GW_U32 nVert, void *calldata );
+	void RegisterForceStopCallbackFunction( T_FastMarchingCallbackFunction pFunc );
+	typedef GW_Bool (*T_VertexInsersionCallbackFunction)( GW_U32 nVert, GW_Float rNewDist, void *calldata );
+	void RegisterVertexInsersionCallbackFunction( T_VertexInsersionCallbackFunction pFunc );
+	//@}
+
+	static GW_Float BasicWeightCallback( GW_U32 nVert, void *calldata );
+
+    virtual void SetCallbackData( void *cd ) { CallbackData_ = cd; }
+
+protected:
+
+	/** the marching data of a vertex */
+	struct T_CompactVertex
+	{
+		GW_Float rDistance;
+		/** the start vertex of the front that reached this vertex, -1 if none */
+		int nFront;
+		/** position in the narrow band, -1 if not in it */
+		int nHeapPosition;
+		GW_GeodesicVertex::T_GeodesicVertexState nState;
+	};
+
+	/** the geometry and adjacency, possibly shared with other meshes */
+	std::shared_ptr<T_Connectivity> Connectivity_;
+
+	std::vector<T_CompactVertex> Vertices_;
+	NarrowBandHeap<T_CompactVertex> heap;
+
+	/** a function that specify the metric on the mesh */
+	T_WeightCallbackFunction WeightCallback_;
+	/** the callback function used to test if we should terminate the fast marching or not */
+	T_FastMarchingCallbackFunction ForceStopCallback_;
+	/** a function called to know if we should insert this vertex */
+	T_VertexInsersionCallbackFunction VertexInsersionCallback_;
+
+	/** just to controle interactive mode */
+	GW_Bool bIsMarchingBegin_;
+	GW_Bool bIsMarchingEnd_;
+
+	/** Do we use unfolding to correct problem with non acute angles ? */
+	GW_Bool bUseUnfolding_;
+
+    /* Callback data for the callbacks */
+    void *CallbackData_;
+
+private:
+
+	friend class GW_CompactGeodesicPath;
+
+	int GetNextVertex( int nFace, int nVert ) const;
+	int GetVertex( int nFace, int nVert1, int nVert2 ) const;
+	int GetFaceNeighbor( int nFace, int nVert ) const;
+	int GetEdgeNumber( int nFace, int nVert1, int nVert2 ) const;
+
+	void DetachConnectivity();
+
+	void BuildFaceRing( int nVert, int nFirstFace, int nMaxSize );
+	void BuildVertexRing( int nVert, int nFirstFace, int nMaxSize );
+
+	GW_Float ComputeVertexDistance( int nFace, int nVert, int nVert1, int nVert2, int nFront, GW_Float F );
+	int UnfoldTriangle( int nFace, int nVert, int nVert1, int nVert2, GW_Float& dist, GW_Float& dot1, GW_Float& dot2 ) const;
+
+	void InsertNarrowBand( int nVert, GW_Float rDistance );
+
+};
+
+} // End namespace GW
+
+#ifdef GW_USE_INLINE
+    #include "GW_CompactGeodesicMesh.inl"
+#endif
+
+
+#endif // _GW_COMPACTGEODESICMESH_H_
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
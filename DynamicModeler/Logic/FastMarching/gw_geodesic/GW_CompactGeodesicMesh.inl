@@ -0,0 +1,629 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_CompactGeodesicMesh.inl
+ *  \brief  Inlined methods for \c GW_CompactGeodesicMesh
+ */
+/*------------------------------------------------------------------------------*/
+
+#include "GW_CompactGeodesicMesh.h"
+
+namespace GW {
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetNbrVertex
+/**
+ *  \return [GW_U32] The number of vertex.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_U32 GW_CompactGeodesicMesh::GetNbrVertex() const
+{
+	return (GW_U32) Vertices_.size();
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::SetPosition
+/**
+ *  \param  nVert [GW_U32] The vertex.
+ *  \param  x [GW_Float] x coord.
+ *  \param  y [GW_Float] y coord.
+ *  \param  z [GW_Float] z coord.
+ *
+ *  Set the position of a vertex.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::SetPosition( GW_U32 nVert, GW_Float x, GW_Float y, GW_Float z )
+{
+	GW_ASSERT( nVert<this->GetNbrVertex() );
+	GW_ASSERT( Connectivity_.use_count()==1 );
+	Connectivity_->Positions[3*nVert+0] = x;
+	Connectivity_->Positions[3*nVert+1] = y;
+	Connectivity_->Positions[3*nVert+2] = z;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetPosition
+/**
+ *  \param  nVert [GW_U32] The vertex.
+ *  \return [GW_Vector3D] Its position.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Vector3D GW_CompactGeodesicMesh::GetPosition( GW_U32 nVert ) const
+{
+	const GW_Float* p = &Connectivity_->Positions[3*nVert];
+	return GW_Vector3D( p[0], p[1], p[2] );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetNbrFace
+/**
+ *  \return [GW_U32] The number of faces.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_U32 GW_CompactGeodesicMesh::GetNbrFace() const
+{
+	return (GW_U32) (Connectivity_->Faces.size()/3);
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::SetFace
+/**
+ *  \param  nFace [GW_U32] The face.
+ *  \param  nVert0 [GW_U32] 1st vertex.
+ *  \param  nVert1 [GW_U32] 2nd vertex.
+ *  \param  nVert2 [GW_U32] 3rd vertex.
+ *
+ *  Set the vertices of a face. \c BuildConnectivity must be called
+ *  once all the faces are set.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::SetFace( GW_U32 nFace, GW_U32 nVert0, GW_U32 nVert1, GW_U32 nVert2 )
+{
+	GW_ASSERT( nFace<this->GetNbrFace() );
+	GW_ASSERT( nVert0<this->GetNbrVertex() && nVert1<this->GetNbrVertex() && nVert2<this->GetNbrVertex() );
+	GW_ASSERT( Connectivity_.use_count()==1 );
+	Connectivity_->Faces[3*nFace+0] = (int) nVert0;
+	Connectivity_->Faces[3*nFace+1] = (int) nVert1;
+	Connectivity_->Faces[3*nFace+2] = (int) nVert2;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetFaceVertex
+/**
+ *  \param  nFace [GW_U32] The face.
+ *  \param  nNum [GW_U32] The number of the vertex in the face.
+ *  \return [GW_U32] The vertex.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_U32 GW_CompactGeodesicMesh::GetFaceVertex( GW_U32 nFace, GW_U32 nNum ) const
+{
+	GW_ASSERT( nNum<3 );
+	return (GW_U32) Connectivity_->Faces[3*nFace+nNum];
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetDistance
+/**
+ *  \param  nVert [GW_U32] The vertex.
+ *  \return [GW_Float] Its distance, \c GW_INFINITE if not reached.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Float GW_CompactGeodesicMesh::GetDistance( GW_U32 nVert ) const
+{
+	return Vertices_[nVert].rDistance;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetState
+/**
+ *  \param  nVert [GW_U32] The vertex.
+ *  \return [GW_GeodesicVertex::T_GeodesicVertexState] Its state.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_GeodesicVertex::T_GeodesicVertexState GW_CompactGeodesicMesh::GetState( GW_U32 nVert ) const
+{
+	return Vertices_[nVert].nState;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetFront
+/**
+ *  \param  nVert [GW_U32] The vertex.
+ *  \return [GW_I32] The start vertex of the front that reached it, -1 if none.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_I32 GW_CompactGeodesicMesh::GetFront( GW_U32 nVert ) const
+{
+	return Vertices_[nVert].nFront;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::AddStartVertex
+/**
+ *  \param  nStartVert [GW_U32] The vertex.
+ *
+ *  Add a new vertex as a starting point for the next fire.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::AddStartVertex( GW_U32 nStartVert )
+{
+	T_CompactVertex& Vert = Vertices_[nStartVert];
+	Vert.nFront = (int) nStartVert;
+	Vert.rDistance = 0;
+	Vert.nState = GW_GeodesicVertex::kAlive;
+
+	this->InsertNarrowBand( (int) nStartVert, 0 );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::BasicWeightCallback
+/**
+ *  \param  nVert [GW_U32] Current vertex.
+ *  \return [GW_Float] 1
+ *
+ *  Just the constant function = 1.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Float GW_CompactGeodesicMesh::BasicWeightCallback( GW_U32 nVert, void * )
+{
+	(void)nVert; // unused
+	return 1;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::RegisterWeightCallbackFunction
+/**
+ *  \param  pFunc [T_WeightCallbackFunction] The function.
+ *
+ *  Set the function used to compute the metric at each vertex.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::RegisterWeightCallbackFunction( T_WeightCallbackFunction pFunc )
+{
+	WeightCallback_ = pFunc;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::RegisterForceStopCallbackFunction
+/**
+ *  \param  pFunc [T_FastMarchingCallbackFunction] The function.
+ *
+ *  Set the function used to test if we should end the fast marching or not.
+ *	The function is called with each new dead vertex, and returns GW_True
+ *	if the algorithm should be stopped.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::RegisterForceStopCallbackFunction( T_FastMarchingCallbackFunction pFunc )
+{
+	ForceStopCallback_ = pFunc;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::RegisterVertexInsersionCallbackFunction
+/**
+ *  \param  pFunc [T_VertexInsersionCallbackFunction] New function.
+ *
+ *  Set the function we use when trying to insert a new vertex.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::RegisterVertexInsersionCallbackFunction( T_VertexInsersionCallbackFunction pFunc )
+{
+	VertexInsersionCallback_ = pFunc;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::SetUseUnfolding
+/**
+ *  \param  bUseUnfolding [GW_Bool] Use it or not ?
+ *
+ *  Set wether to use or not the special handling of obtuse angles
+ *  via unfolding.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::SetUseUnfolding( GW_Bool bUseUnfolding )
+{
+	bUseUnfolding_ = bUseUnfolding;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetUseUnfolding
+/**
+ *  \return [GW_Bool] Answer.
+ *
+ *  Does the fast marching computations use unfolding of the obtuse angles ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_CompactGeodesicMesh::GetUseUnfolding()
+{
+	return bUseUnfolding_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetNextVertex
+/**
+ *  \param  nFace [int] The face.
+ *  \param  nVert [int] A vertex of the face.
+ *  \return [int] The vertex after it in the face, -1 if not in the face.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+int GW_CompactGeodesicMesh::GetNextVertex( int nFace, int nVert ) const
+{
+	const int* pFace = &Connectivity_->Faces[3*nFace];
+	for( int i=0; i<3; ++i )
+	{
+		if( pFace[i]==nVert )
+			return pFace[(i+1)%3];
+	}
+	return -1;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetEdgeNumber
+/**
+ *  \param  nFace [int] The face.
+ *  \param  nVert1 [int] vertex 1
+ *  \param  nVert2 [int] vertex 2
+ *  \return [int] The number of the edge, 0 if not found (as \c GW_Face).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+int GW_CompactGeodesicMesh::GetEdgeNumber( int nFace, int nVert1, int nVert2 ) const
+{
+	const int* pFace = &Connectivity_->Faces[3*nFace];
+	for( int i=0; i<3; ++i )
+	{
+		if( pFace[i]==nVert1 )
+		{
+			if( pFace[(i+1)%3]==nVert2 )
+				return (i+2)%3;
+			if( pFace[(i+2)%3]==nVert2 )
+				return (i+1)%3;
+		}
+	}
+	return 0;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetVertex
+/**
+ *  \param  nFace [int] The face.
+ *  \param  nVert1 [int] vertex 1
+ *  \param  nVert2 [int] vertex 2
+ *  \return [int] The 3rd vertex of the face.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+int GW_CompactGeodesicMesh::GetVertex( int nFace, int nVert1, int nVert2 ) const
+{
+	return Connectivity_->Faces[3*nFace+this->GetEdgeNumber( nFace, nVert1, nVert2 )];
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::GetFaceNeighbor
+/**
+ *  \param  nFace [int] The face.
+ *  \param  nVert [int] A vertex of the face.
+ *  \return [int] The neighbor face in front of the vertex, -1 if none.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+int GW_CompactGeodesicMesh::GetFaceNeighbor( int nFace, int nVert ) const
+{
+	const int* pFace = &Connectivity_->Faces[3*nFace];
+	for( int i=0; i<3; ++i )
+	{
+		if( pFace[i]==nVert )
+			return Connectivity_->FaceNeighbors[3*nFace+i];
+	}
+	return -1;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::InsertNarrowBand
+/**
+ *  \param  nVert [int] The new alive vertex.
+ *  \param  rDistance [GW_Float] Its distance.
+ *
+ *  Add a vertex to the narrow band.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicMesh::InsertNarrowBand( int nVert, GW_Float rDistance )
+{
+	T_CompactVertex* pVert = &Vertices_[nVert];
+	if( pVert->nHeapPosition>=0 )		//start vertex added twice
+		heap.decrease( (float) rDistance, pVert );
+	else
+		heap.push( (float) rDistance, pVert );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::PerformFastMarchingOneStep
+/**
+ *  \return [GW_Bool] Is the marching process finished ?
+ *
+ *  Just one update step of the marching algorithm.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_CompactGeodesicMesh::PerformFastMarchingOneStep()
+{
+	if( heap.empty() ) return GW_True;
+	GW_ASSERT( bIsMarchingBegin_ );
+
+	T_CompactVertex* pCurVert = heap.top();	//erase point from the narrow band, since we'll make it alive
+	heap.pop();
+	pCurVert->nState = GW_GeodesicVertex::kDead;
+	const int nCurVert = (int) (pCurVert - &Vertices_[0]);
+	const int nFront = pCurVert->nFront;
+
+	const int* pNeighbor = &Connectivity_->VertexVertices[0] + Connectivity_->VertexVertexOffsets[nCurVert];
+	const int* pNeighborEnd = &Connectivity_->VertexVertices[0] + Connectivity_->VertexVertexOffsets[nCurVert+1];
+	for( ; pNeighbor!=pNeighborEnd; ++pNeighbor )
+	{
+		const int nNewVert = *pNeighbor;
+		T_CompactVertex& NewVert = Vertices_[nNewVert];
+
+		/* compute it's new distance using neighborhood information */
+		GW_Float rNewDistance = GW_INFINITE;
+		const int nFaceBegin = Connectivity_->VertexFaceOffsets[nNewVert];
+		const int nFaceEnd = Connectivity_->VertexFaceOffsets[nNewVert+1];
+		if( nFaceBegin!=nFaceEnd )
+		{
+			GW_Float F = this->WeightCallback_( (GW_U32) nNewVert, CallbackData_ );
+			for( int i=nFaceBegin; i<nFaceEnd; ++i )
+			{
+				int nFace = Connectivity_->VertexFaces[i];
+				int nVert1 = this->GetNextVertex( nFace, nNewVert );
+				int nVert2 = this->GetNextVertex( nFace, nVert1 );
+				if( Vertices_[nVert1].rDistance>Vertices_[nVert2].rDistance )
+				{
+					int nTempVert = nVert1;
+					nVert1 = nVert2;
+					nVert2 = nTempVert;
+				}
+				rNewDistance = GW_MIN( rNewDistance, this->ComputeVertexDistance( nFace, nNewVert, nVert1, nVert2, nFront, F ) );
+			}
+		}
+		switch( NewVert.nState ) {
+		case GW_GeodesicVertex::kFar:
+			/* ask to the callback if we should update this vertex and add it to the path */
+			if( VertexInsersionCallback_==NULL || VertexInsersionCallback_( (GW_U32) nNewVert, rNewDistance, CallbackData_ ) )
+			{
+				NewVert.rDistance = rNewDistance;
+				/* add the vertex to the heap */
+				this->InsertNarrowBand( nNewVert, rNewDistance );
+
+				/* this one can be added to the heap */
+				NewVert.nState = GW_GeodesicVertex::kAlive;
+				NewVert.nFront = nFront;
+			}
+			break;
+		case GW_GeodesicVertex::kAlive:
+			/* just update it's value */
+			if( rNewDistance<=NewVert.rDistance )
+			{
+				GW_Bool bDecrease = rNewDistance<NewVert.rDistance;
+				NewVert.rDistance = rNewDistance;
+				NewVert.nFront = nFront;
+				if( bDecrease )
+					heap.decrease( (float) rNewDistance, &NewVert );		//...move it since its field-value changed
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	/* have we finished ? */
+	bIsMarchingEnd_ = heap.empty();
+	/* the user can force ending of the algorithm */
+	if( ForceStopCallback_!=NULL && bIsMarchingEnd_==GW_False )
+		bIsMarchingEnd_ = ForceStopCallback_( (GW_U32) nCurVert, CallbackData_ );
+
+	return bIsMarchingEnd_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::ComputeVertexDistance
+/**
+ *  \param  nFace [int] The face.
+ *  \param  nVert [int] The vertex to update.
+ *  \param  nVert1 [int] It's 1st neighbor.
+ *  \param  nVert2 [int] 2nd vertex.
+ *  \param  nFront [int] The front that is updating the vertex.
+ *  \param  F [GW_Float] The weight at the vertex.
+ *  \return The value of the distance according to this triangle contribution.
+ *
+ *  Compute the update of a vertex from inside of a triangle, as
+ *  \c GW_GeodesicMesh::ComputeVertexDistance (only dead vertices are used).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Float GW_CompactGeodesicMesh::ComputeVertexDistance( int nFace, int nVert, int nVert1, int nVert2, int nFront, GW_Float F )
+{
+	const T_CompactVertex& Vert1 = Vertices_[nVert1];
+	const T_CompactVertex& Vert2 = Vertices_[nVert2];
+
+	GW_Bool bVert1Usable = Vert1.nState==GW_GeodesicVertex::kDead && Vert1.nFront==nFront;
+	GW_Bool bVert2Usable = Vert2.nState==GW_GeodesicVertex::kDead && Vert2.nFront==nFront;
+	if( !bVert1Usable && !bVert2Usable )
+		return GW_INFINITE;
+
+	/* same operations as GW_Vector3D, without the temporary objects */
+	const GW_Float* p  = &Connectivity_->Positions[3*nVert];
+	const GW_Float* p1 = &Connectivity_->Positions[3*nVert1];
+	const GW_Float* p2 = &Connectivity_->Positions[3*nVert2];
+	GW_Float Edge1[3] = { p1[0]-p[0], p1[1]-p[1], p1[2]-p[2] };
+	GW_Float Edge2[3] = { p2[0]-p[0], p2[1]-p[1], p2[2]-p[2] };
+
+	GW_Float d1 = Vert1.rDistance;
+	GW_Float d2 = Vert2.rDistance;
+
+	if( !bVert1Usable )
+	{
+		/* only one point is a contributor */
+		GW_Float a = sqrt( Edge2[0]*Edge2[0] + Edge2[1]*Edge2[1] + Edge2[2]*Edge2[2] );
+		return d2 + a * F;
+	}
+	GW_Float b = sqrt( Edge1[0]*Edge1[0] + Edge1[1]*Edge1[1] + Edge1[2]*Edge1[2] );
+	if( !bVert2Usable )
+	{
+		/* only one point is a contributor */
+		return d1 + b * F;
+	}
+	GW_Float a = sqrt( Edge2[0]*Edge2[0] + Edge2[1]*Edge2[1] + Edge2[2]*Edge2[2] );
+	if( b!=0 )
+	{
+		GW_Float rInvNorm = 1/b;
+		Edge1[0] *= rInvNorm; Edge1[1] *= rInvNorm; Edge1[2] *= rInvNorm;
+	}
+	if( a!=0 )
+	{
+		GW_Float rInvNorm = 1/a;
+		Edge2[0] *= rInvNorm; Edge2[1] *= rInvNorm; Edge2[2] *= rInvNorm;
+	}
+	GW_Float dot = Edge1[0]*Edge2[0] + Edge1[1]*Edge2[1] + Edge1[2]*Edge2[2];
+
+	/* first special case for obtuse angles */
+	if( dot<0 && bUseUnfolding_ )
+	{
+		GW_Float c, dot1, dot2;
+		int nUnfoldedVert = this->UnfoldTriangle( nFace, nVert, nVert1, nVert2, c, dot1, dot2 );
+		if( nUnfoldedVert>=0 && Vertices_[nUnfoldedVert].nState!=GW_GeodesicVertex::kFar )
+		{
+			GW_Float d3 = Vertices_[nUnfoldedVert].rDistance;
+			/* use the unfolded value */
+			GW_Float t = GW_GeodesicMesh::ComputeUpdate_SethianMethod( d1, d3, c, b, dot1, F );
+			return GW_MIN( t, GW_GeodesicMesh::ComputeUpdate_SethianMethod( d3, d2, a, c, dot2, F ) );
+		}
+	}
+
+	return GW_GeodesicMesh::ComputeUpdate_SethianMethod( d1, d2, a, b, dot, F );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicMesh::UnfoldTriangle
+/**
+ *  \param  nFace [int] Current face.
+ *  \param  nVert [int] Vertex to update.
+ *  \param  nVert1 [int] 1st neighbor.
+ *  \param  nVert2 [int] 2nd neighbor.
+ *  \return [int] The vertex, -1 if none was found.
+ *
+ *  Find a correct vertex to update \c nVert, as
+ *  \c GW_GeodesicMesh::UnfoldTriangle.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+int GW_CompactGeodesicMesh::UnfoldTriangle( int nFace, int nVert, int nVert1, int nVert2,
+											GW_Float& dist, GW_Float& dot1, GW_Float& dot2 ) const
+{
+	GW_Vector3D v  = this->GetPosition( nVert );
+	GW_Vector3D v1 = this->GetPosition( nVert1 );
+	GW_Vector3D v2 = this->GetPosition( nVert2 );
+
+	GW_Vector3D e1 = v1-v;
+	GW_Float rNorm1 = ~e1;
+	e1 /= rNorm1;
+	GW_Vector3D e2 = v2-v;
+	GW_Float rNorm2 = ~e2;
+	e2 /= rNorm2;
+
+	GW_Float dot = e1*e2;
+	GW_ASSERT( dot<0 );
+
+	/* the equation of the lines defining the unfolding region [e.g. line 1 : {x ; <x,eq1>=0} ]*/
+	GW_Vector2D eq1 = GW_Vector2D( dot, sqrt(1-dot*dot) );
+	GW_Vector2D eq2 = GW_Vector2D(1,0);
+
+	/* position of the 2 points on the unfolding plane */
+	GW_Vector2D x1(rNorm1, 0 );
+	GW_Vector2D x2 = eq1*rNorm2;
+
+	/* keep track of the starting point */
+	GW_Vector2D xstart1 = x1;
+	GW_Vector2D xstart2 = x2;
+
+	int nV1 = nVert1;
+	int nV2 = nVert2;
+	int nCurFace = this->GetFaceNeighbor( nFace, nVert );
+
+	GW_U32 nNum = 0;
+	while( nNum<50 && nCurFace>=0 )
+	{
+		int nV = this->GetVertex( nCurFace, nV1, nV2 );
+
+		GW_Vector3D p1 = this->GetPosition( nV1 );
+		e1 = this->GetPosition( nV2 ) - p1;
+		GW_Float rNorm1 = ~e1;
+		e1 /= rNorm1;
+		e2 = this->GetPosition( nV ) - p1;
+		GW_Float rNorm2 = ~e2;
+		e2 /= rNorm2;
+		/* compute the position of the new point x on the unfolding plane (via a rotation of -alpha on (x2-x1)/rNorm1 ) */
+		GW_Vector2D vv = (x2 - x1)*rNorm2/rNorm1;
+		dot = e1*e2;
+		GW_Vector2D x = vv.Rotate( -acos(dot) ) + x1;
+
+		/* compute the intersection points.
+		   We look for x=x1+lambda*(x-x1) or x=x2+lambda*(x-x2) with <x,eqi>=0, so */
+		GW_Float lambda11 = - (x1*eq1) / ( (x-x1)*eq1 );	// left most
+		GW_Float lambda12 = - (x1*eq2) / ( (x-x1)*eq2 );	// right most
+		GW_Float lambda21 = - (x2*eq1) / ( (x-x2)*eq1 );	// left most
+		GW_Float lambda22 = - (x2*eq2) / ( (x-x2)*eq2 );	// right most
+		GW_Bool bIntersect11 = (lambda11>=0) && (lambda11<=1);
+		GW_Bool bIntersect12 = (lambda12>=0) && (lambda12<=1);
+		GW_Bool bIntersect21 = (lambda21>=0) && (lambda21<=1);
+		GW_Bool bIntersect22 = (lambda22>=0) && (lambda22<=1);
+		if( bIntersect11 && bIntersect12 )
+		{
+			/* we should unfold on edge [x x1] */
+			nCurFace = this->GetFaceNeighbor( nCurFace, nV2 );
+			nV2 = nV;
+			x2 = x;
+		}
+		else if( bIntersect21 && bIntersect22 )
+		{
+			/* we should unfold on edge [x x2] */
+			nCurFace = this->GetFaceNeighbor( nCurFace, nV1 );
+			nV1 = nV;
+			x1 = x;
+		}
+		else
+		{
+			/* that's it, we have found the point */
+			dist = ~x;
+			dot1 = x*xstart1 / (dist * ~xstart1);
+			dot2 = x*xstart2 / (dist * ~xstart2);
+			return nV;
+		}
+		nNum++;
+	}
+
+	return -1;
+}
+
+
+} // End namespace GW
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,533 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_CompactGeodesicPath.cpp
+ *  \brief  Definition of class \c GW_CompactGeodesicPath
+ */
+/*------------------------------------------------------------------------------*/
+
+#include "stdafx.h"
+#include "GW_CompactGeodesicPath.h"
+
+#ifndef GW_USE_INLINE
+    #include "GW_CompactGeodesicPath.inl"
+#endif
+
+using namespace GW;
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath constructor
+/**
+ *  Constructor.
+ */
+/*------------------------------------------------------------------------------*/
+GW_CompactGeodesicPath::GW_CompactGeodesicPath()
+:	pMesh_		( NULL ),
+	nCurFace_	( -1 ),
+	nPrevFace_	( -1 ),
+	rStepSize_	( 0.01f )
+{
+	for( int i=0; i<6; ++i )
+		Coeffs_[i] = 0;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath destructor
+/**
+ *  Destructor.
+ */
+/*------------------------------------------------------------------------------*/
+GW_CompactGeodesicPath::~GW_CompactGeodesicPath()
+{
+	/* NOTHING */
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::AddVertexToPath
+/**
+ *  \param  nVert [int] The vertex.
+ *
+ *  Helper method : add a vertex to path and compute next face, going
+ *  around the vertex as \c GW_VertexIterator. The path ends (the current
+ *  face is -1) if no neighbor was reached by the marching.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicPath::AddVertexToPath( int nVert )
+{
+	const GW_CompactGeodesicMesh::T_Connectivity& Connectivity = *pMesh_->Connectivity_;
+	nPrevFace_ = nCurFace_;
+	nCurFace_ = -1;
+	GW_Float rBestDistance = GW_INFINITE;
+	int nSelectedVert = -1;
+	const int nRingSize = Connectivity.VertexVertexOffsets[nVert+1]-Connectivity.VertexVertexOffsets[nVert];
+	const int nFirstFace = nRingSize>0 ? Connectivity.VertexFaces[Connectivity.VertexFaceOffsets[nVert]] : -1;
+	int nFace = nFirstFace;
+	int nDirection = nRingSize>0 ? pMesh_->GetNextVertex( nFirstFace, nVert ) : -1;
+	int nPrevFace = -1;
+	for( int nNum=0; nNum<nRingSize; ++nNum )
+	{
+		if( this->GetDistance( nDirection )<rBestDistance )
+		{
+			rBestDistance = this->GetDistance( nDirection );
+			nSelectedVert = nDirection;
+			/* left and right face and vertex of the edge, as GW_VertexIterator */
+			int nLeftFace = nPrevFace;
+			if( nLeftFace<0 && nFace>=0 )
+				nLeftFace = this->GetNeighborOfEdge( nFace, nDirection, nVert );
+			int nVert1 = nLeftFace>=0 ? pMesh_->GetVertex( nLeftFace, nDirection, nVert ) : -1;
+			int nVert2 = nFace>=0 ? pMesh_->GetVertex( nFace, nDirection, nVert ) : -1;
+			if( nVert1>=0 && nVert2>=0 )
+			{
+				if( this->GetDistance( nVert1 )<this->GetDistance( nVert2 ) )
+					nCurFace_ = nLeftFace;
+				else
+					nCurFace_ = nFace;
+			}
+			else if( nVert1>=0 )
+			{
+				nCurFace_ = nLeftFace;
+			}
+			else
+			{
+				nCurFace_ = nFace;
+			}
+		}
+		/* next vertex, as GW_VertexIterator::operator++ */
+		if( nFace<0 )
+		{
+			/* we are on a border face : Rewind on the first face */
+			for( int nIter=0; nPrevFace>=0 && nIter<nRingSize; ++nIter )
+			{
+				nFace = nPrevFace;
+				nPrevFace = pMesh_->GetFaceNeighbor( nPrevFace, nDirection );
+				nDirection = pMesh_->GetVertex( nFace, nVert, nDirection );
+			}
+			if( nFace==nFirstFace )
+				break;
+		}
+		else
+		{
+			int nNextFace = pMesh_->GetFaceNeighbor( nFace, nDirection );
+			if( nNextFace==nFirstFace )
+				break;
+			nDirection = pMesh_->GetVertex( nFace, nVert, nDirection );
+			nPrevFace = nFace;
+			nFace = nNextFace;
+		}
+	}
+	if( nSelectedVert<0 || nCurFace_<0 )
+	{
+		nCurFace_ = -1;
+		return;
+	}
+
+	T_PathPoint Point;
+	Point.nVert1 = nVert;
+	Point.nVert2 = nSelectedVert;
+	Point.rCoord = 1;
+	Point.nFace = nCurFace_;
+	Path_.push_back( Point );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::SelectClosestVertex
+/**
+ *  \return [int] The vertex of the three that is closest to the start vertices.
+ */
+/*------------------------------------------------------------------------------*/
+int GW_CompactGeodesicPath::SelectClosestVertex( int nVert1, int nVert2, int nVert3 ) const
+{
+	int nSelectedVert = nVert1;
+	if( this->GetDistance( nVert2 )<this->GetDistance( nSelectedVert ) )
+		nSelectedVert = nVert2;
+	if( this->GetDistance( nVert3 )<this->GetDistance( nSelectedVert ) )
+		nSelectedVert = nVert3;
+	return nSelectedVert;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::AddVertexAndCheckEnd
+/**
+ *  \param  nLastPoint [size_t] The point the step started from.
+ *  \return [GW_I32] -1 if the path is ended.
+ *
+ *  Special case : follow the edge to the closest vertex of the face.
+ */
+/*------------------------------------------------------------------------------*/
+GW_I32 GW_CompactGeodesicPath::AddVertexAndCheckEnd( int nVert1, int nVert2, int nVert3, size_t nLastPoint )
+{
+	int nSelectedVert = this->SelectClosestVertex( nVert1, nVert2, nVert3 );
+	this->AddVertexToPath( nSelectedVert );
+	if( nCurFace_<0 )
+		return -1;
+	if( this->GetDistance( nSelectedVert )<GW_EPSILON )
+		return -1;
+	if( nCurFace_==nPrevFace_ && Path_[nLastPoint].rCoord>1-GW_EPSILON )
+	{
+		/* hum, problem, we are in a local minimum */
+		return -1;
+	}
+	return 0;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::AddEdgePoint
+/**
+ *  \param  a [GW_Float] Coordinate of the crossing with respect to nVert1.
+ *  \return [GW_I32] -1 if the path is ended.
+ *
+ *  The path crosses the edge [nVert1,nVert2] of the current face : add
+ *  the point and go to the face on the other side.
+ */
+/*------------------------------------------------------------------------------*/
+GW_I32 GW_CompactGeodesicPath::AddEdgePoint( int nVert1, int nVert2, GW_Float a )
+{
+	T_PathPoint Point;
+	Point.nVert1 = nVert1;
+	Point.nVert2 = nVert2;
+	Point.rCoord = a;
+	nPrevFace_ = nCurFace_;
+	int nNextFace = this->GetNeighborOfEdge( nCurFace_, nVert1, nVert2 );
+	if( nNextFace<0 )
+	{
+		/* border of the mesh : we should stay on the same face, the fact that
+		   nPrevFace_==nCurFace_ will force to go on an edge */
+		Point.nFace = nCurFace_;
+		Path_.push_back( Point );
+		return 0;
+	}
+	nCurFace_ = nNextFace;
+	Point.nFace = nCurFace_;
+	Path_.push_back( Point );
+	/* test for ending */
+	if( a<0.01 && this->GetDistance( nVert1 )<GW_EPSILON )
+		return -1;
+	if( a>0.99 && this->GetDistance( nVert2 )<GW_EPSILON )
+		return -1;
+	return 0;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::InitPath
+/**
+ *  \param  Mesh [GW_CompactGeodesicMesh&] The marched mesh.
+ *  \param  nStartVert [GW_U32] Starting point of the path.
+ *
+ *  Compute the first face to begin the search.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicPath::InitPath( const GW_CompactGeodesicMesh& Mesh, GW_U32 nStartVert )
+{
+	this->ResetPath();
+	pMesh_ = &Mesh;
+	if( nStartVert<Mesh.GetNbrVertex() )
+		this->AddVertexToPath( (int) nStartVert );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::AddNewPoint
+/**
+ *  \return [GW_I32] !=0 if the path is ended.
+ *
+ *  Compute a new point and add it to the path, as
+ *  \c GW_GeodesicPath::AddNewPoint.
+ */
+/*------------------------------------------------------------------------------*/
+GW_I32 GW_CompactGeodesicPath::AddNewPoint()
+{
+	if( nCurFace_<0 || Path_.empty() )
+		return -1;
+	const size_t nLastPoint = Path_.size()-1;
+	const int nVert1 = Path_[nLastPoint].nVert1;
+	const int nVert2 = Path_[nLastPoint].nVert2;
+	const int nVert3 = pMesh_->GetVertex( nCurFace_, nVert1, nVert2 );
+
+	/* barycentric coords of the point, we begin on an edge */
+	GW_Float x,y,z;
+	x = Path_[nLastPoint].rCoord;
+	y = 1-x;
+	z = 0;
+
+	GW_Float l1 = ~( pMesh_->GetPosition( nVert1 ) - pMesh_->GetPosition( nVert3 ) );
+	GW_Float l2 = ~( pMesh_->GetPosition( nVert2 ) - pMesh_->GetPosition( nVert3 ) );
+
+	this->SetUpTriangularInterpolation( nCurFace_ );
+
+	GW_U32 nNum = 0;
+	while( nNum<1000 )	// never stop, this is just to avoid infinite loop
+	{
+		nNum++;
+		GW_Float dx, dy;
+
+		this->ComputeGradient( nVert1, nVert2, nVert3, x, y, dx, dy );
+
+		GW_Float l, a;
+		/* Try each kind of possible crossing.
+		   The barycentric coords of the point is (x-l*dx/l1,y-l*dy/l2,z+l*(dx/l1+dy/l2)) */
+		if( GW_ABS(dx)>GW_EPSILON )
+		{
+			l = l1*x/dx;		// position along the line
+			a = y-l*dy/l2;		// coordonate with respect to v2
+			if( l>0 && l<=rStepSize_ && 0<=a && a<=1 )
+			{
+				/* the crossing occurs on [v2,v3] */
+				return this->AddEdgePoint( nVert2, nVert3, a );
+			}
+		}
+		if( GW_ABS(dy)>GW_EPSILON )
+		{
+			l = l2*y/dy;	  // position along the line
+			a = x-l*dx/l1;	  // coordonate with respect to v1
+			if( l>0 && l<=rStepSize_ && 0<=a && a<=1 )
+			{
+				/* the crossing occurs on [v1,v3] */
+				return this->AddEdgePoint( nVert1, nVert3, a );
+			}
+		}
+		if( GW_ABS(dx/l1+dy/l2)>GW_EPSILON )
+		{
+			l = -z/(dx/l1+dy/l2);	  // position along the line
+			a = x-l*dx/l1;	  // coordonate with respect to v1
+			if( l>0 && l<=rStepSize_ && 0<=a && a<=1 )
+			{
+				/* the crossing occurs on [v1,v2] */
+				return this->AddEdgePoint( nVert1, nVert2, a );
+			}
+		}
+
+		if( GW_ABS(dx)<GW_EPSILON )
+		{
+			/* special case : we must follow the edge. */
+			return this->AddVertexAndCheckEnd( nVert1, nVert2, nVert3, nLastPoint );
+		}
+
+		/* no intersection: we can advance */
+		GW_Float xprev = x;
+		x = x - rStepSize_*dx/l1;
+		y = y - rStepSize_*dy/l2;
+
+		if( x<0 || x>1 || y<0 || y>1 )
+		{
+			int nNextFace = pMesh_->GetFaceNeighbor( nCurFace_, nVert3 );
+			if( nNextFace==nPrevFace_ || nNextFace<0 )
+			{
+				/* special case : we must follow the edge. */
+				return this->AddVertexAndCheckEnd( nVert1, nVert2, nVert3, nLastPoint );
+			}
+			/* we should go on another face */
+			nPrevFace_ = nCurFace_;
+			nCurFace_ = nNextFace;
+			T_PathPoint Point;
+			Point.nVert1 = nVert1;
+			Point.nVert2 = nVert2;
+			Point.rCoord = xprev;
+			Point.nFace = nCurFace_;
+			Path_.push_back( Point );
+			return 0;
+		}
+	}
+	return this->AddVertexAndCheckEnd( nVert1, nVert2, nVert3, nLastPoint );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::ComputePath
+/**
+ *  \param  Mesh [GW_CompactGeodesicMesh&] The marched mesh.
+ *  \param  nStartVert [GW_U32] The starting point.
+ *  \param  nMaxLength [GW_U32] Maximum number of steps.
+ *
+ *  Compute the whole path, descending the distance of the mesh to the
+ *  start vertices of the marching.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicPath::ComputePath( const GW_CompactGeodesicMesh& Mesh, GW_U32 nStartVert, GW_U32 nMaxLength )
+{
+	this->InitPath( Mesh, nStartVert );
+	GW_U32 nNum = 0;
+	while( this->AddNewPoint()==0 && nNum<nMaxLength )
+	{ nNum++; }
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::ResetPath
+/**
+ *  Clear everything in the path.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicPath::ResetPath()
+{
+	Path_.clear();
+	nCurFace_ = -1;
+	nPrevFace_ = -1;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::SetUpTriangularInterpolation
+/**
+ *  \param  nFace [int] The face.
+ *
+ *  Compute the coefficients of the quadratic interpolation of the
+ *  distance on a face, fitted to its vertices and the opposite vertices
+ *  of its neighbors, as \c GW_TriangularInterpolation_Quadratic.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicPath::SetUpTriangularInterpolation( int nFace )
+{
+	const GW_CompactGeodesicMesh::T_Connectivity& Connectivity = *pMesh_->Connectivity_;
+
+	/* retrieve vertex and length */
+	int nV0 = Connectivity.Faces[3*nFace];
+	int nV1 = Connectivity.Faces[3*nFace+1];
+	int nV2 = Connectivity.Faces[3*nFace+2];
+
+	int nFace0 = Connectivity.FaceNeighbors[3*nFace];
+	int nFace1 = Connectivity.FaceNeighbors[3*nFace+1];
+	int nFace2 = Connectivity.FaceNeighbors[3*nFace+2];
+	int nW0 = nFace0>=0 ? pMesh_->GetVertex( nFace0, nV1, nV2 ) : -1;
+	int nW1 = nFace1>=0 ? pMesh_->GetVertex( nFace1, nV0, nV2 ) : -1;
+	int nW2 = nFace2>=0 ? pMesh_->GetVertex( nFace2, nV0, nV1 ) : -1;
+
+	GW_Vector3D V0 = pMesh_->GetPosition( nV0 );
+	GW_Vector3D V1 = pMesh_->GetPosition( nV1 );
+	GW_Vector3D V2 = pMesh_->GetPosition( nV2 );
+	GW_Vector3D W0, W1, W2;
+
+	if( nW0>=0 )
+		W0 = pMesh_->GetPosition( nW0 );
+	else
+		W0 = (V1+V2)*0.5;
+	if( nW1>=0 )
+		W1 = pMesh_->GetPosition( nW1 );
+	else
+		W1 = (V0+V1)*0.5;
+	if( nW2>=0 )
+		W2 = pMesh_->GetPosition( nW2 );
+	else
+		W2 = (V0+V1)*0.5;
+
+	/* edge of the main triangle */
+	GW_Vector3D e0 = V0-V2;
+	GW_Vector3D e1 = V1-V2;
+	GW_Vector3D e2 = V1-V0;
+	/* edge of side triangles */
+	GW_Vector3D s0 = W0 - V2;
+	GW_Vector3D s1 = W1 - V2;
+	GW_Vector3D s2 = W2 - V0;
+
+	GW_Float l0 = ~e0;
+	GW_Float l1 = ~e1;
+	GW_Float l2 = ~e2;
+	GW_Float m0 = ~s0;
+	GW_Float m1 = ~s1;
+	GW_Float m2 = ~s2;
+
+	/* compute the orthonormal basis in which the interpolation is performed */
+	u_ = e0/l0;
+	v_ = ( (u_^e1)^u_ );
+	v_.Normalize();
+	w_ = V2;	// origin
+
+	/* now compute angles */
+	GW_Float a = acos( (e0*e1)/(l0*l1) );
+	GW_Float b = acos( (e1*s0)/(l1*m0) );
+	GW_Float c = acos( (e0*s1)/(l0*m1) );
+	GW_Float d = acos(-(e0*e2)/(l0*l2) );
+	GW_Float e = acos( (e2*s2)/(l2*m2) );
+
+	/* compute 2D position of points.
+	Point 0,1,2 are V0,V1,V2    Points 3,4,5 are W0,W1,W2 */
+	GW_Float Points[6][2];
+
+	Points[0][0] = l0;
+	Points[0][1] = 0;
+
+	Points[1][0] = l1*cos(a);
+	Points[1][1] = l1*sin(a);
+
+	Points[2][0] = 0;
+	Points[2][1] = 0;
+
+	Points[3][0] =  m0*cos(a+b);
+	Points[3][1] =  m0*sin(a+b);
+
+	Points[4][0] =  m1*cos(c);
+	Points[4][1] = -m1*sin(c);
+
+	Points[5][0] =  l0 - m2*cos(d+e);
+	Points[5][1] =  m2*sin(d+e);
+
+	/* compute values */
+	GW_Float Values[6];
+	Values[0] = this->GetDistance( nV0 );
+	Values[1] = this->GetDistance( nV1 );
+	Values[2] = this->GetDistance( nV2 );
+
+	if( nW0>=0 )
+		Values[3] = this->GetDistance( nW0 );
+	else
+		Values[3] = (Values[1]+Values[2])*0.5;
+
+	if( nW1>=0 )
+		Values[4] = this->GetDistance( nW1 );
+	else
+		Values[4] = (Values[0]+Values[2])*0.5;
+
+	if( nW2>=0 )
+		Values[5] = this->GetDistance( nW2 );
+	else
+		Values[5] = (Values[0]+Values[1])*0.5;
+
+	/* compute the coefficients, given in that order : 0->cst, 1->X, 2->Y, 3->XY, 4->X^2, 5->Y^2. */
+	GW_Maths::Fit2ndOrderPolynomial2D( Points, Values, Coeffs_ );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::ComputeGradient
+/**
+ *  \param  nVert0 [int] 1st vertex of local frame.
+ *  \param  nVert1 [int] 2nd vertex.
+ *  \param  nVert2 [int] 3rd vertex.
+ *  \param  x [GW_Float] x local coord.
+ *  \param  y [GW_Float] y local coord.
+ *  \param  dx [GW_Float&] x coord of the gradient in local coord.
+ *  \param  dy [GW_Float&] y coord of the gradient in local coord.
+ *
+ *  Compute the gradient of the interpolated distance at given point in
+ *  local frame, as \c GW_TriangularInterpolation_Quadratic::ComputeGradient.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_CompactGeodesicPath::ComputeGradient( int nVert0, int nVert1, int nVert2, GW_Float x, GW_Float y, GW_Float& dx, GW_Float& dy ) const
+{
+	/* compute local basis */
+	GW_Vector3D e = pMesh_->GetPosition( nVert2 );			// origin
+	GW_Vector3D e0 = pMesh_->GetPosition( nVert0 ) - e;
+	GW_Vector3D e1 = pMesh_->GetPosition( nVert1 ) - e;
+
+	/* compute (s,t) the parameter of the point M in basis (w;u,v) */
+	GW_Vector3D trans = e-w_;
+	/* compute passage matrix */
+	GW_Float p00 = e0*u_;
+	GW_Float p01 = e1*u_;
+	GW_Float p10 = e0*v_;
+	GW_Float p11 = e1*v_;
+	GW_Float s = x*p00 + y*p01 + (trans*u_);
+	GW_Float t = x*p10 + y*p11 + (trans*v_);
+
+	/* now we can compute the gradient in orthogonal basis (w;u,v) */
+	GW_Float gu = Coeffs_[1] + Coeffs_[3]*t + Coeffs_[4]*2*s;
+	GW_Float gv = Coeffs_[2] + Coeffs_[3]*s + Coeffs_[5]*2*t;
+
+	/* convert from orthogonal basis to local basis */
+	GW_Float rDet = p00*p11 - p01*p10;
+	if( GW_ABS(rDet)>GW_EPSILON )
+	{
+		dx = 1/rDet * ( p11*gu - p01*gv ) * ~e0;
+		dy = 1/rDet * (-p10*gu + p00*gv ) * ~e1;
+	}
+	else
+		dx = dy = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
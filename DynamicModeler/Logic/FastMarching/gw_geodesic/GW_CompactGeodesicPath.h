@@ -0,0 +1,106 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_CompactGeodesicPath.h
+ *  \brief  Definition of class \c GW_CompactGeodesicPath
+ */
+/*------------------------------------------------------------------------------*/
+
+#ifndef _GW_COMPACTGEODESICPATH_H_
+#define _GW_COMPACTGEODESICPATH_H_
+
+#include "../gw_core/GW_Config.h"
+#include "GW_CompactGeodesicMesh.h"
+
+namespace GW {
+
+/*------------------------------------------------------------------------------*/
+/**
+ *  \class  GW_CompactGeodesicPath
+ *  \brief  A geodesic path traced on a \c GW_CompactGeodesicMesh.
+ *
+ *  Same gradient descent as \c GW_GeodesicPath with the quadratic
+ *  interpolation of \c GW_TriangularInterpolation_Quadratic, but on the
+ *  indices of a compact mesh, so the mesh (and its adjacency shared with
+ *  other meshes) is used as it is, without building an object mesh. The
+ *  points are the same as those of \c GW_GeodesicPath on the object mesh
+ *  made by \c GW_CompactGeodesicMesh::BuildGeodesicMesh. The points inside
+ *  the faces (sub-points) are not kept.
+ */
+/*------------------------------------------------------------------------------*/
+
+class GW_CompactGeodesicPath
+{
+
+public:
+
+	/** a point of the path, on the edge [nVert1,nVert2] at rCoord*nVert1+(1-rCoord)*nVert2 */
+	struct T_PathPoint
+	{
+		int nVert1;
+		int nVert2;
+		GW_Float rCoord;
+		/** the face the path continues in */
+		int nFace;
+	};
+	typedef std::vector<T_PathPoint> T_PathPointVector;
+
+    /*------------------------------------------------------------------------------*/
+    /** \name Constructor and destructor */
+    /*------------------------------------------------------------------------------*/
+    //@{
+    GW_CompactGeodesicPath();
+    virtual ~GW_CompactGeodesicPath();
+    //@}
+
+	const T_PathPointVector& GetPointList() const;
+
+	void InitPath( const GW_CompactGeodesicMesh& Mesh, GW_U32 nStartVert );
+	GW_I32 AddNewPoint();
+	void ComputePath( const GW_CompactGeodesicMesh& Mesh, GW_U32 nStartVert, GW_U32 nMaxLength = GW_INFINITE );
+	void ResetPath();
+
+	void SetStepSize( GW_Float rStepSize );
+	GW_Float GetStepSize();
+
+private:
+
+	void AddVertexToPath( int nVert );
+	int SelectClosestVertex( int nVert1, int nVert2, int nVert3 ) const;
+	GW_I32 AddVertexAndCheckEnd( int nVert1, int nVert2, int nVert3, size_t nLastPoint );
+	GW_I32 AddEdgePoint( int nVert1, int nVert2, GW_Float a );
+
+	void SetUpTriangularInterpolation( int nFace );
+	void ComputeGradient( int nVert0, int nVert1, int nVert2, GW_Float x, GW_Float y, GW_Float& dx, GW_Float& dy ) const;
+
+	GW_Float GetDistance( int nVert ) const;
+	int GetNeighborOfEdge( int nFace, int nVert1, int nVert2 ) const;
+
+	T_PathPointVector Path_;
+
+	const GW_CompactGeodesicMesh* pMesh_;
+
+	int nCurFace_;
+	int nPrevFace_;
+
+	GW_Float rStepSize_;
+
+	/** quadratic interpolation of the distance on the current face, see \c GW_TriangularInterpolation_Quadratic */
+	GW_Float Coeffs_[6];
+	GW_Vector3D u_, v_;		// orthogonal basis axis
+	GW_Vector3D w_;			// orthogonal coord system origin
+
+};
+
+} // End namespace GW
+
+#ifdef GW_USE_INLINE
+    #include "GW_CompactGeodesicPath.inl"
+#endif
+
+
+#endif // _GW_COMPACTGEODESICPATH_H_
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,82 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_CompactGeodesicPath.inl
+ *  \brief  Inlined methods for \c GW_CompactGeodesicPath
+ */
+/*------------------------------------------------------------------------------*/
+
+#include "GW_CompactGeodesicPath.h"
+
+namespace GW {
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::GetPointList
+/**
+ *  \return [T_PathPointVector&] The points of the path.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+const GW_CompactGeodesicPath::T_PathPointVector& GW_CompactGeodesicPath::GetPointList() const
+{
+	return Path_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::SetStepSize
+/**
+ *  \param  rStepSize [GW_Float] The new size, in barycentric coords.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_CompactGeodesicPath::SetStepSize( GW_Float rStepSize )
+{
+	rStepSize_ = rStepSize;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::GetStepSize
+/**
+ *  \return [GW_Float] The size of the steps.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Float GW_CompactGeodesicPath::GetStepSize()
+{
+	return rStepSize_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::GetDistance
+/**
+ *  \param  nVert [int] The vertex.
+ *  \return [GW_Float] Its distance from the start vertices.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Float GW_CompactGeodesicPath::GetDistance( int nVert ) const
+{
+	return pMesh_->GetDistance( (GW_U32) nVert );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_CompactGeodesicPath::GetNeighborOfEdge
+/**
+ *  \param  nFace [int] The face.
+ *  \param  nVert1 [int] vertex 1
+ *  \param  nVert2 [int] vertex 2
+ *  \return [int] The face on the other side of the edge, -1 if none (as \c GW_Face::GetFaceNeighbor).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+int GW_CompactGeodesicPath::GetNeighborOfEdge( int nFace, int nVert1, int nVert2 ) const
+{
+	return pMesh_->Connectivity_->FaceNeighbors[3*nFace+pMesh_->GetEdgeNumber( nFace, nVert1, nVert2 )];
+}
+
+
+} // End namespace GW
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -18,6 +18,7 @@ void GW_GeodesicMesh::ResetGeodesicMesh()
 		pVert->ResetGeodesicVertex();
 	}
 	map.clear();
+	heap.clear();
 }
 
 /*------------------------------------------------------------------------------*/
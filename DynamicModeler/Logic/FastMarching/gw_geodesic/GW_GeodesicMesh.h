@@ -37,6 +37,7 @@ namespace GW {
 class GW_GeodesicMesh: public GW_Mesh
 {
 NarrowBand			map;					//Narrowband points sorted in ascending distance order
+NarrowBandHeap<GW_GeodesicVertex> heap;		//Same, used instead of map if bUseHeapNarrowBand_
 
 public:
 
@@ -75,6 +76,9 @@ public:
 	void SetUseUnfolding( GW_Bool bUseUnfolding );
 	GW_Bool GetUseUnfolding( );
 
+	void SetUseHeapNarrowBand( GW_Bool bUseHeapNarrowBand );
+	GW_Bool GetUseHeapNarrowBand( );
+
     //-------------------------------------------------------------------------
     /** \name Callback management. */
     //-------------------------------------------------------------------------
@@ -121,11 +125,17 @@ protected:
 	GW_Bool bIsMarchingBegin_;
 	GW_Bool bIsMarchingEnd_;
 
+	/** Do we store the narrow band in a heap (or in a multimap) ? */
+	GW_Bool bUseHeapNarrowBand_;
+
     /* Callback data for the callbacks */
     void *CallbackData_;
 
 private:
 
+	/** shares the update computations */
+	friend class GW_CompactGeodesicMesh;
+
 	GW_Float ComputeVertexDistance( GW_GeodesicFace& CurrentFace, GW_GeodesicVertex& CurrentVertex, 
 									GW_GeodesicVertex& Vert1, GW_GeodesicVertex& Vert2, GW_GeodesicVertex& CurrentFront );
 
@@ -134,6 +144,11 @@ private:
 	static GW_Float ComputeUpdate_SethianMethod( GW_Float d1, GW_Float d2, GW_Float a, GW_Float b, GW_Float dot, GW_Float F );
 	static GW_Float ComputeUpdate_MatrixMethod( GW_Float d1, GW_Float d2, GW_Float a, GW_Float b, GW_Float dot, GW_Float F );
 
+	GW_Bool IsNarrowBandEmpty();
+	GW_GeodesicVertex* PopNarrowBand();
+	void InsertNarrowBand( GW_GeodesicVertex& Vert, GW_Float rDistance );
+	void DecreaseNarrowBand( GW_GeodesicVertex& Vert, GW_Float rDistance );
+
 	/** Do we use unfolding to correct problem with non acute angles ? */
 	static GW_Bool bUseUnfolding_;
 
@@ -30,6 +30,7 @@ GW_GeodesicMesh::GW_GeodesicMesh()
 	HeuristicToGoalCallbackFunction_	( NULL ),
 	bIsMarchingBegin_			( GW_False ),
 	bIsMarchingEnd_				( GW_False ),
+	bUseHeapNarrowBand_			( GW_True ),
     CallbackData_ (NULL)
 {
 	/* NOTHING */
@@ -101,8 +102,7 @@ void GW_GeodesicMesh::AddStartVertex( GW_GeodesicVertex& StartVert )
 	StartVert.SetDistance(0);
 	StartVert.SetState( GW_GeodesicVertex::kAlive );
 	
-	NarrowBand::value_type v(0.0f,&StartVert);
-	StartVert.ptr = map.insert(v);
+	this->InsertNarrowBand( StartVert, 0 );
 }
 
 /*------------------------------------------------------------------------------*/
@@ -189,12 +189,10 @@ void GW_GeodesicMesh::RegisterHeuristicToGoalCallbackFunction( T_HeuristicToGoal
 GW_INLINE
 GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 {
-	if (map.empty()) return GW_True;
+	if (this->IsNarrowBandEmpty()) return GW_True;
 	GW_ASSERT( bIsMarchingBegin_ );
 	
-	NarrowBand::iterator it=map.begin();
-	GW_GeodesicVertex* pCurVert = it->second;
-    map.erase(it);					//erase point from 'map', since we'll make it alive
+	GW_GeodesicVertex* pCurVert = this->PopNarrowBand();	//erase point from the narrow band, since we'll make it alive
 	pCurVert->SetState( GW_GeodesicVertex::kDead );
 
 	if( NewDeadVertexCallback_!=NULL ) NewDeadVertexCallback_( *pCurVert );
@@ -234,8 +232,7 @@ GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 				{
 					pNewVert->SetDistance( rNewDistance );
 					/* add the vertex to the heap */
-					NarrowBand::value_type v(rNewDistance,pNewVert);
-					pNewVert->ptr = map.insert(v);
+					this->InsertNarrowBand( *pNewVert, rNewDistance );
 
 					/* this one can be added to the heap */
 					pNewVert->SetState( GW_GeodesicVertex::kAlive );
@@ -255,9 +252,7 @@ GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 										
 					if (diff)		
 					{
-					  map.erase(pNewVert->ptr);
-					  NarrowBand::value_type v(rNewDistance,pNewVert);
-					  pNewVert->ptr = map.insert(v);		//...and insert it back since its field-value changed		
+					  this->DecreaseNarrowBand( *pNewVert, rNewDistance );		//...move it since its field-value changed
 					}
 				}
 				else
@@ -279,7 +274,7 @@ GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 	}
 	
 	/* have we finished ? */
-	bIsMarchingEnd_ = map.empty(); 
+	bIsMarchingEnd_ = this->IsNarrowBandEmpty(); 
 	/* the user can force ending of the algorithm */
 	if( ForceStopCallback_!=NULL && bIsMarchingEnd_==GW_False )
 		bIsMarchingEnd_ = ForceStopCallback_(*pCurVert, CallbackData_);
@@ -719,6 +714,127 @@ GW_Bool GW_GeodesicMesh::GetUseUnfolding()
 	return bUseUnfolding_;
 }
 
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::SetUseHeapNarrowBand
+/**
+ *  \param  bUseHeapNarrowBand [GW_Bool] Use it or not ?
+ * 
+ *  Set wether the narrow band is stored in an array based heap (default),
+ *  which updates distances in place, or in a multimap. Both give the same
+ *  result. Must not be changed while marching.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::SetUseHeapNarrowBand( GW_Bool bUseHeapNarrowBand )
+{
+	GW_ASSERT( map.empty() && heap.empty() );
+	bUseHeapNarrowBand_ = bUseHeapNarrowBand;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::GetUseHeapNarrowBand
+/**
+ *  \return [GW_Bool] Answer.
+ * 
+ *  Is the narrow band stored in a heap (or in a multimap) ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_GeodesicMesh::GetUseHeapNarrowBand()
+{
+	return bUseHeapNarrowBand_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::IsNarrowBandEmpty
+/**
+ *  \return [GW_Bool] Answer.
+ * 
+ *  Are there no more alive vertices ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_GeodesicMesh::IsNarrowBandEmpty()
+{
+	return bUseHeapNarrowBand_ ? heap.empty() : map.empty();
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::PopNarrowBand
+/**
+ *  \return [GW_GeodesicVertex*] The alive vertex with the smallest distance.
+ * 
+ *  Remove the vertex with the smallest distance from the narrow band.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_GeodesicVertex* GW_GeodesicMesh::PopNarrowBand()
+{
+	GW_GeodesicVertex* pVert;
+	if( bUseHeapNarrowBand_ )
+	{
+		pVert = heap.top();
+		heap.pop();
+	}
+	else
+	{
+		NarrowBand::iterator it = map.begin();
+		pVert = it->second;
+		map.erase(it);
+	}
+	return pVert;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::InsertNarrowBand
+/**
+ *  \param  Vert [GW_GeodesicVertex&] The new alive vertex.
+ *  \param  rDistance [GW_Float] Its distance.
+ * 
+ *  Add a vertex to the narrow band.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::InsertNarrowBand( GW_GeodesicVertex& Vert, GW_Float rDistance )
+{
+	if( bUseHeapNarrowBand_ )
+	{
+		if( Vert.nHeapPosition>=0 )		//start vertex added twice
+			heap.decrease( (float) rDistance, &Vert );
+		else
+			heap.push( (float) rDistance, &Vert );
+	}
+	else
+	{
+		NarrowBand::value_type v( (float) rDistance, &Vert );
+		Vert.ptr = map.insert(v);
+	}
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::DecreaseNarrowBand
+/**
+ *  \param  Vert [GW_GeodesicVertex&] A vertex of the narrow band.
+ *  \param  rDistance [GW_Float] Its new, smaller distance.
+ * 
+ *  Update the position of a vertex in the narrow band.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::DecreaseNarrowBand( GW_GeodesicVertex& Vert, GW_Float rDistance )
+{
+	if( bUseHeapNarrowBand_ )
+	{
+		heap.decrease( (float) rDistance, &Vert );
+	}
+	else
+	{
+		map.erase(Vert.ptr);
+		NarrowBand::value_type v( (float) rDistance, &Vert );
+		Vert.ptr = map.insert(v);
+	}
+}
+
 
 
 } // End namespace GW
@@ -15,6 +15,7 @@ class GW_GeodesicVertex: public GW_Vertex
 public:
 
 	NarrowBand::iterator ptr;		//ALEX: for finding points by ID in the heap
+	int nHeapPosition;				//position in the NarrowBandHeap, -1 if not in it
 
 	enum T_GeodesicVertexState
 	{
@@ -23,6 +23,7 @@ namespace GW {
 GW_INLINE
 GW_GeodesicVertex::GW_GeodesicVertex()
 :	GW_Vertex	(),
+	nHeapPosition	( -1 ),
 	rDistance_	( GW_INFINITE ),
 	nState_		( kFar ),
 	pFront_		( NULL ),
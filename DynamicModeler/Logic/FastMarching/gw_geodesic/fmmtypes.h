@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 
 namespace GW
 {
@@ -9,5 +10,108 @@ class GW_GeodesicVertex;
 
 typedef std::multimap<float,GW::GW_GeodesicVertex*> NarrowBand;
 
+//Narrowband as an indexed D-ary min-heap stored in an array. Each element keeps
+//its position in the heap (T::nHeapPosition, -1 if it is not in the heap), so a
+//decreased distance is moved up in place instead of erasing and inserting a
+//tree node. Equal keys are ordered by insertion, as in NarrowBand.
+template<class T, int D=4>
+class NarrowBandHeap
+{
+public:
+	NarrowBandHeap() : nCount_(0) {}
+
+	bool empty() const { return Nodes_.empty(); }
+	size_t size() const { return Nodes_.size(); }
+	T* top() const { return Nodes_[0].pElement; }
+
+	void clear()
+	{
+		for( size_t i=0; i<Nodes_.size(); ++i )
+			Nodes_[i].pElement->nHeapPosition = -1;
+		Nodes_.clear();
+		nCount_ = 0;
+	}
+
+	void push( float rKey, T* pElement )
+	{
+		T_Node node = { rKey, nCount_++, pElement };
+		Nodes_.push_back( node );
+		this->SiftUp( Nodes_.size()-1 );
+	}
+
+	void pop()
+	{
+		Nodes_[0].pElement->nHeapPosition = -1;
+		Nodes_[0] = Nodes_.back();
+		Nodes_.pop_back();
+		if( !Nodes_.empty() )
+			this->SiftDown( 0 );
+	}
+
+	//the new key must not be larger than the current one
+	void decrease( float rKey, T* pElement )
+	{
+		T_Node& node = Nodes_[pElement->nHeapPosition];
+		node.rKey = rKey;
+		node.nOrder = nCount_++;
+		this->SiftUp( pElement->nHeapPosition );
+	}
+
+private:
+	struct T_Node
+	{
+		float rKey;
+		unsigned int nOrder;
+		T* pElement;
+		bool operator<( const T_Node& other ) const
+		{
+			return rKey<other.rKey || ( rKey==other.rKey && nOrder<other.nOrder );
+		}
+	};
+
+	void SiftUp( size_t i )
+	{
+		T_Node node = Nodes_[i];
+		while( i>0 )
+		{
+			size_t parent = (i-1)/D;
+			if( !(node<Nodes_[parent]) )
+				break;
+			Nodes_[i] = Nodes_[parent];
+			Nodes_[i].pElement->nHeapPosition = (int) i;
+			i = parent;
+		}
+		Nodes_[i] = node;
+		node.pElement->nHeapPosition = (int) i;
+	}
+
+	void SiftDown( size_t i )
+	{
+		T_Node node = Nodes_[i];
+		size_t n = Nodes_.size();
+		for(;;)
+		{
+			size_t first = i*D+1;
+			if( first>=n )
+				break;
+			size_t last = first+D<n ? first+D : n;
+			size_t child = first;
+			for( size_t c=first+1; c<last; ++c )
+				if( Nodes_[c]<Nodes_[child] )
+					child = c;
+			if( !(Nodes_[child]<node) )
+				break;
+			Nodes_[i] = Nodes_[child];
+			Nodes_[i].pElement->nHeapPosition = (int) i;
+			i = child;
+		}
+		Nodes_[i] = node;
+		node.pElement->nHeapPosition = (int) i;
+	}
+
+	std::vector<T_Node> Nodes_;
+	unsigned int nCount_;	//insertion counter, orders equal keys
+};
+
 
 
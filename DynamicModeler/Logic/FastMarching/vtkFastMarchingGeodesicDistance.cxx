@@ -13,15 +13,16 @@
 #include "vtkExecutive.h"
 #include "vtkIdList.h"
 #include "vtkFloatArray.h"
-#include "vtkCellArray.h"
 #include "vtkCommand.h"
+#include "vtkGeodesicMeshCache.h"
+#include "vtkWeakPointer.h"
 
-#include "GW_GeodesicMesh.h"
-#include "GW_GeodesicPath.h"
+#include "GW_CompactGeodesicMesh.h"
 #include "GW_Vertex.h"
 #include "GW_Face.h"
 #include <assert.h>
 #include <set>
+#include <vector>
 
 #ifdef _WIN32
 // new is being defined to a new method that takes in 4 parameters.
@@ -39,6 +40,10 @@ vtkCxxSetObjectMacro(vtkFastMarchingGeodesicDistance,
                      ExclusionPointIds, vtkIdList);
 vtkCxxSetObjectMacro(vtkFastMarchingGeodesicDistance,
                      PropagationWeights, vtkDataArray);
+vtkCxxSetObjectMacro(vtkFastMarchingGeodesicDistance,
+                     DestinationVertexStopMask, vtkDataArray);
+vtkCxxSetObjectMacro(vtkFastMarchingGeodesicDistance,
+                     ExclusionPointMask, vtkDataArray);
 
 //-----------------------------------------------------------------------------
 class vtkGeodesicMeshInternals
@@ -51,16 +56,13 @@ public:
 
   ~vtkGeodesicMeshInternals()
     {
-    if (this->Mesh)
-      {
-      delete this->Mesh;
-      }
+    delete this->Mesh;
     }
 
   // This callback is called every time a front vertex is visited to check
   // if we should terminate marching.
   static GW::GW_Bool FastMarchingStopCallback(
-      GW::GW_GeodesicVertex& v, void *callbackData )
+      GW::GW_U32 v, void *callbackData )
     {
     vtkFastMarchingGeodesicDistance *filter =
       static_cast< vtkFastMarchingGeodesicDistance* >(callbackData);
@@ -68,62 +70,99 @@ public:
     // Stop if the vertex is farther than the distance stop criteria
     if (filter->DistanceStopCriterion > 0)
       {
-      return (filter->DistanceStopCriterion <= v.GetDistance());
+      return (filter->DistanceStopCriterion <=
+              filter->Internals->Mesh->GetDistance(v));
       }
 
     // Stop if the vertex id is one of the destination vertices
-    if (filter->DestinationVertexStopCriterion->GetNumberOfIds())
-      {
-      if (filter->DestinationVertexStopCriterion->IsId(v.GetID()) != -1)
-        {
-        return true;
-        }
-      }
-
-    return false;
+    return filter->Internals->DestinationVertexFlags[v] != 0;
     }
 
 
   // This callback is invoked prior to adding new vertices to the front
   static GW::GW_Bool FastMarchingVertexInsertionCallback(
-      GW::GW_GeodesicVertex& v, GW::GW_Float vtkNotUsed(distance), void *callbackData )
+      GW::GW_U32 v, GW::GW_Float vtkNotUsed(distance), void *callbackData )
     {
     vtkFastMarchingGeodesicDistance *filter =
       static_cast< vtkFastMarchingGeodesicDistance* >(callbackData);
 
     // Prevent bleeding into exclusion regions
-    if (filter->ExclusionPointIds->GetNumberOfIds())
-      {
-      if (filter->ExclusionPointIds->IsId(v.GetID()) != -1)
-        {
-        // do not add it.
-        return false;
-        }
-      }
-
-    return true;
+    return filter->Internals->ExclusionPointFlags[v] == 0;
     }
 
   // This callback is invoked to get the propagation weight at a given vertex.
   // The default (if not specified) is a constant weight of 1 everywhere.
   static GW::GW_Float FastMarchingPropagationWeightCallback(
-      GW::GW_GeodesicVertex& v, void *callbackData )
+      GW::GW_U32 v, void *callbackData )
     {
     vtkFastMarchingGeodesicDistance *filter =
       static_cast< vtkFastMarchingGeodesicDistance* >(callbackData);
 
-    return (GW::GW_Float)filter->PropagationWeights->GetTuple1(v.GetID());
+    return (GW::GW_Float)filter->PropagationWeights->GetTuple1(v);
     }
 
   // This callback is invoked to get the propagation weight at a given vertex.
   // Th result is no weight == 1
   static inline GW::GW_Float FastMarchingPropagationNoWeightCallback(
-      GW::GW_GeodesicVertex&, void * )
+      GW::GW_U32, void * )
     {
     return 1.0;
     }
 
-  GW::GW_GeodesicMesh *Mesh;
+  // Flag the vertices that are in the id list or have a non zero value in
+  // the mask, so that the callbacks do not search the list for every front
+  // vertex. Returns true if any vertex is flagged.
+  static bool SetupVertexFlags( std::vector< unsigned char > &flags,
+                                vtkIdList *ids, vtkDataArray *mask,
+                                vtkIdType nbrVertex )
+    {
+    const bool hasIds = ids && ids->GetNumberOfIds();
+    const bool hasMask = mask && mask->GetNumberOfTuples() == nbrVertex;
+    if (!hasIds && !hasMask)
+      {
+      flags.clear();
+      return false;
+      }
+
+    flags.assign(static_cast< size_t >(nbrVertex), 0);
+    bool flagged = false;
+    if (hasIds)
+      {
+      const vtkIdType n = ids->GetNumberOfIds();
+      for (vtkIdType i = 0; i < n; i++)
+        {
+        const vtkIdType id = ids->GetId(i);
+        if (id >= 0 && id < nbrVertex)
+          {
+          flags[id] = 1;
+          flagged = true;
+          }
+        }
+      }
+    if (hasMask)
+      {
+      for (vtkIdType i = 0; i < nbrVertex; i++)
+        {
+        if (mask->GetComponent(i, 0) != 0)
+          {
+          flags[i] = 1;
+          flagged = true;
+          }
+        }
+      }
+    return flagged;
+    }
+
+  // The mesh fast marching runs on, paths are traced on it too
+  GW::GW_CompactGeodesicMesh *Mesh;
+
+  // The polydata the mesh was set up from
+  vtkWeakPointer< vtkPolyData > MeshPolyData;
+
+  // Per vertex flags of the destination vertices and the exclusion region,
+  // set up from the id lists and the masks by SetupCallbacks
+  std::vector< unsigned char > DestinationVertexFlags;
+  std::vector< unsigned char > ExclusionPointFlags;
 };
 
 
@@ -137,6 +176,8 @@ vtkFastMarchingGeodesicDistance::vtkFastMarchingGeodesicDistance()
   this->DistanceStopCriterion = -1;
   this->DestinationVertexStopCriterion = NULL;
   this->ExclusionPointIds = NULL;
+  this->DestinationVertexStopMask = NULL;
+  this->ExclusionPointMask = NULL;
   this->PropagationWeights = NULL;
   this->IterationIndex = 0;
   this->FastMarchingIterationEventResolution = 100;
@@ -147,6 +188,8 @@ vtkFastMarchingGeodesicDistance::~vtkFastMarchingGeodesicDistance()
 {
   this->SetDestinationVertexStopCriterion(NULL);
   this->SetExclusionPointIds(NULL);
+  this->SetDestinationVertexStopMask(NULL);
+  this->SetExclusionPointMask(NULL);
   this->SetPropagationWeights(NULL);
   delete this->Internals;
 }
@@ -194,78 +237,28 @@ int vtkFastMarchingGeodesicDistance::RequestData(
 void vtkFastMarchingGeodesicDistance::SetupGeodesicMesh( vtkPolyData *in )
 {
   if (this->GeodesicMeshBuildTime.GetMTime() < in->GetMTime()
+      || this->Internals->MeshPolyData != in
       || !this->Internals->Mesh)
     {
-    // Need to rebuild the GW_GeodesicMesh
+    // Need to get the GW_CompactGeodesicMesh of this polydata, from the
+    // cache shared with other filters or built from it
 
     if (!this->Internals->Mesh)
       {
-      delete this->Internals->Mesh;
-      this->Internals->Mesh = new GW::GW_GeodesicMesh();
+      this->Internals->Mesh = new GW::GW_CompactGeodesicMesh();
       this->Internals->Mesh->SetCallbackData(this);
       }
 
-    // Setup the GW_GeodesicMesh mesh
-    GW::GW_GeodesicMesh *mesh = this->Internals->Mesh;
-
-    // Setup the mesh points
-    double pt[3];
-    vtkPoints *pts = in->GetPoints();
-    const int nPts = in->GetNumberOfPoints();
-    mesh->SetNbrVertex(nPts);
-
-    for (int i=0; i < nPts; i++) // loop over the points and copy them over
-      {
-      pts->GetPoint(i, pt);
-      GW::GW_GeodesicVertex & point =
-          (GW::GW_GeodesicVertex &)mesh->CreateNewVertex();
-      point.SetPosition( GW::GW_Vector3D( pt[0], pt[1], pt[2] ) );
-      mesh->SetVertex( i, &point );
-      }
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 90)
-    const vtkIdType* ptIds = nullptr;
-#else
-    vtkIdType *ptIds = nullptr;
-#endif
-    vtkIdType npts = 0;
-    const int nCells = in->GetNumberOfPolys();
-    vtkCellArray *cells = in->GetPolys();
-    if (!cells)
+    if (!vtkGeodesicMeshCache::GetInstance()->SetupMesh(
+          in, this->Internals->Mesh))
       {
+      vtkErrorMacro( << "This filter can only work with triangle meshes." );
+      delete this->Internals->Mesh;
+      this->Internals->Mesh = NULL;
       return;
       }
-    cells->InitTraversal();
-
-    mesh->SetNbrFace(nCells);
-    for ( int i = 0; i < nCells; i++)
-      {
-      // Possible types
-      //    VTK_VERTEX, VTK_POLY_VERTEX, VTK_LINE,
-      //    VTK_POLY_LINE,VTK_TRIANGLE, VTK_QUAD,
-      //    VTK_POLYGON, or VTK_TRIANGLE_STRIP.
-
-      // only handle triangles
-      cells->GetNextCell(npts, ptIds);
-
-      // bail out
-      if (npts != 3)
-        {
-        vtkErrorMacro( << "This filter can only work with triangle meshes." );
-        delete this->Internals->Mesh;
-        this->Internals->Mesh = NULL;
-        return;
-        }
-
-      GW::GW_GeodesicFace& cell = (GW::GW_GeodesicFace &) mesh->CreateNewFace();
-      GW::GW_Vertex* a = mesh->GetVertex(ptIds[0]);
-      GW::GW_Vertex* b = mesh->GetVertex(ptIds[1]);
-      GW::GW_Vertex* c = mesh->GetVertex(ptIds[2]);
-      cell.SetVertex( *a, *b, *c );
-      mesh->SetFace( i, &cell );
-      }
-
-    mesh->BuildConnectivity();
 
+    this->Internals->MeshPolyData = in;
     this->GeodesicMeshBuildTime.Modified();
     }
 
@@ -283,11 +276,10 @@ void vtkFastMarchingGeodesicDistance::AddSeeds()
     }
 
   const int n = this->Seeds->GetNumberOfIds();
-  GW::GW_GeodesicMesh *mesh = this->Internals->Mesh;
+  GW::GW_CompactGeodesicMesh *mesh = this->Internals->Mesh;
   for (int i = 0; i < n; i++)
     {
-    mesh->AddStartVertex( *((GW::GW_GeodesicVertex*)mesh->
-        GetVertex((GW::GW_U32)(this->Seeds->GetId(i)))));
+    mesh->AddStartVertex((GW::GW_U32)(this->Seeds->GetId(i)));
     }
 }
 
@@ -315,7 +307,7 @@ int vtkFastMarchingGeodesicDistance::Compute()
 //-----------------------------------------------------------------------------
 void vtkFastMarchingGeodesicDistance::CopyDistanceField(vtkPolyData *pd)
 {
-  GW::GW_GeodesicMesh *mesh = this->Internals->Mesh;
+  GW::GW_CompactGeodesicMesh *mesh = this->Internals->Mesh;
 
   float distance;
   this->MaximumDistance = 0;
@@ -326,14 +318,11 @@ void vtkFastMarchingGeodesicDistance::CopyDistanceField(vtkPolyData *pd)
 
   for (int i = 0; i < n; i++)
     {
-    GW::GW_GeodesicVertex* vertex =
-     (GW::GW_GeodesicVertex*)(mesh->GetVertex((GW::GW_U32)i));
-
-    if (vertex->GetState() > 1)
+    if (mesh->GetState((GW::GW_U32)i) > 1)
       {
       // This point is in the traversal list
       ++this->NumberOfVisitedPoints;
-      distance = vertex->GetDistance();
+      distance = mesh->GetDistance((GW::GW_U32)i);
       if (distance > this->MaximumDistance)
         {
         this->MaximumDistance = distance;
@@ -359,10 +348,15 @@ void vtkFastMarchingGeodesicDistance::CopyDistanceField(vtkPolyData *pd)
 //-----------------------------------------------------------------------------
 void vtkFastMarchingGeodesicDistance::SetupCallbacks()
 {
+  const vtkIdType nbrVertex =
+    static_cast< vtkIdType >(this->Internals->Mesh->GetNbrVertex());
+
   // Setup termination criteria
-  if (this->DistanceStopCriterion > 0 ||
-      (this->DestinationVertexStopCriterion &&
-       this->DestinationVertexStopCriterion->GetNumberOfIds()))
+  const bool hasDestination = vtkGeodesicMeshInternals::SetupVertexFlags(
+    this->Internals->DestinationVertexFlags,
+    this->DestinationVertexStopCriterion, this->DestinationVertexStopMask,
+    nbrVertex);
+  if (this->DistanceStopCriterion > 0 || hasDestination)
     {
     this->Internals->Mesh->RegisterForceStopCallbackFunction(
           vtkGeodesicMeshInternals::FastMarchingStopCallback);
@@ -373,7 +367,9 @@ void vtkFastMarchingGeodesicDistance::SetupCallbacks()
     }
 
   // Setup callback prior to adding a new vertex into the front
-  if (this->ExclusionPointIds && this->ExclusionPointIds->GetNumberOfIds())
+  if (vtkGeodesicMeshInternals::SetupVertexFlags(
+        this->Internals->ExclusionPointFlags,
+        this->ExclusionPointIds, this->ExclusionPointMask, nbrVertex))
     {
     this->Internals->Mesh->RegisterVertexInsersionCallbackFunction(
       vtkGeodesicMeshInternals::FastMarchingVertexInsertionCallback);
@@ -386,8 +382,7 @@ void vtkFastMarchingGeodesicDistance::SetupCallbacks()
 
   // Setup callback to get the propagation weights
   if (this->PropagationWeights &&
-        this->PropagationWeights->GetNumberOfTuples() ==
-            static_cast<vtkIdType>(this->Internals->Mesh->GetNbrVertex()))
+        this->PropagationWeights->GetNumberOfTuples() == nbrVertex)
     {
     this->Internals->Mesh->RegisterWeightCallbackFunction(
       vtkGeodesicMeshInternals::FastMarchingPropagationWeightCallback);
@@ -447,6 +442,9 @@ void vtkFastMarchingGeodesicDistance::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->ExclusionPointIds->PrintSelf(os, indent.GetNextIndent());
     }
+  os << indent << "DestinationVertexStopMask: "
+     << this->DestinationVertexStopMask << endl;
+  os << indent << "ExclusionPointMask: " << this->ExclusionPointMask << endl;
   os << indent << "PropagationWeights: " << this->ExclusionPointIds << endl;
   if (this->PropagationWeights)
     {
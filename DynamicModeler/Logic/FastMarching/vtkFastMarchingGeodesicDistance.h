@@ -28,14 +28,16 @@
 // See SetDistanceStopCriterion(float)
 // (b) Destination vertex stop criterion: The fast marching stops if any
 // portion of the front reaches the user supplied destination vertex id(s).
-// See SetDestinationVertexStopCriterion(vtkIdList)
+// See SetDestinationVertexStopCriterion(vtkIdList) and
+// SetDestinationVertexStopMask(vtkDataArray)
 //
 // .SECTION Exclusion Regions
 // Optionally, an exclusion region may be specified. Vertices with ids that
 // are in the exclusion list are ommitted from inclusion in the fast marching
 // front. This can be used to prevent fast from bleeding into certain regions
 // by supplying the point ids of the region boundary/boundaries. Conversely, it
-// can be used to confine fast marching to a specific region.
+// can be used to confine fast marching to a specific region. The region may
+// also be given as a mask, see SetExclusionPointMask(vtkDataArray).
 //
 // .SECTION Propagation weights
 // The default propagation weights are constant and isotropic = 1. One may
@@ -45,6 +47,11 @@
 // propagate quickly in regions of low curvature and slow down in regions of
 // high curvature. Note that the propagation weights must be strictly positive.
 //
+// .SECTION Mesh cache
+// The mesh the fast marching runs on is built from the input the first time
+// it is used and kept in vtkGeodesicMeshCache, so that other filters running
+// on the same input (and unmodified) do not build it again.
+//
 // .SECTION Miscellaneous
 // The filter reports IterationEvents. It does not report progress events,
 // since its not possible to pre-determine when the front might terminate.
@@ -104,6 +111,15 @@ public:
   virtual void SetDestinationVertexStopCriterion( vtkIdList *vertices );
   vtkGetObjectMacro( DestinationVertexStopCriterion, vtkIdList );
 
+  // Description:
+  // The destination vertices may also be given as a mask, for instance a
+  // point data array of the input: fast marching stops when it reaches a
+  // vertex with a non zero value. The mask must have as many tuples as the
+  // mesh has points, only its first component is used. Vertices in the mask
+  // or in DestinationVertexStopCriterion are destinations.
+  virtual void SetDestinationVertexStopMask( vtkDataArray * );
+  vtkGetObjectMacro( DestinationVertexStopMask, vtkDataArray );
+
   // Description:
   // Optionally, an exclusion region may be specified. Vertices with ids that
   // are in the exclusion list are ommitted from inclusion in the fast marching
@@ -112,6 +128,15 @@ public:
   virtual void SetExclusionPointIds( vtkIdList *vertices );
   vtkGetObjectMacro( ExclusionPointIds, vtkIdList );
 
+  // Description:
+  // The exclusion region may also be given as a mask, for instance a point
+  // data array of the input: vertices with a non zero value are excluded. The
+  // mask must have as many tuples as the mesh has points, only its first
+  // component is used. Vertices in the mask or in ExclusionPointIds are
+  // excluded.
+  virtual void SetExclusionPointMask( vtkDataArray * );
+  vtkGetObjectMacro( ExclusionPointMask, vtkDataArray );
+
   // Description:
   // Optionally, point weights may be specified. This amounts to specifying a
   // non-uniform speed function. Each point may for instance be weighted
@@ -135,10 +160,11 @@ protected:
 
   int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
 
-  // Create GW_GeodesicMesh given an instance of a vtkPolyData
+  // Get the GW_CompactGeodesicMesh of a vtkPolyData from vtkGeodesicMeshCache
   void SetupGeodesicMesh( vtkPolyData *in );
 
-  // Setup the optional termination criteria, if set
+  // Setup the optional termination criteria, if set. The destination
+  // vertices and the exclusion region are turned into per vertex flags.
   void SetupCallbacks();
 
   // Do the fast marching
@@ -150,10 +176,10 @@ protected:
   // Copy the resulting distance field from GeoMesh into the float array
   void CopyDistanceField( vtkPolyData *pd );
 
-  // The internal GW_GeodsicMesh structure
+  // The internal GW_CompactGeodesicMesh structure
   vtkGeodesicMeshInternals * Internals;
 
-  // Time the GW_GeodesicMesh datastructure was last built from a vtkPolyData
+  // Time the GW_CompactGeodesicMesh datastructure was last set up from a vtkPolyData
   vtkTimeStamp GeodesicMeshBuildTime;
 
   // The maximum distance we've marched.
@@ -174,12 +200,19 @@ protected:
   // Exclusion regions
   vtkIdList * ExclusionPointIds;
 
+  // Destination vertices and exclusion regions as per vertex masks
+  vtkDataArray * DestinationVertexStopMask;
+  vtkDataArray * ExclusionPointMask;
+
   // Propagation, ie speed function weights
   vtkDataArray * PropagationWeights;
 
   //BTX
   friend class vtkFastMarchingGeodesicPath;
   friend class vtkGeodesicMeshInternals;
+  // The marched GW_CompactGeodesicMesh, with the distances of the last
+  // fast marching, for tracing paths. Its adjacency is shared through
+  // vtkGeodesicMeshCache.
   void *GetGeodesicMesh();
   //ETX
 
@@ -17,10 +17,8 @@
 #include "vtkCellArray.h"
 #include "vtkNew.h"
 
-#include "GW_GeodesicMesh.h"
-#include "GW_GeodesicPath.h"
-#include "GW_Vertex.h"
-#include "GW_Face.h"
+#include "GW_CompactGeodesicMesh.h"
+#include "GW_CompactGeodesicPath.h"
 #include "GW_Config.h"
 #include <assert.h>
 #include <set>
@@ -84,7 +82,7 @@ int vtkFastMarchingGeodesicPath::RequestData(
   // seeded points, if necessary (if the mesh or seeds have changed)
   this->Geodesic->Update();
 
-  // Initialize the GW_GeodesicMesh structure
+  // Trace the path on the marched mesh
   this->ComputePath(output);
 
   return 1;
@@ -112,23 +110,24 @@ void vtkFastMarchingGeodesicPath::ComputePath(vtkPolyData *pd)
   vtkSmartPointer< vtkPoints > pathPoints = vtkSmartPointer< vtkPoints >::New();
   pathPoints->Initialize();
 
-  GW::GW_GeodesicMesh *mesh = (GW::GW_GeodesicMesh *)(
+  // The marched mesh, with the distances of the fast marching. Its
+  // connectivity is shared with the other filters on the same input.
+  GW::GW_CompactGeodesicMesh *mesh = (GW::GW_CompactGeodesicMesh *)(
                         this->Geodesic->GetGeodesicMesh());
-  GW::GW_GeodesicVertex* begin =
-    (GW::GW_GeodesicVertex*)(mesh->GetVertex((GW::GW_U32)this->BeginPointId));
-  if (!begin)
+  if (!mesh || this->BeginPointId < 0 ||
+      this->BeginPointId >= static_cast< vtkIdType >(mesh->GetNbrVertex()))
     {
     vtkErrorMacro( << "BeginPointId was not found to lie on the mesh." );
     return;
     }
 
-  GW::GW_GeodesicPath track;
-  track.ComputePath(*begin, this->MaximumPathPoints);
+  GW::GW_CompactGeodesicPath track;
+  track.ComputePath(*mesh, (GW::GW_U32)this->BeginPointId,
+                    (GW::GW_U32)this->MaximumPathPoints);
 
-  GW::T_GeodesicPointList ptList = track.GetPointList();
-  GW::GW_GeodesicPoint* pt;
+  const GW::GW_CompactGeodesicPath::T_PathPointVector& ptList =
+    track.GetPointList();
   float parametricPos;
-  GW::GW_GeodesicVertex *endVert1, *endVert2;
   GW::GW_Vector3D endPt1, endPt2;
   double pathPt[3], lastPathPt[3];
   vtkIdType endPtId1, endPtId2, lastInsertedPtId = -1;
@@ -145,22 +144,19 @@ void vtkFastMarchingGeodesicPath::ComputePath(vtkPolyData *pd)
     this->FirstOrderPathPointIds->SetNumberOfIds( nPts * 2 );
     }
 
-  for ( GW::CIT_GeodesicPointList cit = ptList.begin(), citEnd = ptList.end();
+  for ( GW::GW_CompactGeodesicPath::T_PathPointVector::const_iterator
+        cit = ptList.begin(), citEnd = ptList.end();
         cit != citEnd; ++cit, ++i, lastPathPt[0] = pathPt[0],
         lastPathPt[1] = pathPt[1], lastPathPt[2] = pathPt[2])
     {
-    pt = *cit;
-
       // The parametric position of the vertex on the edge
-    parametricPos = pt->GetCoord();
+    parametricPos = cit->rCoord;
 
     // Get the end points of the edge on which the path lies.
-    endVert1 = pt->GetVertex1();
-    endVert2 = pt->GetVertex2();
-    endPt1 = endVert1->GetPosition();
-    endPt2 = endVert2->GetPosition();
-    endPtId1 = endVert1->GetID();
-    endPtId2 = endVert2->GetID();
+    endPtId1 = cit->nVert1;
+    endPtId2 = cit->nVert2;
+    endPt1 = mesh->GetPosition(cit->nVert1);
+    endPt2 = mesh->GetPosition(cit->nVert2);
 
     // Store the edge point ids. The ZerothOrderPointIds contain the closest
     // one. The FirstOrderPointIds contains the other one.
@@ -0,0 +1,331 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkGeodesicMeshCache.h"
+
+#include "vtkCallbackCommand.h"
+#include "vtkCommand.h"
+#include "vtkObjectFactory.h"
+#include "vtkPolyData.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkSmartPointer.h"
+
+#include "GW_CompactGeodesicMesh.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#ifdef _WIN32
+// new is being defined to a new method that takes in 4 parameters.
+// Go back to what its supposed to be !
+#ifdef new
+#undef new
+#endif
+#endif
+
+//-----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkGeodesicMeshCache);
+
+//-----------------------------------------------------------------------------
+class vtkGeodesicMeshCacheInternals
+{
+public:
+  typedef std::shared_ptr< const GW::GW_CompactGeodesicMesh::T_Connectivity > ConnectivityType;
+
+  struct Entry
+    {
+    // Valid while the entry exists, the entry is removed when the polydata
+    // is deleted
+    vtkPolyData *Key;
+    vtkMTimeType MTime;
+    ConnectivityType Connectivity;
+    vtkTypeInt64 MemorySize;
+    };
+  typedef std::list< Entry > EntryList;
+
+  vtkGeodesicMeshCacheInternals()
+    {
+    this->MemorySize = 0;
+    this->DeleteCallback = vtkSmartPointer< vtkCallbackCommand >::New();
+    this->DeleteCallback->SetCallback(&vtkGeodesicMeshCacheInternals::OnDelete);
+    this->DeleteCallback->SetClientData(this);
+    }
+
+  ~vtkGeodesicMeshCacheInternals()
+    {
+    // The observers stay on the polydata that outlive the cache
+    this->DeleteCallback->SetClientData(nullptr);
+    }
+
+  // Remove the entry of a polydata when it is deleted, so that its mesh is
+  // released at once and its address can be reused by another polydata.
+  // Called on the thread deleting the polydata.
+  static void OnDelete( vtkObject *caller, unsigned long, void *clientData, void * )
+    {
+    vtkGeodesicMeshCacheInternals *self =
+      static_cast< vtkGeodesicMeshCacheInternals* >(clientData);
+    if (!self)
+      {
+      return;
+      }
+    vtkPolyData *pd = static_cast< vtkPolyData* >(caller);
+    std::lock_guard< std::mutex > lock(self->Mutex);
+    self->Observed.erase(pd);
+    auto it = self->Index.find(pd);
+    if (it != self->Index.end())
+      {
+      self->Remove(it->second);
+      }
+    }
+
+  // Observe the deletion of a polydata, once. The lock must be held.
+  void Observe( vtkPolyData *pd )
+    {
+    if (this->Observed.insert(pd).second)
+      {
+      pd->AddObserver(vtkCommand::DeleteEvent, this->DeleteCallback);
+      }
+    }
+
+  // Remove an entry. The lock must be held.
+  void Remove( EntryList::iterator it )
+    {
+    this->MemorySize -= it->MemorySize;
+    this->Index.erase(it->Key);
+    this->Entries.erase(it);
+    }
+
+  // Remove the least recently used entries until the cache fits. The lock
+  // must be held.
+  void Shrink( vtkTypeInt64 maximumMemorySize )
+    {
+    while (!this->Entries.empty() && this->MemorySize > maximumMemorySize)
+      {
+      this->Remove(--this->Entries.end());
+      }
+    }
+
+  // Most recently used first
+  EntryList Entries;
+  std::map< vtkPolyData*, EntryList::iterator > Index;
+  vtkTypeInt64 MemorySize;
+  // Polydata whose deletion is observed. The observer is kept when the
+  // entry is removed, as removing it could race with the deletion of the
+  // polydata on another thread.
+  std::set< vtkPolyData* > Observed;
+  vtkSmartPointer< vtkCallbackCommand > DeleteCallback;
+  std::mutex Mutex;
+};
+
+//-----------------------------------------------------------------------------
+vtkGeodesicMeshCache::vtkGeodesicMeshCache()
+{
+  this->Internals = new vtkGeodesicMeshCacheInternals;
+  this->MaximumMemorySize = 512 * 1024 * 1024;
+}
+
+//-----------------------------------------------------------------------------
+vtkGeodesicMeshCache::~vtkGeodesicMeshCache()
+{
+  delete this->Internals;
+}
+
+//-----------------------------------------------------------------------------
+vtkGeodesicMeshCache *vtkGeodesicMeshCache::GetInstance()
+{
+  static vtkSmartPointer< vtkGeodesicMeshCache > instance =
+    vtkSmartPointer< vtkGeodesicMeshCache >::New();
+  return instance;
+}
+
+//-----------------------------------------------------------------------------
+void vtkGeodesicMeshCache::SetMaximumMemorySize( vtkTypeInt64 size )
+{
+  std::lock_guard< std::mutex > lock(this->Internals->Mutex);
+  if (this->MaximumMemorySize == size)
+    {
+    return;
+    }
+  this->MaximumMemorySize = size;
+  this->Internals->Shrink(size);
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+vtkTypeInt64 vtkGeodesicMeshCache::GetMemorySize()
+{
+  std::lock_guard< std::mutex > lock(this->Internals->Mutex);
+  return this->Internals->MemorySize;
+}
+
+//-----------------------------------------------------------------------------
+int vtkGeodesicMeshCache::GetNumberOfMeshes()
+{
+  std::lock_guard< std::mutex > lock(this->Internals->Mutex);
+  return static_cast< int >(this->Internals->Entries.size());
+}
+
+//-----------------------------------------------------------------------------
+void vtkGeodesicMeshCache::RemoveMesh( vtkPolyData *pd )
+{
+  std::lock_guard< std::mutex > lock(this->Internals->Mutex);
+  auto it = this->Internals->Index.find(pd);
+  if (it != this->Internals->Index.end())
+    {
+    this->Internals->Remove(it->second);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkGeodesicMeshCache::RemoveAllMeshes()
+{
+  std::lock_guard< std::mutex > lock(this->Internals->Mutex);
+  this->Internals->Entries.clear();
+  this->Internals->Index.clear();
+  this->Internals->MemorySize = 0;
+}
+
+//-----------------------------------------------------------------------------
+int vtkGeodesicMeshCache::SetupMesh( vtkPolyData *pd,
+                                     GW::GW_CompactGeodesicMesh *mesh )
+{
+  typedef vtkGeodesicMeshCacheInternals::EntryList EntryList;
+  const vtkMTimeType mtime = pd->GetMTime();
+
+  {
+  std::lock_guard< std::mutex > lock(this->Internals->Mutex);
+  auto it = this->Internals->Index.find(pd);
+  if (it != this->Internals->Index.end())
+    {
+    EntryList::iterator entry = it->second;
+    if (entry->MTime == mtime)
+      {
+      // Cached, now the most recently used
+      this->Internals->Entries.splice(
+        this->Internals->Entries.begin(), this->Internals->Entries, entry);
+      if (mesh->GetConnectivity() != entry->Connectivity)
+        {
+        mesh->SetConnectivity(entry->Connectivity);
+        }
+      return 1;
+      }
+    // The polydata was modified
+    this->Internals->Remove(entry);
+    }
+  }
+
+  // Build it without holding the lock, other surfaces can be looked up
+  // meanwhile. Start from an empty mesh rather than a copy of a shared one.
+  mesh->SetConnectivity(
+    std::make_shared< GW::GW_CompactGeodesicMesh::T_Connectivity >());
+  if (!vtkGeodesicMeshCache::BuildMesh(pd, mesh))
+    {
+    return 0;
+    }
+
+  std::lock_guard< std::mutex > lock(this->Internals->Mutex);
+  vtkGeodesicMeshCacheInternals::Entry entry;
+  entry.Key = pd;
+  entry.MTime = mtime;
+  entry.Connectivity = mesh->GetConnectivity();
+  entry.MemorySize = static_cast< vtkTypeInt64 >(entry.Connectivity->GetMemorySize());
+  if (entry.MemorySize > this->MaximumMemorySize)
+    {
+    // Would not fit anyway
+    return 1;
+    }
+  auto it = this->Internals->Index.find(pd);
+  if (it != this->Internals->Index.end())
+    {
+    // Built concurrently by another filter
+    this->Internals->Remove(it->second);
+    }
+  this->Internals->Observe(pd);
+  this->Internals->Entries.push_front(entry);
+  this->Internals->Index[pd] = this->Internals->Entries.begin();
+  this->Internals->MemorySize += entry.MemorySize;
+  this->Internals->Shrink(this->MaximumMemorySize);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+int vtkGeodesicMeshCache::BuildMesh( vtkPolyData *in,
+                                     GW::GW_CompactGeodesicMesh *mesh )
+{
+  // Setup the mesh points
+  double pt[3];
+  vtkPoints *pts = in->GetPoints();
+  const int nPts = in->GetNumberOfPoints();
+  mesh->SetNbrVertex(nPts);
+
+  for (int i=0; i < nPts; i++) // loop over the points and copy them over
+    {
+    pts->GetPoint(i, pt);
+    mesh->SetPosition( i, pt[0], pt[1], pt[2] );
+    }
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 90)
+  const vtkIdType* ptIds = nullptr;
+#else
+  vtkIdType *ptIds = nullptr;
+#endif
+  vtkIdType npts = 0;
+  const int nCells = in->GetNumberOfPolys();
+  vtkCellArray *cells = in->GetPolys();
+  if (!cells)
+    {
+    // Vertices only, nothing to march on
+    mesh->SetNbrFace(0);
+    mesh->BuildConnectivity();
+    return 1;
+    }
+  cells->InitTraversal();
+
+  mesh->SetNbrFace(nCells);
+  for ( int i = 0; i < nCells; i++)
+    {
+    // Possible types
+    //    VTK_VERTEX, VTK_POLY_VERTEX, VTK_LINE,
+    //    VTK_POLY_LINE,VTK_TRIANGLE, VTK_QUAD,
+    //    VTK_POLYGON, or VTK_TRIANGLE_STRIP.
+
+    // only handle triangles
+    cells->GetNextCell(npts, ptIds);
+
+    // bail out
+    if (npts != 3)
+      {
+      return 0;
+      }
+
+    mesh->SetFace( i, ptIds[0], ptIds[1], ptIds[2] );
+    }
+
+  mesh->BuildConnectivity();
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkGeodesicMeshCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "MaximumMemorySize: " << this->MaximumMemorySize << endl;
+  os << indent << "MemorySize: " << this->GetMemorySize() << endl;
+  os << indent << "NumberOfMeshes: " << this->GetNumberOfMeshes() << endl;
+}
@@ -0,0 +1,113 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkGeodesicMeshCache - Process-wide cache of the meshes fast marching runs on
+// .SECTION Description
+// Fast marching needs the adjacency of the surface (the faces and vertices
+// around each vertex, and the neighbors of each face), which takes longer to
+// build than a short marching. This cache keeps it for each polydata, keyed
+// by the polydata and its modification time, so that all the
+// vtkFastMarchingGeodesicDistance filters working on the same surface
+// (directly, or through vtkFastMarchingGeodesicPath,
+// vtkPolygonalSurfaceContourLineInterpolator2 or the select by points tool)
+// build it only once.
+//
+// The meshes used least recently are removed when the total size exceeds
+// MaximumMemorySize. The mesh of a polydata is removed when the polydata is
+// deleted (the cache observes its DeleteEvent), or on the next lookup if it
+// was modified. A filter keeps using the mesh it got even if it is removed
+// from the cache.
+//
+// Filters may look up meshes from several threads at once, the cache is
+// locked. A polydata must not be deleted while a filter is looking up its
+// mesh, which holds as long as the filter holds its input, and the cache
+// adds a DeleteEvent observer to the polydata, so the polydata must not be
+// observed from another thread meanwhile.
+//
+// .SECTION See also
+// vtkFastMarchingGeodesicDistance
+
+#ifndef __vtkGeodesicMeshCache_h
+#define __vtkGeodesicMeshCache_h
+
+#include "vtkObject.h"
+
+class vtkPolyData;
+class vtkGeodesicMeshCacheInternals;
+namespace GW
+{
+class GW_CompactGeodesicMesh;
+}
+
+class VTK_EXPORT vtkGeodesicMeshCache : public vtkObject
+{
+public:
+
+  static vtkGeodesicMeshCache *New();
+
+  // Description:
+  // Standard methods for printing and determining type information.
+  vtkTypeMacro(vtkGeodesicMeshCache,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // The cache shared by all the geodesic filters.
+  static vtkGeodesicMeshCache *GetInstance();
+
+  // Description:
+  // Meshes are removed, least recently used first, when the total size of
+  // the cached meshes exceeds this size in bytes. 0 disables the cache.
+  // Default is 512 MB.
+  virtual void SetMaximumMemorySize( vtkTypeInt64 );
+  vtkGetMacro( MaximumMemorySize, vtkTypeInt64 );
+
+  // Description:
+  // Total size of the cached meshes, in bytes.
+  vtkTypeInt64 GetMemorySize();
+
+  // Description:
+  // Number of cached meshes.
+  int GetNumberOfMeshes();
+
+  // Description:
+  // Remove the mesh of a polydata, or all meshes, from the cache.
+  void RemoveMesh( vtkPolyData * );
+  void RemoveAllMeshes();
+
+protected:
+  vtkGeodesicMeshCache();
+  ~vtkGeodesicMeshCache();
+
+  //BTX
+  friend class vtkFastMarchingGeodesicDistance;
+  // Make the mesh use the geometry and adjacency of a polydata, taken from
+  // the cache or built and added to it. Returns 0 if the polydata is not a
+  // triangle mesh.
+  int SetupMesh( vtkPolyData *, GW::GW_CompactGeodesicMesh * );
+  //ETX
+
+  // Build the mesh from the polydata. Returns 0 if it is not a triangle mesh.
+  static int BuildMesh( vtkPolyData *, GW::GW_CompactGeodesicMesh * );
+
+  vtkGeodesicMeshCacheInternals * Internals;
+
+  vtkTypeInt64 MaximumMemorySize;
+
+private:
+  vtkGeodesicMeshCache(const vtkGeodesicMeshCache&);  // Not implemented.
+  void operator=(const vtkGeodesicMeshCache&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Paths traced on the compact fast marching mesh (GW_CompactGeodesicPath,
+// used by vtkFastMarchingGeodesicPath) have the same points as paths traced
+// by GW_GeodesicPath on the same mesh built as vertex and face objects, on
+// flat and curved grids, with holes and with several seeds. GW_GeodesicPath
+// prints a failed assertion when a step does not leave its face within 1000
+// iterations, the compact path continues from there in the same way.
+
+#include "GW_CompactGeodesicMesh.h"
+#include "GW_CompactGeodesicPath.h"
+#include "GW_GeodesicMesh.h"
+#include "GW_GeodesicPath.h"
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define CHECK_PATH(condition) \
+  if (!(condition)) \
+    { \
+    std::cerr << "Line " << __LINE__ << ": check failed: " << #condition << std::endl; \
+    return EXIT_FAILURE; \
+    }
+
+namespace
+{
+const int Rows = 30;
+const int Columns = 40;
+
+//----------------------------------------------------------------------------
+// Triangulated grid, with jittered points on a wave if curved, and some
+// faces removed if holes is set
+void GenerateGrid(bool curved, bool holes, unsigned int seed, GW::GW_CompactGeodesicMesh& mesh)
+{
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+  std::uniform_int_distribution<int> percent(0, 99);
+  mesh.SetNbrVertex((Rows + 1) * (Columns + 1));
+  for (int i = 0; i <= Rows; ++i)
+    {
+    for (int j = 0; j <= Columns; ++j)
+      {
+      double x = j + (curved ? jitter(random) : 0.0);
+      double y = i + (curved ? jitter(random) : 0.0);
+      double z = curved ? 3.0 * sin(x * 0.3) * cos(y * 0.2) : 0.0;
+      mesh.SetPosition(i * (Columns + 1) + j, x, y, z);
+      }
+    }
+  std::vector<int> triangles;
+  for (int i = 0; i < Rows; ++i)
+    {
+    for (int j = 0; j < Columns; ++j)
+      {
+      int p00 = i * (Columns + 1) + j, p01 = p00 + 1, p10 = p00 + Columns + 1, p11 = p10 + 1;
+      if (!holes || percent(random) >= 3)
+        {
+        triangles.insert(triangles.end(), { p00, p01, p11 });
+        }
+      triangles.insert(triangles.end(), { p00, p11, p10 });
+      }
+    }
+  const int faceCount = static_cast<int>(triangles.size() / 3);
+  mesh.SetNbrFace(faceCount);
+  for (int i = 0; i < faceCount; ++i)
+    {
+    mesh.SetFace(i, triangles[3 * i], triangles[3 * i + 1], triangles[3 * i + 2]);
+    }
+  mesh.BuildConnectivity(1);
+}
+
+//----------------------------------------------------------------------------
+bool SamePath(GW::GW_GeodesicPath& expected, const GW::GW_CompactGeodesicPath& path)
+{
+  const GW::T_GeodesicPointList& expectedPoints = expected.GetPointList();
+  const GW::GW_CompactGeodesicPath::T_PathPointVector& points = path.GetPointList();
+  if (expectedPoints.size() != points.size())
+    {
+    return false;
+    }
+  GW::CIT_GeodesicPointList it = expectedPoints.begin();
+  for (const GW::GW_CompactGeodesicPath::T_PathPoint& point : points)
+    {
+    GW::GW_GeodesicPoint* expectedPoint = *it++;
+    if (static_cast<int>(expectedPoint->GetVertex1()->GetID()) != point.nVert1
+      || static_cast<int>(expectedPoint->GetVertex2()->GetID()) != point.nVert2
+      || expectedPoint->GetCoord() != point.rCoord)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  const bool variants[3][2] = { { false, false }, { true, false }, { true, true } };
+  for (const bool* variant : variants)
+    {
+    GW::GW_CompactGeodesicMesh mesh;
+    GenerateGrid(variant[0], variant[1], 42, mesh);
+    const GW::GW_U32 vertexCount = mesh.GetNbrVertex();
+    for (int seeds = 1; seeds <= 2; ++seeds)
+      {
+      mesh.ResetGeodesicMesh();
+      mesh.AddStartVertex(vertexCount / 3);
+      if (seeds == 2)
+        {
+        mesh.AddStartVertex(vertexCount - 1);
+        }
+      mesh.PerformFastMarching();
+      GW::GW_GeodesicMesh objectMesh;
+      mesh.BuildGeodesicMesh(objectMesh);
+      mesh.CopyDistanceToGeodesicMesh(objectMesh);
+      size_t pointCount = 0;
+      for (GW::GW_U32 begin = 0; begin < vertexCount; begin += 17)
+        {
+        GW::GW_GeodesicPath expected;
+        expected.ComputePath(*static_cast<GW::GW_GeodesicVertex*>(objectMesh.GetVertex(begin)), 10000);
+        GW::GW_CompactGeodesicPath path;
+        path.ComputePath(mesh, begin, 10000);
+        CHECK_PATH(SamePath(expected, path));
+        pointCount += path.GetPointList().size();
+        }
+      std::cout << "curved " << variant[0] << ", holes " << variant[1] << ", " << seeds << " seeds: "
+        << pointCount << " path points" << std::endl;
+      CHECK_PATH(pointCount > 0);
+      }
+    }
+
+  // a begin vertex out of range gives an empty path
+  GW::GW_CompactGeodesicMesh mesh;
+  GenerateGrid(false, false, 42, mesh);
+  mesh.PerformFastMarching(0);
+  GW::GW_CompactGeodesicPath path;
+  path.ComputePath(mesh, mesh.GetNbrVertex());
+  CHECK_PATH(path.GetPointList().empty());
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Face connectivity of the fast marching meshes (GW_Mesh::ComputeFaceNeighbors
+// and GW_Mesh::BuildConnectivity): on meshes with holes, edges shared by more
+// than two faces and duplicate faces, the neighbors are the same as those
+// found by intersecting the face lists of the edge vertices, as
+// BuildConnectivity did before the half edges were matched, with and
+// without threads. Degenerate edges have no neighbor.
+
+#include "GW_GeodesicMesh.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define CHECK_NEIGHBORS(condition) \
+  if (!(condition)) \
+    { \
+    std::cerr << "Line " << __LINE__ << ": check failed: " << #condition << std::endl; \
+    return EXIT_FAILURE; \
+    }
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Triangulated grid of rows x columns squares with some faces removed, and
+// fins: extra faces on some edges, so that up to four faces share an edge,
+// and duplicates of some faces in either orientation
+void GenerateNonManifoldMesh(int rows, int columns, unsigned int seed,
+  int& vertexCount, std::vector<int>& triangles)
+{
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<int> percent(0, 99);
+  vertexCount = (rows + 1) * (columns + 1);
+  triangles.clear();
+  auto addFace = [&triangles](int a, int b, int c)
+    {
+    triangles.push_back(a);
+    triangles.push_back(b);
+    triangles.push_back(c);
+    };
+  for (int i = 0; i < rows; ++i)
+    {
+    for (int j = 0; j < columns; ++j)
+      {
+      int p00 = i * (columns + 1) + j, p01 = p00 + 1, p10 = p00 + columns + 1, p11 = p10 + 1;
+      const int faces[2][3] = { { p00, p01, p11 }, { p00, p11, p10 } };
+      for (const int* face : faces)
+        {
+        int roll = percent(random);
+        if (roll < 5)
+          {
+          // hole
+          continue;
+          }
+        addFace(face[0], face[1], face[2]);
+        if (roll < 10)
+          {
+          // duplicate
+          addFace(face[0], face[2], face[1]);
+          }
+        else if (roll < 20)
+          {
+          // one or two fins on the first edge
+          for (int fin = 0; fin < 1 + roll % 2; ++fin)
+            {
+            addFace(face[1], face[0], vertexCount++);
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Neighbors found by intersecting the lists of faces around the vertices of
+// each edge, including the update of the neighbor of the neighbor, as
+// GW_Mesh::BuildConnectivity did before ComputeFaceNeighbors
+void ComputeFaceNeighborsByIntersection(const std::vector<int>& triangles, int vertexCount,
+  std::vector<int>& neighbors)
+{
+  const int faceCount = static_cast<int>(triangles.size() / 3);
+  std::vector<std::vector<int> > vertexFaces(vertexCount);
+  for (int face = 0; face < faceCount; ++face)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      vertexFaces[triangles[3 * face + i]].push_back(face);
+      }
+    }
+  neighbors.assign(triangles.size(), -1);
+  for (int face = 0; face < faceCount; ++face)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      int vertex1 = triangles[3 * face + (i + 1) % 3];
+      int vertex2 = triangles[3 * face + (i + 2) % 3];
+      int neighbor = -1;
+      for (int face1 : vertexFaces[vertex1])
+        {
+        for (int face2 : vertexFaces[vertex2])
+          {
+          if (face1 == face2 && face1 != face && neighbor < 0)
+            {
+            neighbor = face1;
+            }
+          }
+        }
+      neighbors[3 * face + i] = neighbor;
+      if (neighbor < 0)
+        {
+        continue;
+        }
+      // same as GW_Face::GetEdgeNumber(vertex1, vertex2)
+      const int* neighborVertices = &triangles[3 * neighbor];
+      for (int j = 0; j < 3; ++j)
+        {
+        if (neighborVertices[j] == vertex1)
+          {
+          if (neighborVertices[(j + 1) % 3] == vertex2)
+            {
+            neighbors[3 * neighbor + (j + 2) % 3] = face;
+            break;
+            }
+          if (neighborVertices[(j + 2) % 3] == vertex2)
+            {
+            neighbors[3 * neighbor + (j + 1) % 3] = face;
+            break;
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+std::vector<int> ComputeFaceNeighbors(const std::vector<int>& triangles, int vertexCount,
+  unsigned int threadCount)
+{
+  std::vector<int> neighbors(triangles.size());
+  GW::GW_Mesh::ComputeFaceNeighbors(triangles.data(), static_cast<GW::GW_U32>(triangles.size() / 3),
+    vertexCount, neighbors.data(), threadCount);
+  return neighbors;
+}
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  // small mesh, and a mesh large enough to be split between threads
+  const int sizes[2][2] = { { 20, 30 }, { 480, 480 } };
+  for (const int* size : sizes)
+    {
+    int vertexCount = 0;
+    std::vector<int> triangles;
+    GenerateNonManifoldMesh(size[0], size[1], 42, vertexCount, triangles);
+    std::vector<int> expected;
+    ComputeFaceNeighborsByIntersection(triangles, vertexCount, expected);
+    int borders = 0;
+    for (int neighbor : expected)
+      {
+      borders += neighbor < 0 ? 1 : 0;
+      }
+    std::cout << triangles.size() / 3 << " faces, " << borders << " border edges" << std::endl;
+    CHECK_NEIGHBORS(borders > 0);
+    for (unsigned int threadCount : { 1u, 4u })
+      {
+      CHECK_NEIGHBORS(ComputeFaceNeighbors(triangles, vertexCount, threadCount) == expected);
+      }
+    }
+
+  // faces of a GW mesh
+  int vertexCount = 0;
+  std::vector<int> triangles;
+  GenerateNonManifoldMesh(10, 10, 7, vertexCount, triangles);
+  std::vector<int> expected;
+  ComputeFaceNeighborsByIntersection(triangles, vertexCount, expected);
+  GW::GW_GeodesicMesh mesh;
+  mesh.SetNbrVertex(vertexCount);
+  for (int i = 0; i < vertexCount; ++i)
+    {
+    GW::GW_Vertex& point = mesh.CreateNewVertex();
+    point.SetPosition(GW::GW_Vector3D(i % 11, i / 11, 0));
+    mesh.SetVertex(i, &point);
+    }
+  const int faceCount = static_cast<int>(triangles.size() / 3);
+  mesh.SetNbrFace(faceCount);
+  for (int i = 0; i < faceCount; ++i)
+    {
+    GW::GW_Face& face = mesh.CreateNewFace();
+    face.SetVertex(*mesh.GetVertex(triangles[3 * i]), *mesh.GetVertex(triangles[3 * i + 1]),
+      *mesh.GetVertex(triangles[3 * i + 2]));
+    mesh.SetFace(i, &face);
+    }
+  mesh.BuildConnectivity();
+  for (int i = 0; i < faceCount; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      int neighbor = expected[3 * i + j];
+      CHECK_NEIGHBORS(mesh.GetFace(i)->GetFaceNeighbor(j) == (neighbor >= 0 ? mesh.GetFace(neighbor) : NULL));
+      }
+    }
+
+  // the degenerate face shares the edge of two faces, its degenerate edge
+  // has no neighbor
+  const std::vector<int> degenerate = { 0, 1, 2, 1, 0, 3, 0, 0, 1 };
+  std::vector<int> neighbors = ComputeFaceNeighbors(degenerate, 4, 1);
+  CHECK_NEIGHBORS(neighbors[2] == 2 && neighbors[5] == 0);
+  CHECK_NEIGHBORS(neighbors[6] == 0 && neighbors[7] == 0 && neighbors[8] == -1);
+
+  return EXIT_SUCCESS;
+}
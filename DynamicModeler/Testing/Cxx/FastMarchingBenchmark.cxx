@@ -0,0 +1,298 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Benchmark of the fast marching geodesic distance computation
+// (GW_GeodesicMesh and GW_CompactGeodesicMesh, used by
+// vtkFastMarchingGeodesicDistance).
+//
+// A bumpy terrain with the requested number of vertices is generated and the
+// distance from its center to all other vertices is computed with each mesh
+// and narrow band implementation: the object mesh with the multimap and with
+// the indexed heap, and the compact mesh. For each run the time of building
+// the mesh connectivity and of the marching, marched vertices per second, the
+// memory used by the mesh, the largest distance, and the largest difference
+// from the distances of the first implementation are written as CSV. The
+// memory of the object mesh is the size of its vertex and face objects and
+// pointer arrays, without the allocation overhead. The exit code is nonzero
+// if the distances of the implementations differ.
+//
+// Usage: FastMarchingBenchmark [options]
+//   --sizes 100000,1000000  vertex counts (default 100K, 1M, 2M)
+//   --repeat 3              number of marchings per mesh and implementation,
+//                           the fastest one is reported (default 3)
+//   --output results.csv    output file (default standard output)
+
+#include "GW_CompactGeodesicMesh.h"
+#include "GW_GeodesicMesh.h"
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//----------------------------------------------------------------------------
+// Bumpy terrain with about vertexCount vertices: a square lattice of
+// equilateral triangles (every other row shifted by half an edge), so that
+// the marching time is not dominated by the unfolding of obtuse triangles
+void GenerateMesh(int vertexCount, std::vector<double>& points, std::vector<int>& triangles)
+{
+  int columns = std::max(3, static_cast<int>(std::sqrt(static_cast<double>(vertexCount))));
+  int rows = columns;
+  const double rowHeight = std::sqrt(3.0) / 2.0;
+  points.clear();
+  for (int i = 0; i < rows; ++i)
+    {
+    for (int j = 0; j < columns; ++j)
+      {
+      double x = j + 0.5 * (i % 2);
+      double y = i * rowHeight;
+      double z = 2.0 * std::sin(0.05 * x) * std::cos(0.07 * y) + 0.5 * std::sin(0.31 * x + 0.17 * y);
+      points.push_back(x);
+      points.push_back(y);
+      points.push_back(z);
+      }
+    }
+  triangles.clear();
+  auto addFace = [&triangles](int a, int b, int c)
+    {
+    triangles.push_back(a);
+    triangles.push_back(b);
+    triangles.push_back(c);
+    };
+  for (int i = 0; i < rows - 1; ++i)
+    {
+    for (int j = 0; j < columns - 1; ++j)
+      {
+      int p00 = i * columns + j, p01 = p00 + 1, p10 = p00 + columns, p11 = p10 + 1;
+      if (i % 2 == 0)
+        {
+        addFace(p00, p01, p10);
+        addFace(p01, p11, p10);
+        }
+      else
+        {
+        addFace(p00, p11, p10);
+        addFace(p00, p01, p11);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void BuildGeodesicMesh(const std::vector<double>& points, const std::vector<int>& triangles,
+  GW::GW_GeodesicMesh& mesh)
+{
+  int vertexCount = static_cast<int>(points.size() / 3);
+  mesh.SetNbrVertex(vertexCount);
+  for (int i = 0; i < vertexCount; ++i)
+    {
+    GW::GW_GeodesicVertex& point = (GW::GW_GeodesicVertex&)mesh.CreateNewVertex();
+    point.SetPosition(GW::GW_Vector3D(points[3 * i], points[3 * i + 1], points[3 * i + 2]));
+    mesh.SetVertex(i, &point);
+    }
+  int faceCount = static_cast<int>(triangles.size() / 3);
+  mesh.SetNbrFace(faceCount);
+  for (int i = 0; i < faceCount; ++i)
+    {
+    GW::GW_GeodesicFace& face = (GW::GW_GeodesicFace&)mesh.CreateNewFace();
+    face.SetVertex(*mesh.GetVertex(triangles[3 * i]), *mesh.GetVertex(triangles[3 * i + 1]),
+      *mesh.GetVertex(triangles[3 * i + 2]));
+    mesh.SetFace(i, &face);
+    }
+}
+
+//----------------------------------------------------------------------------
+void BuildCompactGeodesicMesh(const std::vector<double>& points, const std::vector<int>& triangles,
+  GW::GW_CompactGeodesicMesh& mesh)
+{
+  int vertexCount = static_cast<int>(points.size() / 3);
+  mesh.SetNbrVertex(vertexCount);
+  for (int i = 0; i < vertexCount; ++i)
+    {
+    mesh.SetPosition(i, points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+    }
+  int faceCount = static_cast<int>(triangles.size() / 3);
+  mesh.SetNbrFace(faceCount);
+  for (int i = 0; i < faceCount; ++i)
+    {
+    mesh.SetFace(i, triangles[3 * i], triangles[3 * i + 1], triangles[3 * i + 2]);
+    }
+}
+
+//----------------------------------------------------------------------------
+template<class T>
+bool ParseList(const std::string& text, std::vector<T>& values)
+{
+  values.clear();
+  std::istringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    {
+    std::istringstream itemStream(item);
+    T value;
+    if (!(itemStream >> value))
+      {
+      return false;
+      }
+    values.push_back(value);
+    }
+  return !values.empty();
+}
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  std::vector<int> sizes = { 100000, 1000000, 2000000 };
+  int repeat = 3;
+  std::string outputFileName;
+  for (int i = 1; i < argc; ++i)
+    {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    bool valid = true;
+    if (arg == "--sizes" && hasValue)
+      {
+      valid = ParseList(argv[++i], sizes);
+      }
+    else if (arg == "--repeat" && hasValue)
+      {
+      repeat = atoi(argv[++i]);
+      valid = repeat > 0;
+      }
+    else if (arg == "--output" && hasValue)
+      {
+      outputFileName = argv[++i];
+      }
+    else
+      {
+      valid = false;
+      }
+    if (!valid)
+      {
+      std::cerr << "Invalid argument: " << arg << std::endl;
+      std::cerr << "Usage: " << argv[0] << " [--sizes n,...] [--repeat n] [--output file]" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::ofstream outputFile;
+  if (!outputFileName.empty())
+    {
+    outputFile.open(outputFileName.c_str());
+    if (!outputFile)
+      {
+      std::cerr << "Failed to open output file: " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::ostream& os = outputFileName.empty() ? std::cout : outputFile;
+  os << "vertices,mesh,build_seconds,seconds,vertices_per_second,memory_bytes,max_distance,max_difference\n";
+
+  const char* meshNames[] = { "multimap", "heap", "compact" };
+  bool sameDistances = true;
+  for (int size : sizes)
+    {
+    std::vector<double> points;
+    std::vector<int> triangles;
+    GenerateMesh(size, points, triangles);
+    int vertexCount = static_cast<int>(points.size() / 3);
+    int faceCount = static_cast<int>(triangles.size() / 3);
+
+    std::vector<double> reference;
+    for (int meshType = 0; meshType < 3; ++meshType)
+      {
+      GW::GW_GeodesicMesh mesh;
+      GW::GW_CompactGeodesicMesh compactMesh;
+      double buildSeconds = 0.0;
+      size_t memorySize = 0;
+      auto startTime = std::chrono::steady_clock::now();
+      if (meshType < 2)
+        {
+        BuildGeodesicMesh(points, triangles, mesh);
+        startTime = std::chrono::steady_clock::now();
+        mesh.BuildConnectivity();
+        buildSeconds = Seconds(startTime);
+        mesh.SetUseHeapNarrowBand(meshType == 1);
+        memorySize = sizeof(mesh) + vertexCount * (sizeof(GW::GW_GeodesicVertex) + sizeof(GW::GW_Vertex*))
+          + faceCount * (sizeof(GW::GW_GeodesicFace) + sizeof(GW::GW_Face*));
+        }
+      else
+        {
+        BuildCompactGeodesicMesh(points, triangles, compactMesh);
+        startTime = std::chrono::steady_clock::now();
+        compactMesh.BuildConnectivity();
+        buildSeconds = Seconds(startTime);
+        memorySize = compactMesh.GetMemorySize();
+        }
+
+      double seconds = 0.0;
+      for (int run = 0; run < repeat; ++run)
+        {
+        if (meshType < 2)
+          {
+          mesh.ResetGeodesicMesh();
+          startTime = std::chrono::steady_clock::now();
+          mesh.PerformFastMarching((GW::GW_GeodesicVertex*)mesh.GetVertex(vertexCount / 2));
+          }
+        else
+          {
+          compactMesh.ResetGeodesicMesh();
+          startTime = std::chrono::steady_clock::now();
+          compactMesh.PerformFastMarching(vertexCount / 2);
+          }
+        double runSeconds = Seconds(startTime);
+        seconds = run == 0 ? runSeconds : std::min(seconds, runSeconds);
+        }
+      double maxDistance = 0.0;
+      double maxDifference = 0.0;
+      for (int i = 0; i < vertexCount; ++i)
+        {
+        double distance = meshType < 2 ? ((GW::GW_GeodesicVertex*)mesh.GetVertex(i))->GetDistance()
+          : compactMesh.GetDistance(i);
+        maxDistance = std::max(maxDistance, distance);
+        if (reference.size() < static_cast<size_t>(vertexCount))
+          {
+          reference.push_back(distance);
+          }
+        maxDifference = std::max(maxDifference, std::fabs(distance - reference[i]));
+        }
+      os << vertexCount << "," << meshNames[meshType] << "," << buildSeconds << "," << seconds << ","
+        << vertexCount / seconds << "," << memorySize << "," << maxDistance << "," << maxDifference << "\n";
+      os.flush();
+      if (maxDifference > 1e-9 * maxDistance)
+        {
+        std::cerr << meshNames[meshType] << " distances differ from " << meshNames[0]
+          << " by up to " << maxDifference << " on " << vertexCount << " vertices" << std::endl;
+        sameDistances = false;
+        }
+      }
+    }
+  return sameDistances ? EXIT_SUCCESS : EXIT_FAILURE;
+}
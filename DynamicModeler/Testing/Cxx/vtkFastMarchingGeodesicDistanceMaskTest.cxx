@@ -0,0 +1,172 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Exclusion region and destination vertices of vtkFastMarchingGeodesicDistance
+// given as masks (SetExclusionPointMask, SetDestinationVertexStopMask) give
+// the same distances as the same vertices given as id lists, or split between
+// a list and a mask. Out of range ids and masks of the wrong size are
+// ignored.
+
+#include "vtkFastMarchingGeodesicDistance.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkPlaneSource.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTriangleFilter.h>
+#include <vtkUnsignedCharArray.h>
+
+// STD includes
+#include <vector>
+
+namespace
+{
+const int Resolution = 40;
+const char* DistanceArrayName = "Distance";
+
+//----------------------------------------------------------------------------
+vtkIdType PointId(int i, int j)
+{
+  return j * (Resolution + 1) + i;
+}
+
+//----------------------------------------------------------------------------
+struct MarchingResult
+{
+  std::vector<float> Distances;
+  vtkIdType NumberOfVisitedPoints;
+  float MaximumDistance;
+};
+
+//----------------------------------------------------------------------------
+MarchingResult March(vtkPolyData* surface, vtkIdList* exclusionIds, vtkDataArray* exclusionMask,
+  vtkIdList* destinationIds, vtkDataArray* destinationMask)
+{
+  vtkNew<vtkIdList> seeds;
+  seeds->InsertNextId(PointId(0, 0));
+  vtkNew<vtkFastMarchingGeodesicDistance> geodesic;
+  geodesic->SetInputData(surface);
+  geodesic->SetFieldDataName(DistanceArrayName);
+  geodesic->SetSeeds(seeds);
+  geodesic->SetExclusionPointIds(exclusionIds);
+  geodesic->SetExclusionPointMask(exclusionMask);
+  geodesic->SetDestinationVertexStopCriterion(destinationIds);
+  geodesic->SetDestinationVertexStopMask(destinationMask);
+  geodesic->Update();
+
+  MarchingResult result;
+  vtkFloatArray* distances = vtkFloatArray::SafeDownCast(
+    geodesic->GetOutput()->GetPointData()->GetArray(DistanceArrayName));
+  for (vtkIdType i = 0; distances && i < distances->GetNumberOfTuples(); ++i)
+    {
+    result.Distances.push_back(distances->GetValue(i));
+    }
+  result.NumberOfVisitedPoints = geodesic->GetNumberOfVisitedPoints();
+  result.MaximumDistance = geodesic->GetMaximumDistance();
+  return result;
+}
+
+//----------------------------------------------------------------------------
+bool Equal(const MarchingResult& a, const MarchingResult& b)
+{
+  return a.Distances == b.Distances && a.NumberOfVisitedPoints == b.NumberOfVisitedPoints
+    && a.MaximumDistance == b.MaximumDistance;
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkFastMarchingGeodesicDistanceMaskTest(int, char*[])
+{
+  vtkNew<vtkPlaneSource> plane;
+  plane->SetOrigin(0.0, 0.0, 0.0);
+  plane->SetPoint1(Resolution, 0.0, 0.0);
+  plane->SetPoint2(0.0, Resolution, 0.0);
+  plane->SetResolution(Resolution, Resolution);
+  vtkNew<vtkTriangleFilter> triangulate;
+  triangulate->SetInputConnection(plane->GetOutputPort());
+  triangulate->Update();
+  vtkPolyData* surface = triangulate->GetOutput();
+  const vtkIdType numberOfPoints = surface->GetNumberOfPoints();
+  CHECK_INT(numberOfPoints, (Resolution + 1) * (Resolution + 1));
+
+  // A wall across the plane with a gap at the end, as a list, as a mask, and
+  // split between the two
+  vtkNew<vtkIdList> wallIds;
+  vtkNew<vtkIdList> wallHalfIds;
+  vtkNew<vtkUnsignedCharArray> wallMask;
+  vtkNew<vtkUnsignedCharArray> wallHalfMask;
+  wallMask->SetNumberOfValues(numberOfPoints);
+  wallMask->Fill(0);
+  wallHalfMask->SetNumberOfValues(numberOfPoints);
+  wallHalfMask->Fill(0);
+  for (int j = 0; j < Resolution - 5; ++j)
+    {
+    vtkIdType id = PointId(Resolution / 2, j);
+    wallIds->InsertNextId(id);
+    wallMask->SetValue(id, 1);
+    if (j % 2)
+      {
+      wallHalfIds->InsertNextId(id);
+      }
+    else
+      {
+      wallHalfMask->SetValue(id, 1);
+      }
+    }
+
+  // Destination vertices beyond the wall
+  vtkNew<vtkIdList> destinationIds;
+  vtkNew<vtkUnsignedCharArray> destinationMask;
+  destinationMask->SetNumberOfValues(numberOfPoints);
+  destinationMask->Fill(0);
+  for (int i = Resolution - 3; i <= Resolution; ++i)
+    {
+    destinationIds->InsertNextId(PointId(i, 0));
+    destinationMask->SetValue(PointId(i, 0), 1);
+    }
+
+  // The wall stops the front, which goes around it
+  MarchingResult unrestricted = March(surface, nullptr, nullptr, nullptr, nullptr);
+  CHECK_INT(unrestricted.NumberOfVisitedPoints, numberOfPoints);
+  MarchingResult excludedByIds = March(surface, wallIds, nullptr, nullptr, nullptr);
+  CHECK_INT(excludedByIds.NumberOfVisitedPoints, numberOfPoints - wallIds->GetNumberOfIds());
+  CHECK_BOOL(excludedByIds.Distances[PointId(Resolution, 0)] > 1.5 * unrestricted.Distances[PointId(Resolution, 0)]);
+  CHECK_BOOL(Equal(March(surface, nullptr, wallMask, nullptr, nullptr), excludedByIds));
+  CHECK_BOOL(Equal(March(surface, wallHalfIds, wallHalfMask, nullptr, nullptr), excludedByIds));
+
+  // The front stops at the first destination reached
+  MarchingResult stoppedByIds = March(surface, wallIds, nullptr, destinationIds, nullptr);
+  CHECK_BOOL(stoppedByIds.NumberOfVisitedPoints < excludedByIds.NumberOfVisitedPoints);
+  CHECK_BOOL(Equal(March(surface, wallIds, nullptr, nullptr, destinationMask), stoppedByIds));
+  CHECK_BOOL(Equal(March(surface, nullptr, wallMask, nullptr, destinationMask), stoppedByIds));
+
+  // Out of range ids and masks with another number of points are ignored
+  vtkNew<vtkIdList> outOfRangeIds;
+  outOfRangeIds->InsertNextId(-1);
+  outOfRangeIds->InsertNextId(numberOfPoints);
+  vtkNew<vtkUnsignedCharArray> shortMask;
+  shortMask->SetNumberOfValues(numberOfPoints - 1);
+  shortMask->Fill(1);
+  CHECK_BOOL(Equal(March(surface, outOfRangeIds, shortMask, outOfRangeIds, shortMask), unrestricted));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Fast marching filters on the same polydata share one vtkGeodesicMeshCache
+// entry. The mesh is rebuilt when the polydata is modified, the least
+// recently used mesh is removed when the cache exceeds MaximumMemorySize, and
+// the mesh of a polydata is removed when the polydata is deleted.
+
+#include "vtkFastMarchingGeodesicDistance.h"
+#include "vtkGeodesicMeshCache.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> CreateSphere(int resolution)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetThetaResolution(resolution);
+  sphere->SetPhiResolution(resolution);
+  sphere->Update();
+  vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+  surface->DeepCopy(sphere->GetOutput());
+  return surface;
+}
+
+//----------------------------------------------------------------------------
+// Marching from the first point, which looks up the mesh of the surface in
+// the cache if the filter has not set it up from this surface yet
+vtkSmartPointer<vtkFastMarchingGeodesicDistance> March(vtkPolyData* surface)
+{
+  vtkNew<vtkIdList> seeds;
+  seeds->InsertNextId(0);
+  vtkSmartPointer<vtkFastMarchingGeodesicDistance> geodesic =
+    vtkSmartPointer<vtkFastMarchingGeodesicDistance>::New();
+  geodesic->SetInputData(surface);
+  geodesic->SetFieldDataName("Distance");
+  geodesic->SetSeeds(seeds);
+  geodesic->Update();
+  return geodesic;
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkGeodesicMeshCacheTest(int, char*[])
+{
+  vtkGeodesicMeshCache* cache = vtkGeodesicMeshCache::GetInstance();
+  const vtkTypeInt64 defaultMaximumMemorySize = cache->GetMaximumMemorySize();
+  cache->RemoveAllMeshes();
+  CHECK_INT(cache->GetNumberOfMeshes(), 0);
+
+  // Two filters on one polydata share its mesh
+  vtkSmartPointer<vtkPolyData> small = CreateSphere(20);
+  vtkSmartPointer<vtkFastMarchingGeodesicDistance> first = March(small);
+  CHECK_INT(cache->GetNumberOfMeshes(), 1);
+  const vtkTypeInt64 smallSize = cache->GetMemorySize();
+  CHECK_BOOL(smallSize > 0);
+  vtkSmartPointer<vtkFastMarchingGeodesicDistance> second = March(small);
+  CHECK_INT(cache->GetNumberOfMeshes(), 1);
+  CHECK_BOOL(cache->GetMemorySize() == smallSize);
+  const double distance = first->GetMaximumDistance();
+  CHECK_BOOL(distance > 0.0);
+  CHECK_BOOL(second->GetMaximumDistance() == distance);
+
+  // Modified() makes the next marching rebuild the mesh from the new points,
+  // which are scaled twice
+  vtkPoints* points = small->GetPoints();
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+    double point[3];
+    points->GetPoint(i, point);
+    points->SetPoint(i, 2.0 * point[0], 2.0 * point[1], 2.0 * point[2]);
+    }
+  small->Modified();
+  first->Update();
+  CHECK_BOOL(std::fabs(first->GetMaximumDistance() - 2.0 * distance) < 1e-3 * distance);
+  CHECK_INT(cache->GetNumberOfMeshes(), 1);
+  CHECK_BOOL(cache->GetMemorySize() == smallSize);
+
+  // When the cache gets too small, the least recently used mesh is removed:
+  // the large sphere, as the small one is looked up again by a new filter
+  vtkSmartPointer<vtkPolyData> large = CreateSphere(40);
+  vtkSmartPointer<vtkFastMarchingGeodesicDistance> third = March(large);
+  CHECK_INT(cache->GetNumberOfMeshes(), 2);
+  const vtkTypeInt64 largeSize = cache->GetMemorySize() - smallSize;
+  CHECK_BOOL(largeSize > smallSize);
+  vtkSmartPointer<vtkFastMarchingGeodesicDistance> fourth = March(small);
+  CHECK_INT(cache->GetNumberOfMeshes(), 2);
+  cache->SetMaximumMemorySize(largeSize);
+  CHECK_INT(cache->GetNumberOfMeshes(), 1);
+  CHECK_BOOL(cache->GetMemorySize() == smallSize);
+  // the filter keeps its mesh
+  third->Modified();
+  third->Update();
+  CHECK_BOOL(third->GetMaximumDistance() > 0.0);
+  CHECK_INT(cache->GetNumberOfMeshes(), 1);
+  cache->SetMaximumMemorySize(defaultMaximumMemorySize);
+
+  // Deleting a polydata removes its mesh
+  vtkSmartPointer<vtkFastMarchingGeodesicDistance> fifth = March(large);
+  CHECK_INT(cache->GetNumberOfMeshes(), 2);
+  third = nullptr;
+  fifth = nullptr;
+  large = nullptr;
+  CHECK_INT(cache->GetNumberOfMeshes(), 1);
+  CHECK_BOOL(cache->GetMemorySize() == smallSize);
+
+  cache->RemoveAllMeshes();
+  CHECK_INT(cache->GetNumberOfMeshes(), 0);
+  CHECK_BOOL(cache->GetMemorySize() == 0);
+
+  return EXIT_SUCCESS;
+}
@@ -429,9 +429,7 @@ class SurfaceToolboxLogic(ScriptedLoadableModuleLogic):
 
     :param reductionFactor: Target reduction factor during decimation. Ratio of triangles that are requested to
       be eliminated. 0.8 means that the mesh size is requested to be reduced by 80%.
-    :param decimateBoundary: If enabled then 'FastQuadric' method is used (it provides more even element sizes but cannot
-      be forced to preserve boundary), otherwise 'DecimatePro' method is used (that can preserve boundary edges but tend
-      to create more ill-shaped triangles).
+    :param decimateBoundary: If disabled then vertices on the boundary of open surfaces are kept unchanged.
     :param lossless: Lossless remeshing for FastQuadric method. The flag has no effect if other method is used.
     :param aggressiveness: Balances between accuracy and computation time for FastQuadric method (default = 7.0). The flag has no effect if other method is used.
     """
@@ -439,8 +437,10 @@ class SurfaceToolboxLogic(ScriptedLoadableModuleLogic):
       "inputModel": inputModel,
       "outputModel": outputModel,
       "reductionFactor": reductionFactor,
-      "method": "FastQuadric" if decimateBoundary else "DecimatePro",
-      "boundaryDeletion": decimateBoundary
+      "method": "FastQuadric",
+      "boundaryDeletion": decimateBoundary,
+      "lossless": lossless,
+      "aggressiveness": aggressiveness
       }
     cliNode = slicer.cli.runSync(slicer.modules.decimation, None, parameters)
     slicer.mrmlScene.RemoveNode(cliNode)